@@ -225,9 +225,15 @@ namespace SensorUnits.TimingUnit
                 if (packet.DataLength >= 5)
                 {
                     var reader = new BinaryReader(new MemoryStream(packet.Data));
-                    UInt32 micros = reader.ReadUInt32();
+                    long micros = reader.ReadUInt32();
                     byte gateId = reader.ReadByte();
 
+                    // Newer firmware appends the full 64 bit timestamp, the 32 bit one wraps after 71 minutes.
+                    if (packet.DataLength >= 13)
+                    {
+                        micros = (long)reader.ReadUInt64();
+                    }
+
                     if ((int)gateId != StartId && gateId != EndId)
                     {
                         throw new ArgumentException($"Timing sensor reported gate id: {gateId}, expeted either {StartId} or {EndId}");
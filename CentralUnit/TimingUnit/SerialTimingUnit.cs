@@ -210,9 +210,15 @@ namespace TimingUnit
                 if (packet.DataLength >= 5)
                 {
                     var reader = new BinaryReader(new MemoryStream(packet.Data));
-                    UInt32 micros = reader.ReadUInt32();
+                    long micros = reader.ReadUInt32();
                     byte gateId = reader.ReadByte();
 
+                    // Newer firmware appends the full 64 bit timestamp, the 32 bit one wraps after 71 minutes.
+                    if (packet.DataLength >= 13)
+                    {
+                        micros = (long)reader.ReadUInt64();
+                    }
+
                     this.timingEvents.Enqueue(new TimingTriggeredEventArgs(micros, gateId));
                 }
             }
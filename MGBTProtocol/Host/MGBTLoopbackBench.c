@@ -0,0 +1,459 @@
+/*
+ * MGBTLoopbackBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Runs the MGBT protocol on the Linux port against a central played by this
+ *  program. The device echoes every command from its own thread, on one end
+ *  of a socket pair or of a pty. The central keeps a number of commands in
+ *  flight, checks every echo and reports round trip times and throughput.
+ *  Exits with an error when an echo is missing or differs from its command.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "MGBTCommProto.h"
+#include "MGBTCrc.h"
+#include "MGBTCobs.h"
+#include "MGBTPortLinux.h"
+
+#define RXHEADERLENGTH 9U
+#define TXHEADERLENGTH MGBTFRAMEHEADERLENGTH
+#define MAXWINDOW 16U
+//Sequence numbers run from 1, 0 is left for untagged frames.
+#define SEQUENCECOUNT 255U
+#define RESPONSETIMEOUTMS 2000
+#define DEVICEIDLEWAITMS 1U
+
+typedef struct
+{
+    uint32_t count;
+    uint16_t size;
+    uint8_t window;
+    uint8_t framing;
+    uint8_t usePty;
+} BenchConfig;
+
+static BenchConfig config =
+{
+    1000U,
+    128U,
+    1U,
+    MGBTFramingV2,
+    0U
+};
+
+static volatile uint8_t deviceStop = 0U;
+static int centralFd = -1;
+static uint64_t* sendTimes;
+static uint64_t* latencies;
+//Response being collected by the central.
+static uint8_t encodedResponse[MGBTV2FRAMEMAXLENGTH];
+static uint16_t encodedPosition = 0U;
+static uint8_t collectingV2 = 0U;
+static uint8_t response[TXHEADERLENGTH + MGBTV2DATAMAXSIZE];
+static uint16_t responsePosition = 0U;
+static uint32_t received = 0U;
+static uint32_t failures = 0U;
+
+static uint64_t GetTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+}
+
+static uint16_t GetWord(const uint8_t* frame, uint16_t offset)
+{
+    return (uint16_t)(frame[offset] | (frame[offset + 1U] << 8));
+}
+
+static uint8_t GetPayloadByte(uint32_t command, uint16_t index)
+{
+    return (uint8_t)((command * 31U) + (index * 7U) + 1U);
+}
+
+//Echoes every command, the way a device manager answers them.
+static void* RunDevice(void* argument)
+{
+    (void)argument;
+    InitCommProto();
+    while(deviceStop == 0U)
+    {
+        uint8_t handled = 0U;
+        RunCommProto();
+        while((CommandAvailable() != 0U) &&
+              (CanSendResponse() != 0U))
+        {
+            MGBTCommandView* command = GetAndClearCommand();
+            if(BeginCommandResponse(command, 0U) == 1U)
+            {
+                AddResponseCommandData(command);
+                FinishResponse();
+            }
+            handled = 1U;
+        }
+        if(handled == 0U)
+        {
+            MGBTPortLinuxWait(DEVICEIDLEWAITMS);
+        }
+    }
+
+    return (void*)0;
+}
+
+static void WriteAll(const uint8_t* data, uint16_t length)
+{
+    uint16_t written = 0U;
+    while(written < length)
+    {
+        ssize_t writeResult = write(centralFd, &data[written], length - written);
+        if(writeResult > 0)
+        {
+            written += (uint16_t)writeResult;
+        }
+        else if((writeResult < 0) && (errno != EINTR) && (errno != EAGAIN))
+        {
+            written = length;
+            failures++;
+        }
+    }
+}
+
+static void SendCommand(uint32_t command)
+{
+    static uint8_t frame[RXHEADERLENGTH + MGBTV2DATAMAXSIZE];
+    static uint8_t encoded[MGBTV2FRAMEMAXLENGTH];
+    uint16_t cmdType = (uint16_t)(NoOperation | (((command % SEQUENCECOUNT) + 1U) << MGBTSEQUENCESHIFT));
+    uint16_t crc;
+    uint16_t index;
+
+    //v1 layout, a v2 frame is the same without its header byte.
+    frame[0] = 0xFFU;
+    frame[1] = (uint8_t)(config.size & 0xFFU);
+    frame[2] = (uint8_t)(config.size >> 8);
+    frame[5] = 0U;
+    frame[6] = 0U;
+    frame[7] = (uint8_t)(cmdType & 0xFFU);
+    frame[8] = (uint8_t)(cmdType >> 8);
+    for(index = 0U; index < config.size; index++)
+    {
+        frame[RXHEADERLENGTH + index] = GetPayloadByte(command, index);
+    }
+    crc = MGBTCrcCalculate(&frame[5], (uint16_t)(config.size + 4U));
+    frame[3] = (uint8_t)(crc & 0xFFU);
+    frame[4] = (uint8_t)(crc >> 8);
+
+    sendTimes[command] = GetTimeNs();
+    if(config.framing == MGBTFramingV1)
+    {
+        WriteAll(frame, (uint16_t)(RXHEADERLENGTH + config.size));
+    }
+    else
+    {
+        uint16_t frameLength = (uint16_t)(TXHEADERLENGTH + config.size);
+        uint16_t encodedLength = 1U;
+        uint16_t position = 0U;
+
+        encoded[0] = MGBTCOBS_DELIMITER;
+        while(position <= frameLength)
+        {
+            uint16_t consumed;
+            uint8_t code = MGBTCobsEncodeBlock(&frame[1U + position], frameLength - position, &consumed);
+            encoded[encodedLength] = code;
+            memcpy(&encoded[encodedLength + 1U], &frame[1U + position], code - 1U);
+            encodedLength += code;
+            position += consumed;
+        }
+        encoded[encodedLength] = MGBTCOBS_DELIMITER;
+        WriteAll(encoded, (uint16_t)(encodedLength + 1U));
+    }
+}
+
+//Responses come back in the order of their commands.
+static void CheckResponse(uint16_t length)
+{
+    uint32_t command = received;
+    uint16_t expectedType = (uint16_t)(NoOperation | (((command % SEQUENCECOUNT) + 1U) << MGBTSEQUENCESHIFT));
+    uint8_t valid = 0U;
+
+    if((length == (TXHEADERLENGTH + config.size)) &&
+       (GetWord(response, 0U) == config.size) &&
+       (GetWord(response, 2U) == MGBTCrcCalculate(&response[4], (uint16_t)(length - 4U))) &&
+       (GetWord(response, 6U) == expectedType))
+    {
+        uint16_t index;
+        valid = 1U;
+        for(index = 0U; index < config.size; index++)
+        {
+            if(response[TXHEADERLENGTH + index] != GetPayloadByte(command, index))
+            {
+                valid = 0U;
+            }
+        }
+    }
+
+    if(valid == 0U)
+    {
+        printf("Echo %u does not match its command\n", command);
+        failures++;
+    }
+    latencies[command] = GetTimeNs() - sendTimes[command];
+    received++;
+}
+
+static void CollectResponseByte(uint8_t byte)
+{
+    if(collectingV2 == 1U)
+    {
+        if(byte == MGBTCOBS_DELIMITER)
+        {
+            MGBTCobsDecoder decoder;
+            uint16_t decodedLength;
+
+            MGBTCobsDecodeInit(&decoder);
+            decodedLength = MGBTCobsDecode(&decoder, encodedResponse, encodedPosition, response);
+            if(MGBTCobsDecodeComplete(&decoder) == 0U)
+            {
+                decodedLength = 0U;
+            }
+            CheckResponse(decodedLength);
+            collectingV2 = 0U;
+        }
+        else if(encodedPosition < sizeof(encodedResponse))
+        {
+            encodedResponse[encodedPosition] = byte;
+            encodedPosition++;
+        }
+    }
+    else if((responsePosition == 0U) && (byte == MGBTCOBS_DELIMITER))
+    {
+        collectingV2 = 1U;
+        encodedPosition = 0U;
+    }
+    else
+    {
+        if(responsePosition < sizeof(response))
+        {
+            response[responsePosition] = byte;
+        }
+        responsePosition++;
+        if((responsePosition >= TXHEADERLENGTH) &&
+           (responsePosition >= (TXHEADERLENGTH + GetWord(response, 0U))))
+        {
+            CheckResponse(responsePosition);
+            responsePosition = 0U;
+        }
+    }
+}
+
+//Returns 0 when nothing arrived within the timeout.
+static uint8_t ReceiveResponses(void)
+{
+    static uint8_t data[4096];
+    struct pollfd link = {centralFd, POLLIN, 0};
+    uint8_t retVal = 0U;
+
+    if((poll(&link, 1U, RESPONSETIMEOUTMS) == 1) && ((link.revents & POLLIN) != 0))
+    {
+        ssize_t readResult = read(centralFd, data, sizeof(data));
+        ssize_t index;
+        for(index = 0; index < readResult; index++)
+        {
+            CollectResponseByte(data[index]);
+        }
+        retVal = (readResult > 0) ? 1U : 0U;
+    }
+
+    return retVal;
+}
+
+static int CompareLatency(const void* first, const void* second)
+{
+    uint64_t a = *(const uint64_t*)first;
+    uint64_t b = *(const uint64_t*)second;
+    return (a > b) - (a < b);
+}
+
+static uint8_t OpenLink(int* deviceFd)
+{
+    uint8_t retVal = 0U;
+
+    if(config.usePty == 1U)
+    {
+        centralFd = posix_openpt(O_RDWR | O_NOCTTY);
+        if((centralFd >= 0) && (grantpt(centralFd) == 0) && (unlockpt(centralFd) == 0))
+        {
+            retVal = MGBTPortLinuxOpen(ptsname(centralFd));
+        }
+        (*deviceFd) = -1;
+    }
+    else
+    {
+        int pair[2];
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0)
+        {
+            centralFd = pair[0];
+            (*deviceFd) = pair[1];
+            MGBTPortLinuxAttach(pair[1]);
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+static void PrintReport(double elapsed)
+{
+    uint64_t total = 0U;
+    uint32_t index;
+
+    qsort(latencies, received, sizeof(uint64_t), CompareLatency);
+    for(index = 0U; index < received; index++)
+    {
+        total += latencies[index];
+    }
+
+    printf("%s, v%u framing, %u byte commands, %u in flight\n",
+           (config.usePty == 1U) ? "pty" : "socket pair", config.framing, config.size, config.window);
+    printf("Round trips: %u of %u in %.3f s\n", received, config.count, elapsed);
+    if(received > 0U)
+    {
+        printf("Round trip: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               (double)total / received / 1000.0,
+               (double)latencies[received / 2U] / 1000.0,
+               (double)latencies[(received * 99U) / 100U] / 1000.0,
+               (double)latencies[received - 1U] / 1000.0);
+        printf("Throughput: %.0f commands/s, %.1f KiB/s of data each way\n",
+               received / elapsed, ((double)received * config.size) / elapsed / 1024.0);
+    }
+}
+
+static void PrintUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  --count N   round trips (default 1000)\n");
+    printf("  --size N    data bytes per command (default 128)\n");
+    printf("  --window N  commands in flight, up to %u (default 1)\n", MAXWINDOW);
+    printf("  --framing N 1 or 2 (default 2)\n");
+    printf("  --pty N     1 to run over a pty instead of a socket pair (default 0)\n");
+}
+
+static uint8_t ParseArguments(int argc, char** argv)
+{
+    uint8_t retVal = 1U;
+    int index;
+
+    for(index = 1; (index < argc) && (retVal == 1U); index++)
+    {
+        const char* option = argv[index];
+        const char* value = (index + 1 < argc) ? argv[index + 1] : (const char*)0;
+        uint32_t number = (value != (const char*)0) ? (uint32_t)strtoul(value, (char**)0, 10) : 0U;
+
+        if(value == (const char*)0)
+        {
+            retVal = 0U;
+        }
+        else if(strcmp(option, "--count") == 0)
+        {
+            config.count = number;
+        }
+        else if(strcmp(option, "--size") == 0)
+        {
+            config.size = (uint16_t)number;
+        }
+        else if(strcmp(option, "--window") == 0)
+        {
+            config.window = (uint8_t)number;
+        }
+        else if(strcmp(option, "--framing") == 0)
+        {
+            config.framing = (uint8_t)number;
+        }
+        else if(strcmp(option, "--pty") == 0)
+        {
+            config.usePty = (uint8_t)number;
+        }
+        else
+        {
+            retVal = 0U;
+        }
+        index++;
+    }
+
+    if((config.count == 0U) || (config.window == 0U) || (config.window > MAXWINDOW) ||
+       ((config.framing != MGBTFramingV1) && (config.framing != MGBTFramingV2)) ||
+       ((config.framing == MGBTFramingV1) && (config.size > COMMANDDATAMAXSIZE)) ||
+       (config.size > MGBTV2DATAMAXSIZE))
+    {
+        retVal = 0U;
+    }
+
+    return retVal;
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t device;
+    int deviceFd;
+    uint32_t sent = 0U;
+    uint64_t start;
+    int retVal = 0;
+
+    if(ParseArguments(argc, argv) == 0U)
+    {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if(OpenLink(&deviceFd) == 0U)
+    {
+        printf("Could not open the link\n");
+        return 1;
+    }
+    sendTimes = calloc(config.count, sizeof(uint64_t));
+    latencies = calloc(config.count, sizeof(uint64_t));
+    pthread_create(&device, (const pthread_attr_t*)0, RunDevice, (void*)0);
+
+    start = GetTimeNs();
+    while(received < config.count)
+    {
+        while((sent < config.count) && ((sent - received) < config.window))
+        {
+            SendCommand(sent);
+            sent++;
+        }
+        if(ReceiveResponses() == 0U)
+        {
+            printf("No response within %d ms\n", RESPONSETIMEOUTMS);
+            break;
+        }
+    }
+    PrintReport((double)(GetTimeNs() - start) / 1e9);
+
+    deviceStop = 1U;
+    pthread_join(device, (void**)0);
+    close(centralFd);
+    if(deviceFd >= 0)
+    {
+        close(deviceFd);
+    }
+
+    if((received < config.count) || (failures > 0U))
+    {
+        retVal = 1;
+    }
+    free(sendTimes);
+    free(latencies);
+
+    return retVal;
+}
@@ -0,0 +1,41 @@
+/*
+ * MGBTCobs.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Consistent overhead byte stuffing for the v2 framing of the MGBT protocol.
+ * Encoded data contains no zero bytes, so a zero byte delimits frames and a
+ * receiver finds the start of the next frame without waiting for a timeout.
+ * Both directions work block by block so frames can be coded in place.
+ */
+
+#ifndef MAIN_MGBTCOBS_H_
+#define MAIN_MGBTCOBS_H_
+
+#include <stdint.h>
+
+#define MGBTCOBS_DELIMITER 0x00U
+//Longest run of non-zero bytes a code byte can describe.
+#define MGBTCOBS_BLOCKLENGTH 254U
+//Bytes encoding adds to length bytes of data, not counting the delimiters.
+#define MGBTCOBS_MAXOVERHEAD(length) (((length) / MGBTCOBS_BLOCKLENGTH) + 1U)
+
+typedef struct
+{
+    uint8_t code;
+    uint8_t remaining;
+    uint8_t started;
+} MGBTCobsDecoder;
+
+//Returns the code byte for the block at the start of data, the block itself is data[0] up to data[code - 2].
+//consumed is the number of data bytes the block covers. The end of the data counts as a zero byte,
+//so consumed exceeds length by one once the last block has been coded.
+uint8_t MGBTCobsEncodeBlock(const uint8_t* data, uint16_t length, uint16_t* consumed);
+void MGBTCobsDecodeInit(MGBTCobsDecoder* decoder);
+//Decodes the next piece of a frame, without its delimiters. Returns the number of bytes written to dst,
+//which is never more than length, so dst may be data.
+uint16_t MGBTCobsDecode(MGBTCobsDecoder* decoder, const uint8_t* data, uint16_t length, uint8_t* dst);
+//Returns 1 when the data decoded so far ends on a block boundary, frames that stop halfway a block are corrupt.
+uint8_t MGBTCobsDecodeComplete(const MGBTCobsDecoder* decoder);
+
+#endif /* MAIN_MGBTCOBS_H_ */
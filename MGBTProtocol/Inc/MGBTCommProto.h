@@ -0,0 +1,151 @@
+/*
+ * MGBTCommProto.h
+ *
+ *  Created on: 21 Nov 2020
+ *      Author: cdromke
+ */
+
+#ifndef MAIN_MGBTCOMMPROTO_H_
+#define MAIN_MGBTCOMMPROTO_H_
+
+#include <stdint.h>
+#include "MGBTPortConfig.h"
+#include "MGBTCobs.h"
+
+#define COMMANDDATAMAXSIZE 128U
+//Number of received commands that can wait to be handled.
+#define MGBTCOMMANDQUEUELENGTH 4U
+//The high byte of the command type on the wire carries a sequence number, responses to the command carry the same one.
+//Sequence 0 is used by centrals that send one command at a time and for frames the device sends on its own.
+#define MGBTCOMMANDTYPEMASK 0x00FFU
+#define MGBTSEQUENCESHIFT 8U
+
+//Protocol version reported in the identification response. Version 2 adds the COBS delimited framing.
+#define MGBTPROTOCOLVERSION 2U
+
+//Rate both ends use after power up, after a switch that was not confirmed and after a burst of receive errors.
+#define MGBTDEFAULTLINKSPEED 115200U
+//SetLinkSpeed accepts the default rate doubled, up to this one.
+#define MGBTMAXLINKSPEED 921600U
+
+//Length, CRC, status and command type.
+#define MGBTFRAMEHEADERLENGTH 8U
+//A v2 frame as sent: delimiter, encoded header and data, delimiter.
+#define MGBTV2FRAMEMAXLENGTH (MGBTFRAMEHEADERLENGTH + MGBTV2DATAMAXSIZE + MGBTCOBS_MAXOVERHEAD(MGBTFRAMEHEADERLENGTH + MGBTV2DATAMAXSIZE) + 2U)
+#define DATABUFFERLENGTH (2U * MGBTV2FRAMEMAXLENGTH)
+//Part of the transmit path one response can take up. v2 responses are assembled past the space
+//their encoding needs and then encoded to the start, the encoded frame never catches up with the
+//bytes still to be encoded.
+#define MGBTV2STAGINGOFFSET (MGBTCOBS_MAXOVERHEAD(MGBTFRAMEHEADERLENGTH + MGBTV2DATAMAXSIZE) + 2U)
+#define MGBTRESPONSEMAXLENGTH (MGBTV2STAGINGOFFSET + MGBTFRAMEHEADERLENGTH + MGBTV2DATAMAXSIZE)
+
+typedef enum
+{
+    NoOperation = 0U,
+    AddAllowedDevice = 1U,
+    RemoveAllowedDevice = 2U,
+    ListAllowedDevices = 3U,
+    ListDetectedDevices = 4U,
+    GetClosestDevice = 5U,
+    SetStartLightState = 6U,
+    ClearAllowedDevices = 7U,
+
+    GetLatestTimeStamp = 101U,
+    GetAllLaps = 102U,
+    GetCurrentTime = 103U,
+    UpdateDisplayedTime = 104U,
+    UpdateOpMode = 105U,
+    GetLapsSince = 106U,
+    AckTimestamps = 107U,
+    ReplayJournal = 108U,
+    TimeEventBatch = 109U,
+    GetPerfStats = 110U,
+    GetSensorTraces = 111U,
+    GetSchedulerStats = 112U,
+    Subscribe = 253U,
+    SetLinkSpeed = 254U,
+    GetIdentification = 255U
+
+} MGBTCommandType;
+
+//v1 frames start with 0xFF and are delimited by their length and a receive timeout.
+//v2 frames are COBS encoded between zero bytes. Devices answer in the framing of the command.
+typedef enum
+{
+    MGBTFramingV1 = 1U,
+    MGBTFramingV2 = 2U
+} MGBTFraming;
+
+typedef struct
+{
+    uint16_t dataLength;
+    uint16_t crc;
+    uint16_t status;
+    uint16_t cmdType;
+    uint8_t data[COMMANDDATAMAXSIZE];
+} MGBTCommandData;
+
+//Received bytes, read in place. The second part is only used when they run across the end of the receive ring.
+typedef struct
+{
+    const uint8_t* part[2];
+    uint16_t partLength[2];
+} MGBTDataView;
+
+//A received command. The data stays in the receive ring until the command is released.
+typedef struct
+{
+    uint16_t dataLength;
+    uint16_t crc;
+    uint16_t status;
+    uint16_t cmdType;
+    uint8_t sequence;
+    uint8_t framing;
+    MGBTDataView data;
+} MGBTCommandView;
+
+//Frames a device pushes on its own, identified by their command type. Until a central subscribes
+//to a topic every topic is pushed at its default period, as older centrals expect. After that
+//only the subscribed ones are, topics that push on change only when their value changed.
+typedef struct
+{
+    uint8_t topic;
+    uint8_t onChange;
+    uint8_t changed;
+    uint16_t defaultPeriod; //Milliseconds
+    uint16_t minPeriod;
+    uint16_t period; //0 while not subscribed
+    uint32_t lastSent;
+} MGBTTopic;
+
+typedef enum
+{
+    DeviceTypeNone = 0U,
+    DeviceTypeTimer = 1U,
+    DeviceTypeIdentifier = 2U,
+    DeviceTypeDisplay = 4U,
+    DeviceTypeStartRelease = 8U
+} DeviceTypes;
+
+uint8_t CommandAvailable(void);
+MGBTCommandView* GetAndClearCommand(void);
+uint8_t GetCommandDataByte(const MGBTCommandView* command, uint16_t index);
+uint16_t CopyCommandData(const MGBTCommandView* command, uint16_t offset, void* dst, uint16_t length);
+uint8_t CanSendResponse(void);
+uint8_t BeginResponse(uint16_t cmdType, uint16_t status);
+uint8_t BeginCommandResponse(const MGBTCommandView* command, uint16_t status);
+void AddResponseData(const void* data, uint16_t length);
+void AddResponseCommandData(const MGBTCommandView* command);
+uint16_t GetResponseSpaceLeft(void);
+void ProcessLinkSpeedCommand(const MGBTCommandView* command);
+void ProcessSubscribeCommand(const MGBTCommandView* command, MGBTTopic* topics, uint8_t topicCount);
+uint8_t IsTopicDue(const MGBTTopic* topic);
+void MarkTopicChanged(MGBTTopic* topic);
+void MarkTopicSent(MGBTTopic* topic);
+void AddProtocolInfoToResponse(void);
+void FinishResponse(void);
+void RunCommProto(void);
+void InitCommProto(void);
+uint16_t GetCommandMaxDataLength(void);
+
+#endif /* MAIN_MGBTCOMMPROTO_H_ */
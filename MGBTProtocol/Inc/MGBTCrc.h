@@ -0,0 +1,30 @@
+/*
+ * MGBTCrc.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * CRC used by the MGBT protocol: the ThingMagic variant of CRC-16 with
+ * polynomial 0x1021 and seed 0xFFFF, fed directly with the message bits.
+ * All engines give bit-exact identical results.
+ */
+
+#ifndef MAIN_MGBTCRC_H_
+#define MAIN_MGBTCRC_H_
+
+#include <stdint.h>
+
+#define MGBTCRC_SEED 0xFFFFU
+
+typedef enum
+{
+    MGBTCrcNibbleTable = 0U, //16 entry table, two lookups per byte, 32 bytes of flash
+    MGBTCrcByteTable = 1U //256 entry table, one lookup per byte, 512 bytes of flash
+} MGBTCrcEngine;
+
+void MGBTCrcSetEngine(MGBTCrcEngine engine);
+MGBTCrcEngine MGBTCrcGetEngine(void);
+//Continues a CRC over more data, start with MGBTCRC_SEED.
+uint16_t MGBTCrcUpdate(uint16_t crc, const uint8_t* data, uint16_t length);
+uint16_t MGBTCrcCalculate(const uint8_t* data, uint16_t length);
+
+#endif /* MAIN_MGBTCRC_H_ */
@@ -0,0 +1,51 @@
+/*
+ * MGBTPort.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * What MGBTCommProto.c needs from the platform it runs on: a millisecond time
+ * source, the received bytes of the UART and a transmit path. Every port in
+ * Ports/ implements these functions and provides an MGBTPortConfig.h with
+ * MGBTV2DATAMAXSIZE and the MGBT_LOG macros. The port is picked by the
+ * include path and the port source that is built, the protocol has no
+ * platform checks of its own.
+ *
+ * Received bytes are counted from the start of the oldest frame that has not
+ * been released, transmit offsets from the end of the frames already
+ * committed. The protocol only calls these from RunCommProto and the response
+ * functions, never from an interrupt.
+ */
+
+#ifndef MAIN_MGBTPORT_H_
+#define MAIN_MGBTPORT_H_
+
+#include <stdint.h>
+
+//Sets up the UART at MGBTDEFAULTLINKSPEED.
+void MGBTPortInit(void);
+uint32_t MGBTPortGetTimeMs(void);
+
+//Number of bytes received since the start of the oldest unreleased frame.
+uint16_t MGBTPortGetReceivedLength(void);
+//Points data at the received bytes from offset on. Returns how many of them are contiguous.
+uint16_t MGBTPortPeekReceived(uint16_t offset, const uint8_t** data);
+//Gives the oldest length bytes back. framesQueued is the number of frames behind them that
+//are still referenced, they must stay where they are.
+void MGBTPortReleaseReceived(uint16_t length, uint8_t framesQueued);
+//Overwrites received bytes, for decoding in place.
+void MGBTPortReplaceReceived(uint16_t offset, const uint8_t* data, uint16_t length);
+void MGBTPortDiscardReceived(void);
+//Returns 1 when received bytes that have not been released were, or are about to be, overwritten.
+uint8_t MGBTPortReceiveOverrun(void);
+
+//Returns 1 when a frame of frameLength bytes can be queued behind the ones still going out.
+uint8_t MGBTPortHasTxRoom(uint16_t frameLength);
+void MGBTPortWriteTx(uint16_t offset, const uint8_t* data, uint16_t length);
+void MGBTPortReadTx(uint16_t offset, uint8_t* dst, uint16_t length);
+//Sends the first length bytes written since the last commit.
+void MGBTPortCommitTx(uint16_t length);
+//Returns 1 once the last committed byte has left the line.
+uint8_t MGBTPortTxComplete(void);
+void MGBTPortSetLinkSpeed(uint32_t speed);
+
+#endif /* MAIN_MGBTPORT_H_ */
@@ -0,0 +1,24 @@
+/*
+ * MGBTPortConfig.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT protocol settings for the rider detection, see MGBTPort.h.
+ */
+
+#ifndef MAIN_MGBTPORTCONFIG_H_
+#define MAIN_MGBTPORTCONFIG_H_
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+#define MGBT_UART UART_NUM_1
+#define TXD_PIN (GPIO_NUM_4)
+#define RXD_PIN (GPIO_NUM_5)
+#define MGBTV2DATAMAXSIZE 2048U
+
+#define MGBT_LOGI(...) ESP_LOGI("MGBTCommProto", __VA_ARGS__)
+#define MGBT_LOGW(...) ESP_LOGW("MGBTCommProto", __VA_ARGS__)
+#define MGBT_LOGE(...) ESP_LOGE("MGBTCommProto", __VA_ARGS__)
+
+#endif /* MAIN_MGBTPORTCONFIG_H_ */
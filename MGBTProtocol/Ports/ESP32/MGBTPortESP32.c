@@ -0,0 +1,144 @@
+/*
+ * MGBTPortESP32.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT port on the ESP-IDF UART driver. The driver owns its ring and can only
+ * copy out of it, so received bytes land in a buffer of our own where they
+ * are decoded in place. Responses are assembled in a frame buffer and handed
+ * to the driver whole.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <driver/uart.h>
+#include "driver/gpio.h"
+#include "esp_log.h"
+
+#include "MGBTTimeMgmt.h"
+#include "MGBTCommProto.h"
+#include "MGBTPort.h"
+
+static const char* AppName = "MGBTCommProto";
+static const uart_config_t uart_config =
+{
+    .baud_rate = MGBTDEFAULTLINKSPEED,
+    .data_bits = UART_DATA_8_BITS,
+    .parity = UART_PARITY_DISABLE,
+    .stop_bits = UART_STOP_BITS_1,
+    .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+    .source_clk = UART_SCLK_APB,
+};
+
+static uint8_t rxLandingBuffer[DATABUFFERLENGTH] = {0U};
+static uint16_t rxLandingStart = 0U;
+static uint16_t rxLandingLength = 0U;
+//The driver is installed without a transmit buffer and writes whole frames only.
+static uint8_t txFrame[MGBTRESPONSEMAXLENGTH] = {0U};
+
+void MGBTPortInit(void)
+{
+    // We won't use a buffer for sending data.
+    uart_driver_install(MGBT_UART, DATABUFFERLENGTH * 2, 0, 0, NULL, 0);
+    uart_param_config(MGBT_UART, &uart_config);
+    uart_set_pin(MGBT_UART, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    ESP_LOGI(AppName, "CommandDataSize: %d", (int)sizeof(MGBTCommandData));
+}
+
+uint32_t MGBTPortGetTimeMs(void)
+{
+    return GetTimestampMs();
+}
+
+uint16_t MGBTPortGetReceivedLength(void)
+{
+    int32_t uartResult = uart_read_bytes(MGBT_UART, &rxLandingBuffer[rxLandingLength], (DATABUFFERLENGTH - rxLandingLength) - 1, 1);
+    if(uartResult > 0)
+    {
+        rxLandingLength += (uint16_t)uartResult;
+        ESP_LOGI(AppName, "Read %d bytes, buffer at pos %d", uartResult, rxLandingLength);
+        ESP_LOGI(AppName, "Received data:");
+        ESP_LOG_BUFFER_HEXDUMP(AppName, &rxLandingBuffer[rxLandingStart], rxLandingLength - rxLandingStart, ESP_LOG_INFO);
+    }
+    return rxLandingLength - rxLandingStart;
+}
+
+uint16_t MGBTPortPeekReceived(uint16_t offset, const uint8_t** data)
+{
+    uint16_t retVal = 0U;
+    if((rxLandingStart + offset) < rxLandingLength)
+    {
+        (*data) = &rxLandingBuffer[rxLandingStart + offset];
+        retVal = rxLandingLength - (rxLandingStart + offset);
+    }
+
+    return retVal;
+}
+
+void MGBTPortReleaseReceived(uint16_t length, uint8_t framesQueued)
+{
+    rxLandingStart += length;
+    //Queued commands point into the buffer, it can only be compacted when there are none.
+    if(framesQueued == 0U)
+    {
+        memmove(rxLandingBuffer, &rxLandingBuffer[rxLandingStart], rxLandingLength - rxLandingStart);
+        rxLandingLength -= rxLandingStart;
+        rxLandingStart = 0U;
+    }
+}
+
+void MGBTPortReplaceReceived(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    memmove(&rxLandingBuffer[rxLandingStart + offset], data, length);
+}
+
+void MGBTPortDiscardReceived(void)
+{
+    rxLandingStart = 0U;
+    rxLandingLength = 0U;
+}
+
+//Bytes are only read when there is room for them.
+uint8_t MGBTPortReceiveOverrun(void)
+{
+    return 0U;
+}
+
+//uart_write_bytes blocks until the frame is in the driver.
+uint8_t MGBTPortHasTxRoom(uint16_t frameLength)
+{
+    (void)frameLength;
+    return 1U;
+}
+
+void MGBTPortWriteTx(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    memcpy(&txFrame[offset], data, length);
+}
+
+void MGBTPortReadTx(uint16_t offset, uint8_t* dst, uint16_t length)
+{
+    memcpy(dst, &txFrame[offset], length);
+}
+
+void MGBTPortCommitTx(uint16_t length)
+{
+    uart_write_bytes(MGBT_UART, (char*)txFrame, length);
+}
+
+uint8_t MGBTPortTxComplete(void)
+{
+    uint8_t retVal = 0U;
+    if(uart_wait_tx_done(MGBT_UART, 0) == ESP_OK)
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+void MGBTPortSetLinkSpeed(uint32_t speed)
+{
+    uart_set_baudrate(MGBT_UART, speed);
+    ESP_LOGI(AppName, "Link speed set to %u", (unsigned int)speed);
+}
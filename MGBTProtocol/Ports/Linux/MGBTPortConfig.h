@@ -0,0 +1,26 @@
+/*
+ * MGBTPortConfig.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT protocol settings for Linux hosts, see MGBTPort.h and MGBTPortLinux.h.
+ */
+
+#ifndef MAIN_MGBTPORTCONFIG_H_
+#define MAIN_MGBTPORTCONFIG_H_
+
+#include <stdio.h>
+
+//Not used, the port talks to the descriptor given to MGBTPortLinuxAttach.
+#define MGBT_UART 0
+//Can be set on the command line to match the device being compared with.
+#ifndef MGBTV2DATAMAXSIZE
+#define MGBTV2DATAMAXSIZE 2048U
+#endif
+
+//Information is left out, it would be printed for every frame.
+#define MGBT_LOGI(...)
+#define MGBT_LOGW(...) (void)fprintf(stderr, "MGBTCommProto: " __VA_ARGS__), (void)fputc('\n', stderr)
+#define MGBT_LOGE(...) (void)fprintf(stderr, "MGBTCommProto: " __VA_ARGS__), (void)fputc('\n', stderr)
+
+#endif /* MAIN_MGBTPORTCONFIG_H_ */
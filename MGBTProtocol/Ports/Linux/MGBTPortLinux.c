@@ -0,0 +1,221 @@
+/*
+ * MGBTPortLinux.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT port on a Linux file descriptor. Received bytes land in a buffer of our
+ * own where they are decoded in place, like on the ESP32. Responses are
+ * assembled in a frame buffer and written whole.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "MGBTCommProto.h"
+#include "MGBTPort.h"
+#include "MGBTPortLinux.h"
+
+static int linkFd = -1;
+static uint8_t rxLandingBuffer[DATABUFFERLENGTH] = {0U};
+static uint16_t rxLandingStart = 0U;
+static uint16_t rxLandingLength = 0U;
+static uint8_t txFrame[MGBTRESPONSEMAXLENGTH] = {0U};
+
+static speed_t GetTerminalSpeed(uint32_t speed)
+{
+    speed_t retVal = B115200;
+    switch(speed)
+    {
+        case 230400U:
+            retVal = B230400;
+            break;
+        case 460800U:
+            retVal = B460800;
+            break;
+        case 921600U:
+            retVal = B921600;
+            break;
+        default:
+            break;
+    }
+
+    return retVal;
+}
+
+void MGBTPortLinuxAttach(int fd)
+{
+    struct termios settings;
+
+    linkFd = fd;
+    if((isatty(fd) == 1) && (tcgetattr(fd, &settings) == 0))
+    {
+        cfmakeraw(&settings);
+        cfsetspeed(&settings, GetTerminalSpeed(MGBTDEFAULTLINKSPEED));
+        (void)tcsetattr(fd, TCSANOW, &settings);
+    }
+}
+
+uint8_t MGBTPortLinuxOpen(const char* path)
+{
+    uint8_t retVal = 0U;
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if(fd >= 0)
+    {
+        MGBTPortLinuxAttach(fd);
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+void MGBTPortLinuxWait(uint32_t timeoutMs)
+{
+    struct pollfd link = {linkFd, POLLIN, 0};
+    (void)poll(&link, 1U, (int)timeoutMs);
+}
+
+void MGBTPortInit(void)
+{
+    rxLandingStart = 0U;
+    rxLandingLength = 0U;
+}
+
+uint32_t MGBTPortGetTimeMs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(((uint64_t)now.tv_sec * 1000U) + ((uint64_t)now.tv_nsec / 1000000U));
+}
+
+uint16_t MGBTPortGetReceivedLength(void)
+{
+    struct pollfd link = {linkFd, POLLIN, 0};
+    uint16_t space = (DATABUFFERLENGTH - rxLandingLength) - 1U;
+
+    if((space > 0U) && (poll(&link, 1U, 0) == 1) && ((link.revents & POLLIN) != 0))
+    {
+        ssize_t readResult = read(linkFd, &rxLandingBuffer[rxLandingLength], space);
+        if(readResult > 0)
+        {
+            rxLandingLength += (uint16_t)readResult;
+        }
+    }
+
+    return rxLandingLength - rxLandingStart;
+}
+
+uint16_t MGBTPortPeekReceived(uint16_t offset, const uint8_t** data)
+{
+    uint16_t retVal = 0U;
+    if((rxLandingStart + offset) < rxLandingLength)
+    {
+        (*data) = &rxLandingBuffer[rxLandingStart + offset];
+        retVal = rxLandingLength - (rxLandingStart + offset);
+    }
+
+    return retVal;
+}
+
+void MGBTPortReleaseReceived(uint16_t length, uint8_t framesQueued)
+{
+    rxLandingStart += length;
+    //Queued commands point into the buffer, it can only be compacted when there are none.
+    if(framesQueued == 0U)
+    {
+        memmove(rxLandingBuffer, &rxLandingBuffer[rxLandingStart], rxLandingLength - rxLandingStart);
+        rxLandingLength -= rxLandingStart;
+        rxLandingStart = 0U;
+    }
+}
+
+void MGBTPortReplaceReceived(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    memmove(&rxLandingBuffer[rxLandingStart + offset], data, length);
+}
+
+void MGBTPortDiscardReceived(void)
+{
+    rxLandingStart = 0U;
+    rxLandingLength = 0U;
+}
+
+//Bytes are only read when there is room for them.
+uint8_t MGBTPortReceiveOverrun(void)
+{
+    return 0U;
+}
+
+//MGBTPortCommitTx waits until the frame has been written.
+uint8_t MGBTPortHasTxRoom(uint16_t frameLength)
+{
+    (void)frameLength;
+    return 1U;
+}
+
+void MGBTPortWriteTx(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    memcpy(&txFrame[offset], data, length);
+}
+
+void MGBTPortReadTx(uint16_t offset, uint8_t* dst, uint16_t length)
+{
+    memcpy(dst, &txFrame[offset], length);
+}
+
+void MGBTPortCommitTx(uint16_t length)
+{
+    uint16_t written = 0U;
+
+    while(written < length)
+    {
+        ssize_t writeResult = write(linkFd, &txFrame[written], length - written);
+        if(writeResult > 0)
+        {
+            written += (uint16_t)writeResult;
+        }
+        else if((writeResult < 0) && (errno == EAGAIN))
+        {
+            struct pollfd link = {linkFd, POLLOUT, 0};
+            (void)poll(&link, 1U, -1);
+        }
+        else if((writeResult < 0) && (errno == EINTR))
+        {
+            //Try again.
+        }
+        else
+        {
+            //The other end is gone, the frame is dropped like on a disconnected line.
+            written = length;
+        }
+    }
+}
+
+uint8_t MGBTPortTxComplete(void)
+{
+    uint8_t retVal = 1U;
+    int pending = 0;
+    if((ioctl(linkFd, TIOCOUTQ, &pending) == 0) && (pending > 0))
+    {
+        retVal = 0U;
+    }
+
+    return retVal;
+}
+
+//Only changes real serial devices, a pty or socket has no rate.
+void MGBTPortSetLinkSpeed(uint32_t speed)
+{
+    struct termios settings;
+    if((isatty(linkFd) == 1) && (tcgetattr(linkFd, &settings) == 0))
+    {
+        cfsetspeed(&settings, GetTerminalSpeed(speed));
+        (void)tcsetattr(linkFd, TCSADRAIN, &settings);
+    }
+}
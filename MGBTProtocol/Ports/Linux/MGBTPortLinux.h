@@ -0,0 +1,23 @@
+/*
+ * MGBTPortLinux.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT port on a Linux file descriptor: a serial adaptor, a pty or one end
+ * of a socket pair. Lets the protocol run on a workstation, against a real
+ * central or against a test program on the other end.
+ */
+
+#ifndef MAIN_MGBTPORTLINUX_H_
+#define MAIN_MGBTPORTLINUX_H_
+
+#include <stdint.h>
+
+//Uses fd for the link from the next InitCommProto on. Terminals are put in raw mode.
+void MGBTPortLinuxAttach(int fd);
+//Opens a serial device or pty slave and attaches it. Returns 0 when it could not be opened.
+uint8_t MGBTPortLinuxOpen(const char* path);
+//Blocks until bytes arrive or timeoutMs passes, for main loops that have nothing else to do.
+void MGBTPortLinuxWait(uint32_t timeoutMs);
+
+#endif /* MAIN_MGBTPORTLINUX_H_ */
@@ -0,0 +1,22 @@
+/*
+ * MGBTPortConfig.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT protocol settings for the Timer, see MGBTPort.h.
+ */
+
+#ifndef MAIN_MGBTPORTCONFIG_H_
+#define MAIN_MGBTPORTCONFIG_H_
+
+//UARTBuffer index of USART1.
+#define MGBT_UART 0
+//Received frames are parsed in place, the receive ring has to hold the largest one.
+#define MGBTV2DATAMAXSIZE 512U
+
+//There is no log output, the UART is the link itself.
+#define MGBT_LOGI(...)
+#define MGBT_LOGW(...)
+#define MGBT_LOGE(...)
+
+#endif /* MAIN_MGBTPORTCONFIG_H_ */
@@ -0,0 +1,94 @@
+/*
+ * MGBTPortSTM32.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * MGBT port on the UARTBuffer rings of the Timer. The receive ring is read and
+ * decoded in place, responses are written straight into the transmit ring.
+ */
+
+#include <stdint.h>
+
+#include "TimeMgmt.h"
+#include "UARTBuffer.h"
+#include "MGBTCommProto.h"
+#include "MGBTPort.h"
+
+//The UART is set up by InitUARTBuffers together with the other buffers.
+void MGBTPortInit(void)
+{
+}
+
+uint32_t MGBTPortGetTimeMs(void)
+{
+    return GetSystemTimeStampMs();
+}
+
+uint16_t MGBTPortGetReceivedLength(void)
+{
+    return UARTBufferHasNewData(UARTBufferGetUART(MGBT_UART));
+}
+
+uint16_t MGBTPortPeekReceived(uint16_t offset, const uint8_t** data)
+{
+    return UARTBufferPeekData(UARTBufferGetUART(MGBT_UART), offset, data);
+}
+
+void MGBTPortReleaseReceived(uint16_t length, uint8_t framesQueued)
+{
+    //Releasing from the ring does not move the bytes behind.
+    (void)framesQueued;
+    UARTBufferSkipData(UARTBufferGetUART(MGBT_UART), length);
+}
+
+void MGBTPortReplaceReceived(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    UARTBufferWriteRxData(UARTBufferGetUART(MGBT_UART), offset, data, length);
+}
+
+void MGBTPortDiscardReceived(void)
+{
+    UARTBufferClear(UARTBufferGetUART(MGBT_UART));
+}
+
+//The receive DMA runs in circular mode and does not wait for the frames held in the ring.
+uint8_t MGBTPortReceiveOverrun(void)
+{
+    return UARTBufferRxOverrun(UARTBufferGetUART(MGBT_UART));
+}
+
+uint8_t MGBTPortHasTxRoom(uint16_t frameLength)
+{
+    uint8_t retVal = 0U;
+    if(UARTBufferGetTxFreeSpace(UARTBufferGetUART(MGBT_UART)) >= frameLength)
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+void MGBTPortWriteTx(uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    UARTBufferWriteTxData(UARTBufferGetUART(MGBT_UART), offset, data, length);
+}
+
+void MGBTPortReadTx(uint16_t offset, uint8_t* dst, uint16_t length)
+{
+    UARTBufferReadTxData(UARTBufferGetUART(MGBT_UART), offset, dst, length);
+}
+
+void MGBTPortCommitTx(uint16_t length)
+{
+    UARTBufferCommitTxData(UARTBufferGetUART(MGBT_UART), length);
+}
+
+uint8_t MGBTPortTxComplete(void)
+{
+    return UARTBufferTxComplete(UARTBufferGetUART(MGBT_UART));
+}
+
+void MGBTPortSetLinkSpeed(uint32_t speed)
+{
+    UARTBufferSetBaudRate(UARTBufferGetUART(MGBT_UART), speed);
+}
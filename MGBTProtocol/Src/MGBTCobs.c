@@ -0,0 +1,85 @@
+/*
+ * MGBTCobs.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <stdint.h>
+
+#include "MGBTCobs.h"
+
+uint8_t MGBTCobsEncodeBlock(const uint8_t* data, uint16_t length, uint16_t* consumed)
+{
+    uint16_t index = 0U;
+
+    if(length > MGBTCOBS_BLOCKLENGTH)
+    {
+        length = MGBTCOBS_BLOCKLENGTH;
+    }
+    while((index < length) && (data[index] != MGBTCOBS_DELIMITER))
+    {
+        index++;
+    }
+
+    //A full block of non-zero bytes is not followed by a zero, every other block is.
+    if(index == MGBTCOBS_BLOCKLENGTH)
+    {
+        (*consumed) = index;
+    }
+    else
+    {
+        (*consumed) = index + 1U;
+    }
+
+    return (uint8_t)(index + 1U);
+}
+
+void MGBTCobsDecodeInit(MGBTCobsDecoder* decoder)
+{
+    decoder->code = 0xFFU;
+    decoder->remaining = 0U;
+    decoder->started = 0U;
+}
+
+uint16_t MGBTCobsDecode(MGBTCobsDecoder* decoder, const uint8_t* data, uint16_t length, uint8_t* dst)
+{
+    uint16_t retVal = 0U;
+    uint16_t index;
+
+    for(index = 0U; index < length; index++)
+    {
+        uint8_t value = data[index];
+        if(decoder->remaining > 0U)
+        {
+            dst[retVal] = value;
+            retVal++;
+            decoder->remaining--;
+        }
+        else
+        {
+            //The zero closing the previous block is only written once another block follows,
+            //the one implied at the end of the frame is not part of the data.
+            if((decoder->started == 1U) && (decoder->code != 0xFFU))
+            {
+                dst[retVal] = 0U;
+                retVal++;
+            }
+            decoder->started = 1U;
+            decoder->code = value;
+            decoder->remaining = (uint8_t)(value - 1U);
+        }
+    }
+
+    return retVal;
+}
+
+uint8_t MGBTCobsDecodeComplete(const MGBTCobsDecoder* decoder)
+{
+    uint8_t retVal = 0U;
+    if((decoder->started == 1U) && (decoder->remaining == 0U))
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,990 @@
+/*
+ * MGBTCommProto.c
+ *
+ *  Created on: 21 Nov 2020
+ *      Author: cdromke
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "MGBTCommProto.h"
+#include "MGBTPort.h"
+#include "MGBTCrc.h"
+#include "MGBTCobs.h"
+
+//Only v1 frames time out, v2 frames are delimited.
+#define RECEIVETIMEOUT 200U
+#define V1HEADERBYTE 0xFFU
+//Received frames: 0xFF, data length, CRC, status, command type, data.
+//Header byte, data length and CRC are not covered by the CRC.
+//A v2 frame is decoded in place to the same layout, with its leading delimiter as header byte.
+#define RXCRCSTART 5U
+#define RXHEADERLENGTH 9U
+//Sent frames: data length, CRC, status, command type, data.
+#define TXCRCSTART 4U
+#define TXHEADERLENGTH MGBTFRAMEHEADERLENGTH
+#define V2STAGINGOFFSET MGBTV2STAGINGOFFSET
+#define V2RESPONSEMAXLENGTH MGBTRESPONSEMAXLENGTH
+//A switched rate is kept once a good frame arrives at it within this time.
+#define LINKCONFIRMTIMEOUT 500U
+//This many dropped frames or junk runs with no good frame between them make a raised rate fall back to the default.
+#define LINKERRORLIMIT 6U
+
+typedef enum
+{
+    LinkSpeedStable = 0U,
+    LinkSpeedSwitchPending = 1U, //Accepted, switched once the response has gone out
+    LinkSpeedConfirmPending = 2U //Switched, waiting for a good frame at the new rate
+} LinkSpeedState;
+
+typedef struct
+{
+    MGBTCommandView command;
+    uint16_t frameLength;
+} QueuedCommand;
+
+//Complete frames waiting to be handled, oldest first. They stay in the receive buffer until
+//they are released, so receive offsets count from the start of the oldest one.
+static QueuedCommand commandQueue[MGBTCOMMANDQUEUELENGTH] = {0};
+static uint8_t commandQueueHead = 0U;
+static uint8_t commandQueueCount = 0U;
+//The oldest command has been handed out and is released on the next call.
+static uint8_t commandTaken = 0U;
+//Frame being received behind the queued ones; parsed in place, these only track how far it has been looked at.
+static uint16_t rxFrameStart = 0U;
+static uint16_t rxScanLength = 0U;
+//Bytes before the frame that belong to no command, released together with the command before them.
+static uint16_t rxSkipLength = 0U;
+//Part of a v2 frame that has been searched for its closing delimiter.
+static uint16_t rxDelimiterPosition = 1U;
+static uint32_t rxFrameStartTime = 0U;
+//Running CRC over the received frame, updated as bytes arrive.
+static uint16_t rxCrc = MGBTCRC_SEED;
+static uint16_t rxCrcPosition = RXCRCSTART;
+//Response under construction, written straight to its place in the transmit path.
+static uint16_t txDataLength = 0U;
+static uint16_t txCrc = MGBTCRC_SEED;
+static uint8_t txFraming = MGBTFramingV1;
+static uint16_t txStart = 0U;
+//Framing the central used last, frames the device sends on its own follow it.
+static uint8_t linkFraming = MGBTFramingV1;
+//Chunks of a frame being decoded or encoded.
+static uint8_t codingBlock[MGBTCOBS_BLOCKLENGTH] = {0U};
+static uint32_t linkSpeed = MGBTDEFAULTLINKSPEED;
+static uint32_t pendingLinkSpeed = MGBTDEFAULTLINKSPEED;
+//Rate to go back to when the switch is not confirmed.
+static uint32_t previousLinkSpeed = MGBTDEFAULTLINKSPEED;
+static uint8_t linkSpeedState = LinkSpeedStable;
+static uint32_t linkSpeedSwitchTime = 0U;
+static uint8_t linkErrorCount = 0U;
+//A central subscribed to a topic, the default pushes have stopped.
+static uint8_t topicsSubscribed = 0U;
+
+static uint16_t GetMaxDataLength(uint8_t framing)
+{
+    uint16_t retVal = COMMANDDATAMAXSIZE;
+    if(framing == MGBTFramingV2)
+    {
+        retVal = MGBTV2DATAMAXSIZE;
+    }
+
+    return retVal;
+}
+
+//Room for one more frame of the largest size, so a response can be queued behind the ones still going out.
+static uint8_t GetRoomForResponse(uint8_t framing)
+{
+    uint8_t retVal = 0U;
+    uint16_t frameLength = TXHEADERLENGTH + COMMANDDATAMAXSIZE;
+    if(framing == MGBTFramingV2)
+    {
+        frameLength = V2RESPONSEMAXLENGTH;
+    }
+    retVal = MGBTPortHasTxRoom(frameLength);
+    //Nothing more goes out at the old rate once a switch has been accepted.
+    if(linkSpeedState == LinkSpeedSwitchPending)
+    {
+        retVal = 0U;
+    }
+
+    return retVal;
+}
+
+static uint8_t GetFrameByte(uint16_t offset)
+{
+    uint8_t retVal = 0U;
+    const uint8_t* data;
+
+    if(MGBTPortPeekReceived(rxFrameStart + offset, &data) > 0U)
+    {
+        retVal = data[0];
+    }
+
+    return retVal;
+}
+
+static uint16_t GetFrameWord(uint16_t offset)
+{
+    return (uint16_t)(GetFrameByte(offset) | (GetFrameByte(offset + 1U) << 8));
+}
+
+//Describes length bytes of the current frame from offset on, in one part or two when they wrap.
+static void GetFrameView(uint16_t offset, uint16_t length, MGBTDataView* view)
+{
+    uint8_t part;
+
+    offset += rxFrameStart;
+    memset(view, 0U, sizeof(MGBTDataView));
+    for(part = 0U; (part < 2U) && (length > 0U); part++)
+    {
+        uint16_t partLength = MGBTPortPeekReceived(offset, &view->part[part]);
+        if(partLength > length)
+        {
+            partLength = length;
+        }
+        view->partLength[part] = partLength;
+        offset += partLength;
+        length -= partLength;
+    }
+}
+
+//Starts looking for the next frame right behind the current one.
+static void StartNextFrame(uint16_t frameLength)
+{
+    rxFrameStart += frameLength;
+    rxScanLength -= frameLength;
+    rxFrameStartTime = MGBTPortGetTimeMs();
+    rxCrc = MGBTCRC_SEED;
+    rxCrcPosition = RXCRCSTART;
+    rxDelimiterPosition = 1U;
+}
+
+static void ResetData(void)
+{
+    MGBTPortDiscardReceived();
+    rxFrameStart = 0U;
+    rxScanLength = 0U;
+    rxSkipLength = 0U;
+    rxCrc = MGBTCRC_SEED;
+    rxCrcPosition = RXCRCSTART;
+    rxDelimiterPosition = 1U;
+}
+
+static void ChangeLinkSpeed(uint32_t speed)
+{
+    MGBTPortSetLinkSpeed(speed);
+    linkSpeed = speed;
+    linkErrorCount = 0U;
+}
+
+//Counts frames that are dropped and runs of bytes that start no frame. Noise on a working link is
+//followed by good frames, which start the count over. Errors without them at a raised rate mean the
+//two ends no longer understand each other, the device then goes back to the default rate.
+//A central that stops getting answers does the same.
+static void CountReceiveError(void)
+{
+    if(linkErrorCount < LINKERRORLIMIT)
+    {
+        linkErrorCount++;
+    }
+    if((linkErrorCount >= LINKERRORLIMIT) &&
+       (linkSpeed != MGBTDEFAULTLINKSPEED))
+    {
+        MGBT_LOGW("Too many receive errors, falling back to the default link speed");
+        ChangeLinkSpeed(MGBTDEFAULTLINKSPEED);
+        linkSpeedState = LinkSpeedStable;
+    }
+}
+
+//The default rate doubled, up to the highest one both ports handle.
+static uint8_t IsSupportedLinkSpeed(uint32_t speed)
+{
+    uint8_t retVal = 0U;
+    uint32_t supportedSpeed;
+
+    for(supportedSpeed = MGBTDEFAULTLINKSPEED; supportedSpeed <= MGBTMAXLINKSPEED; supportedSpeed *= 2U)
+    {
+        if(speed == supportedSpeed)
+        {
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+//The switch happens once the accepting response has gone out at the old rate, on the next protocol run.
+//The central switches a few tens of milliseconds after it received that response and confirms with any
+//frame at the new rate, without it the old rate comes back.
+static void RunLinkSpeed(void)
+{
+    uint32_t now = MGBTPortGetTimeMs();
+
+    if((linkSpeedState == LinkSpeedSwitchPending) &&
+       (MGBTPortTxComplete() == 1U))
+    {
+        previousLinkSpeed = linkSpeed;
+        ChangeLinkSpeed(pendingLinkSpeed);
+        linkSpeedState = LinkSpeedConfirmPending;
+        linkSpeedSwitchTime = now;
+    }
+    else if((linkSpeedState == LinkSpeedConfirmPending) &&
+            ((now - linkSpeedSwitchTime) > LINKCONFIRMTIMEOUT))
+    {
+        MGBT_LOGW("Link speed not confirmed, going back");
+        ChangeLinkSpeed(previousLinkSpeed);
+        linkSpeedState = LinkSpeedStable;
+    }
+}
+
+void InitCommProto(void)
+{
+    MGBTPortInit();
+    rxFrameStartTime = MGBTPortGetTimeMs();
+}
+
+uint16_t GetCommandMaxDataLength(void)
+{
+    return COMMANDDATAMAXSIZE;
+}
+
+//Responses can go out while the next commands are still coming in. There has to be room
+//for a response in the framing of the next command, or of the link for frames sent on its own.
+uint8_t CanSendResponse(void)
+{
+    uint8_t framing = linkFraming;
+    if(commandQueueCount > commandTaken)
+    {
+        framing = commandQueue[(commandQueueHead + commandTaken) % MGBTCOMMANDQUEUELENGTH].command.framing;
+    }
+
+    return GetRoomForResponse(framing);
+}
+
+static void PutResponseWord(uint16_t offset, uint16_t value)
+{
+    uint8_t bytes[2] = {(uint8_t)(value & 0xFFU), (uint8_t)(value >> 8)};
+    MGBTPortWriteTx(offset, bytes, sizeof(bytes));
+}
+
+//Starts a response in the transmit path. Returns 0 when there is no room for a frame of the
+//largest size, nothing is written then and the caller tries again later.
+static uint8_t BeginFramedResponse(uint16_t cmdType, uint16_t status, uint8_t framing)
+{
+    uint8_t retVal = 0U;
+    if(GetRoomForResponse(framing) == 1U)
+    {
+        uint8_t crcBytes[4] = {(uint8_t)(status & 0xFFU), (uint8_t)(status >> 8),
+                               (uint8_t)(cmdType & 0xFFU), (uint8_t)(cmdType >> 8)};
+        txFraming = framing;
+        txStart = 0U;
+        if(framing == MGBTFramingV2)
+        {
+            txStart = V2STAGINGOFFSET;
+        }
+        MGBTPortWriteTx(txStart + TXCRCSTART, crcBytes, sizeof(crcBytes));
+        txCrc = MGBTCrcCalculate(crcBytes, sizeof(crcBytes));
+        txDataLength = 0U;
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+uint8_t BeginResponse(uint16_t cmdType, uint16_t status)
+{
+    return BeginFramedResponse(cmdType, status, linkFraming);
+}
+
+//Same as BeginResponse, tagged with the sequence number of the command so it can be matched
+//and in the framing the command came in.
+uint8_t BeginCommandResponse(const MGBTCommandView* command, uint16_t status)
+{
+    uint8_t retVal = 0U;
+    if(command != (MGBTCommandView*)0)
+    {
+        retVal = BeginFramedResponse((uint16_t)(command->cmdType | (command->sequence << MGBTSEQUENCESHIFT)), status, command->framing);
+    }
+
+    return retVal;
+}
+
+//Data beyond the maximum frame size is dropped.
+void AddResponseData(const void* data, uint16_t length)
+{
+    uint16_t maxDataLength = GetMaxDataLength(txFraming);
+    if(length > (maxDataLength - txDataLength))
+    {
+        length = maxDataLength - txDataLength;
+    }
+    MGBTPortWriteTx(txStart + TXHEADERLENGTH + txDataLength, (const uint8_t*)data, length);
+    txCrc = MGBTCrcUpdate(txCrc, (const uint8_t*)data, length);
+    txDataLength += length;
+}
+
+//Room left in the response under construction, which depends on its framing.
+uint16_t GetResponseSpaceLeft(void)
+{
+    return GetMaxDataLength(txFraming) - txDataLength;
+}
+
+//Echoes the data of a received command, straight from the receive ring.
+void AddResponseCommandData(const MGBTCommandView* command)
+{
+    if(command != (MGBTCommandView*)0)
+    {
+        AddResponseData(command->data.part[0], command->data.partLength[0]);
+        AddResponseData(command->data.part[1], command->data.partLength[1]);
+    }
+}
+
+//Layout: rate, 32 bit. An accepted rate is echoed, a rejected one is answered with status 0xFFFF
+//and the highest rate the device supports.
+void ProcessLinkSpeedCommand(const MGBTCommandView* command)
+{
+    uint32_t speed = 0U;
+
+    (void)CopyCommandData(command, 0U, &speed, sizeof(speed));
+    if(IsSupportedLinkSpeed(speed) == 1U)
+    {
+        (void)BeginCommandResponse(command, 0U);
+        AddResponseData(&speed, sizeof(speed));
+        FinishResponse();
+        if(speed != linkSpeed)
+        {
+            pendingLinkSpeed = speed;
+            linkSpeedState = LinkSpeedSwitchPending;
+        }
+    }
+    else
+    {
+        speed = MGBTMAXLINKSPEED;
+        (void)BeginCommandResponse(command, 0xFFFFU);
+        AddResponseData(&speed, sizeof(speed));
+        FinishResponse();
+    }
+}
+
+//Layout: topic, period in milliseconds, 16 bit. Period 0 unsubscribes. The period used is
+//echoed, it is raised to the shortest the topic allows. Unknown topics get status 0xFFFF.
+void ProcessSubscribeCommand(const MGBTCommandView* command, MGBTTopic* topics, uint8_t topicCount)
+{
+    MGBTTopic* topic = (MGBTTopic*)0;
+    uint8_t topicId = GetCommandDataByte(command, 0U);
+    uint16_t period = 0U;
+    uint8_t index;
+
+    for(index = 0U; index < topicCount; index++)
+    {
+        if(topics[index].topic == topicId)
+        {
+            topic = &topics[index];
+        }
+    }
+
+    if((topic != (MGBTTopic*)0) && (command->dataLength >= (sizeof(topicId) + sizeof(period))))
+    {
+        (void)CopyCommandData(command, sizeof(topicId), &period, sizeof(period));
+        if((period != 0U) && (period < topic->minPeriod))
+        {
+            period = topic->minPeriod;
+        }
+        topicsSubscribed = 1U;
+        topic->period = period;
+        //The first push goes out straight away, for on change topics as well.
+        topic->lastSent = MGBTPortGetTimeMs() - period;
+        topic->changed = 1U;
+        (void)BeginCommandResponse(command, 0U);
+        AddResponseData(&topicId, sizeof(topicId));
+        AddResponseData(&period, sizeof(period));
+    }
+    else
+    {
+        (void)BeginCommandResponse(command, 0xFFFFU);
+        AddResponseCommandData(command);
+    }
+    FinishResponse();
+}
+
+uint8_t IsTopicDue(const MGBTTopic* topic)
+{
+    uint8_t retVal = 0U;
+    uint16_t period = topic->defaultPeriod;
+
+    if(topicsSubscribed == 1U)
+    {
+        period = topic->period;
+        if((topic->onChange == 1U) && (topic->changed == 0U))
+        {
+            period = 0U;
+        }
+    }
+    if((period != 0U) && ((MGBTPortGetTimeMs() - topic->lastSent) >= period))
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+void MarkTopicChanged(MGBTTopic* topic)
+{
+    topic->changed = 1U;
+}
+
+void MarkTopicSent(MGBTTopic* topic)
+{
+    topic->changed = 0U;
+    topic->lastSent = MGBTPortGetTimeMs();
+}
+
+//Layout: number of commands that can be outstanding, protocol version, largest v2 data length.
+void AddProtocolInfoToResponse(void)
+{
+    uint8_t info[4] = {MGBTCOMMANDQUEUELENGTH, MGBTPROTOCOLVERSION,
+                       (uint8_t)(MGBTV2DATAMAXSIZE & 0xFFU), (uint8_t)(MGBTV2DATAMAXSIZE >> 8)};
+    AddResponseData(info, sizeof(info));
+}
+
+//Encodes the staged frame to the start of the transmit path, between delimiters. Returns the encoded length.
+static uint16_t EncodeResponse(uint16_t length)
+{
+    const uint8_t delimiter = MGBTCOBS_DELIMITER;
+    uint16_t encodedLength = 1U;
+    uint16_t position = 0U;
+
+    MGBTPortWriteTx(0U, &delimiter, 1U);
+    while(position <= length)
+    {
+        uint16_t blockLength = length - position;
+        uint16_t consumed;
+        uint8_t code;
+        if(blockLength > MGBTCOBS_BLOCKLENGTH)
+        {
+            blockLength = MGBTCOBS_BLOCKLENGTH;
+        }
+        MGBTPortReadTx(V2STAGINGOFFSET + position, codingBlock, blockLength);
+        code = MGBTCobsEncodeBlock(codingBlock, blockLength, &consumed);
+        MGBTPortWriteTx(encodedLength, &code, 1U);
+        MGBTPortWriteTx(encodedLength + 1U, codingBlock, code - 1U);
+        encodedLength += code;
+        position += consumed;
+    }
+    MGBTPortWriteTx(encodedLength, &delimiter, 1U);
+
+    return encodedLength + 1U;
+}
+
+void FinishResponse(void)
+{
+    PutResponseWord(txStart, txDataLength);
+    PutResponseWord(txStart + 2U, txCrc);
+    if(txFraming == MGBTFramingV2)
+    {
+        MGBTPortCommitTx(EncodeResponse(TXHEADERLENGTH + txDataLength));
+    }
+    else
+    {
+        MGBTPortCommitTx(TXHEADERLENGTH + txDataLength);
+    }
+}
+
+//The port lost received bytes it still held, queued commands may have been overwritten after their
+//CRC passed. They are all dropped, the central gets no answer and sends them again.
+static void CheckReceiveOverrun(void)
+{
+    if(MGBTPortReceiveOverrun() == 1U)
+    {
+        MGBT_LOGW("Receive buffer overrun, dropping the received frames");
+        commandQueueHead = 0U;
+        commandQueueCount = 0U;
+        commandTaken = 0U;
+        ResetData();
+        CountReceiveError();
+    }
+}
+
+static void ReleaseTakenCommand(void)
+{
+    if(commandTaken == 1U)
+    {
+        uint16_t frameLength = commandQueue[commandQueueHead].frameLength;
+        commandTaken = 0U;
+        commandQueueHead = (uint8_t)((commandQueueHead + 1U) % MGBTCOMMANDQUEUELENGTH);
+        commandQueueCount--;
+        MGBTPortReleaseReceived(frameLength, commandQueueCount);
+        rxFrameStart -= frameLength;
+    }
+}
+
+//Checks for an overrun first, so a command is never handed out with data the receiver wrote over.
+uint8_t CommandAvailable(void)
+{
+    uint8_t retVal = 0U;
+    CheckReceiveOverrun();
+    if(commandQueueCount > commandTaken)
+    {
+        retVal = 1U;
+    }
+    return retVal;
+}
+
+//Hands out the oldest command. It stays valid until the next call or the next run of the protocol.
+MGBTCommandView* GetAndClearCommand(void)
+{
+    MGBTCommandView* retVal = (MGBTCommandView*)0;
+
+    ReleaseTakenCommand();
+    if(commandQueueCount > 0U)
+    {
+        commandTaken = 1U;
+        retVal = &commandQueue[commandQueueHead].command;
+        linkFraming = retVal->framing;
+    }
+
+    return retVal;
+}
+
+uint8_t GetCommandDataByte(const MGBTCommandView* command, uint16_t index)
+{
+    uint8_t retVal = 0U;
+    if(command != (MGBTCommandView*)0)
+    {
+        if(index < command->data.partLength[0])
+        {
+            retVal = command->data.part[0][index];
+        }
+        else if((index - command->data.partLength[0]) < command->data.partLength[1])
+        {
+            retVal = command->data.part[1][index - command->data.partLength[0]];
+        }
+    }
+
+    return retVal;
+}
+
+//Copies part of the command data out, for fields that have to be aligned or contiguous.
+//Returns the number of bytes copied.
+uint16_t CopyCommandData(const MGBTCommandView* command, uint16_t offset, void* dst, uint16_t length)
+{
+    uint16_t retVal = 0U;
+    if((command != (MGBTCommandView*)0) &&
+       (offset < command->dataLength))
+    {
+        uint8_t* dstBytes = (uint8_t*)dst;
+        uint8_t part;
+
+        if(length > (command->dataLength - offset))
+        {
+            length = command->dataLength - offset;
+        }
+        for(part = 0U; part < 2U; part++)
+        {
+            if(offset < command->data.partLength[part])
+            {
+                uint16_t partLength = command->data.partLength[part] - offset;
+                if(partLength > (length - retVal))
+                {
+                    partLength = length - retVal;
+                }
+                memcpy(&dstBytes[retVal], &command->data.part[part][offset], partLength);
+                retVal += partLength;
+                offset = 0U;
+            }
+            else
+            {
+                offset -= command->data.partLength[part];
+            }
+        }
+    }
+
+    return retVal;
+}
+
+static uint8_t CheckAllDataArrived(void)
+{
+    uint8_t retVal = 0U;
+
+    if(rxScanLength >= 3U)
+    {
+        if(rxScanLength >= (RXHEADERLENGTH + GetFrameWord(1U)))
+        {
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+//Decodes the header and points the command at its data, nothing is copied.
+static uint8_t QueueCommand(uint8_t framing, uint16_t frameLength)
+{
+    uint8_t retVal = 0U;
+    QueuedCommand* entry = &commandQueue[(commandQueueHead + commandQueueCount) % MGBTCOMMANDQUEUELENGTH];
+    MGBTCommandView* command = &entry->command;
+    uint16_t cmdType = GetFrameWord(7U);
+
+    command->dataLength = GetFrameWord(1U);
+    command->crc = GetFrameWord(3U);
+    command->status = GetFrameWord(5U);
+    command->cmdType = cmdType & MGBTCOMMANDTYPEMASK;
+    command->sequence = (uint8_t)(cmdType >> MGBTSEQUENCESHIFT);
+    command->framing = framing;
+    if((command->dataLength <= GetMaxDataLength(framing)) &&
+       (rxCrc == command->crc))
+    {
+        GetFrameView(RXHEADERLENGTH, command->dataLength, &command->data);
+        entry->frameLength = rxSkipLength + frameLength;
+        rxSkipLength = 0U;
+        commandQueueCount++;
+        linkErrorCount = 0U;
+        retVal = 1U;
+        if(linkSpeedState == LinkSpeedConfirmPending)
+        {
+            linkSpeedState = LinkSpeedStable;
+        }
+        MGBT_LOGI("Command data length %d of type %d, sequence %d", command->dataLength, command->cmdType, command->sequence);
+    }
+    else
+    {
+        MGBT_LOGE("Received CRC 0x%.4X does not match calculated CRC 0x%.4X", command->crc, rxCrc);
+    }
+
+    return retVal;
+}
+
+static void UpdateFrameCrc(uint16_t crcEnd)
+{
+    while(crcEnd > rxCrcPosition)
+    {
+        const uint8_t* data;
+        uint16_t length = MGBTPortPeekReceived(rxFrameStart + rxCrcPosition, &data);
+        if(length > (crcEnd - rxCrcPosition))
+        {
+            length = crcEnd - rxCrcPosition;
+        }
+        rxCrc = MGBTCrcUpdate(rxCrc, data, length);
+        rxCrcPosition += length;
+    }
+}
+
+//Covers the bytes of a v1 frame that arrived since the last call, up to the end of the frame once its length is known.
+static void UpdateReceiveCrc(void)
+{
+    if(GetFrameByte(0U) == V1HEADERBYTE)
+    {
+        uint16_t crcEnd = rxScanLength;
+
+        if(rxScanLength >= 3U)
+        {
+            uint16_t frameEnd = (uint16_t)(RXHEADERLENGTH + GetFrameWord(1U));
+            if(crcEnd > frameEnd)
+            {
+                crcEnd = frameEnd;
+            }
+        }
+        UpdateFrameCrc(crcEnd);
+    }
+}
+
+static void ReceiveData(void)
+{
+    uint16_t receivedLength = MGBTPortGetReceivedLength();
+
+    if(receivedLength > (rxFrameStart + rxScanLength))
+    {
+        if(rxScanLength == 0U)
+        {
+            rxFrameStartTime = MGBTPortGetTimeMs();
+        }
+        rxScanLength = receivedLength - rxFrameStart;
+        UpdateReceiveCrc();
+    }
+}
+
+//Bytes that are not part of a command. They go as soon as no command is queued before them.
+static void ReleaseSkipped(void)
+{
+    if((commandQueueCount == 0U) &&
+       (rxSkipLength > 0U))
+    {
+        MGBTPortReleaseReceived(rxSkipLength, commandQueueCount);
+        rxFrameStart -= rxSkipLength;
+        rxSkipLength = 0U;
+    }
+}
+
+static void SkipFrameBytes(uint16_t length)
+{
+    rxSkipLength += length;
+    StartNextFrame(length);
+    ReleaseSkipped();
+    UpdateReceiveCrc();
+}
+
+//Returns the offset of the delimiter closing the v2 frame, 0 while it has not arrived.
+static uint16_t FindFrameEnd(void)
+{
+    uint16_t retVal = 0U;
+
+    while((retVal == 0U) &&
+          (rxDelimiterPosition < rxScanLength))
+    {
+        const uint8_t* data;
+        const uint8_t* delimiter;
+        uint16_t length = MGBTPortPeekReceived(rxFrameStart + rxDelimiterPosition, &data);
+        if(length > (rxScanLength - rxDelimiterPosition))
+        {
+            length = rxScanLength - rxDelimiterPosition;
+        }
+        delimiter = memchr(data, MGBTCOBS_DELIMITER, length);
+        if(delimiter != (const uint8_t*)0)
+        {
+            length = (uint16_t)(delimiter - data);
+            retVal = rxDelimiterPosition + length;
+        }
+        rxDelimiterPosition += length;
+    }
+
+    return retVal;
+}
+
+//Decodes the v2 frame ending at frameEnd in place, right behind its leading delimiter, which
+//gives the v1 layout. Returns the decoded length including the delimiter, 0 for a corrupt frame.
+static uint16_t DecodeFrame(uint16_t frameEnd)
+{
+    uint16_t retVal = 0U;
+    uint16_t position = 1U;
+    uint16_t decodedLength = 1U;
+    MGBTCobsDecoder decoder;
+
+    MGBTCobsDecodeInit(&decoder);
+    while(position < frameEnd)
+    {
+        const uint8_t* data;
+        uint16_t decodedPart;
+        uint16_t length = MGBTPortPeekReceived(rxFrameStart + position, &data);
+        if(length > (frameEnd - position))
+        {
+            length = frameEnd - position;
+        }
+        if(length > sizeof(codingBlock))
+        {
+            length = sizeof(codingBlock);
+        }
+        //Decoding never writes more than it reads, so the bytes still to be decoded are not overwritten.
+        decodedPart = MGBTCobsDecode(&decoder, data, length, codingBlock);
+        MGBTPortReplaceReceived(rxFrameStart + decodedLength, codingBlock, decodedPart);
+        decodedLength += decodedPart;
+        position += length;
+    }
+
+    if(MGBTCobsDecodeComplete(&decoder) == 1U)
+    {
+        retVal = decodedLength;
+    }
+
+    return retVal;
+}
+
+//A v2 frame is handled as soon as its closing delimiter is in, a corrupt one is skipped right away.
+//Frames are sent with a delimiter on both sides. A good frame takes its closing delimiter along,
+//after a corrupt one it is left to open the next frame, the corrupt one may have been cut off by it.
+static uint8_t CheckV2Frame(void)
+{
+    uint8_t retVal = 0U;
+    uint16_t frameEnd = FindFrameEnd();
+
+    if(frameEnd == 1U)
+    {
+        //Two delimiters in a row, the first one was left behind by a corrupt frame.
+        SkipFrameBytes(1U);
+        retVal = 1U;
+    }
+    else if(frameEnd > 1U)
+    {
+        uint16_t decodedLength = DecodeFrame(frameEnd);
+        uint8_t frameQueued = 0U;
+        if((decodedLength >= RXHEADERLENGTH) &&
+           (decodedLength == (RXHEADERLENGTH + GetFrameWord(1U))))
+        {
+            UpdateFrameCrc(decodedLength);
+            frameQueued = QueueCommand(MGBTFramingV2, frameEnd + 1U);
+        }
+
+        if(frameQueued == 1U)
+        {
+            StartNextFrame(frameEnd + 1U);
+            UpdateReceiveCrc();
+        }
+        else
+        {
+            SkipFrameBytes(frameEnd);
+            CountReceiveError();
+        }
+        retVal = 1U;
+    }
+    else if(rxScanLength > MGBTV2FRAMEMAXLENGTH)
+    {
+        SkipFrameBytes(rxScanLength);
+        CountReceiveError();
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+//Offset of the next byte from offset 1 on that can start a frame, the scanned length when there is none.
+//The bytes before it are dropped as one error, not one per byte. Behind a v1 frame only the next v1
+//header is looked for.
+static uint16_t FindNextHeader(uint8_t v1Only)
+{
+    uint16_t retVal = 1U;
+    uint8_t found = 0U;
+
+    while((found == 0U) &&
+          (retVal < rxScanLength))
+    {
+        const uint8_t* data;
+        uint16_t index = 0U;
+        uint16_t length = MGBTPortPeekReceived(rxFrameStart + retVal, &data);
+        if(length > (rxScanLength - retVal))
+        {
+            length = rxScanLength - retVal;
+        }
+        while((found == 0U) &&
+              (index < length))
+        {
+            if((data[index] == V1HEADERBYTE) ||
+               ((v1Only == 0U) && (data[index] == MGBTCOBS_DELIMITER)))
+            {
+                found = 1U;
+            }
+            else
+            {
+                index++;
+            }
+        }
+        retVal += index;
+    }
+
+    return retVal;
+}
+
+//Bytes that cannot start a frame, up to the next one that can.
+static void SkipJunk(void)
+{
+    SkipFrameBytes(FindNextHeader(0U));
+    CountReceiveError();
+}
+
+//Drops a v1 frame that cannot be handled. Its length is not covered by the CRC, it is only
+//trusted while the bytes behind the frame can start the next one. Otherwise the search for the
+//next frame starts right behind its header byte, a header byte in the dropped data starts a
+//frame that fails in turn.
+static void ResyncV1Frame(void)
+{
+    uint16_t skipLength = 0U;
+
+    if(rxScanLength >= 3U)
+    {
+        uint16_t frameLength = RXHEADERLENGTH + GetFrameWord(1U);
+        if((rxScanLength == frameLength) ||
+           ((rxScanLength > frameLength) &&
+            ((GetFrameByte(frameLength) == V1HEADERBYTE) ||
+             (GetFrameByte(frameLength) == MGBTCOBS_DELIMITER))))
+        {
+            skipLength = frameLength;
+        }
+    }
+    if(skipLength == 0U)
+    {
+        skipLength = FindNextHeader(1U);
+    }
+    SkipFrameBytes(skipLength);
+    CountReceiveError();
+}
+
+//A v1 frame with a bad CRC is dropped as soon as it is complete, the frames behind it are kept.
+//A header with a length no v1 frame can have is skipped as junk, along with the bytes behind it.
+static uint8_t CheckV1Frame(void)
+{
+    uint8_t retVal = 0U;
+    uint16_t frameLength = RXHEADERLENGTH + GetFrameWord(1U);
+
+    if((rxScanLength >= 3U) &&
+       (GetFrameWord(1U) > COMMANDDATAMAXSIZE))
+    {
+        SkipJunk();
+        retVal = 1U;
+    }
+    else if(CheckAllDataArrived() == 1U)
+    {
+        if(QueueCommand(MGBTFramingV1, frameLength) == 1U)
+        {
+            StartNextFrame(frameLength);
+            UpdateReceiveCrc();
+        }
+        else
+        {
+            ResyncV1Frame();
+        }
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+//Queues every complete frame, commands sent back to back are all picked up in one go.
+//Bytes that cannot start a frame are skipped as one run.
+static void CheckReceivedData(void)
+{
+    uint8_t frameHandled = 1U;
+
+    while((frameHandled == 1U) &&
+          (commandQueueCount < MGBTCOMMANDQUEUELENGTH) &&
+          (rxScanLength > 0U))
+    {
+        uint8_t headerByte = GetFrameByte(0U);
+        if(headerByte == V1HEADERBYTE)
+        {
+            frameHandled = CheckV1Frame();
+        }
+        else if(headerByte == MGBTCOBS_DELIMITER)
+        {
+            frameHandled = CheckV2Frame();
+        }
+        else
+        {
+            SkipJunk();
+        }
+    }
+}
+
+//A v1 frame that does not complete in time is dropped, the frames that arrived behind it are kept.
+//Bytes can only be dropped from the front of the receive buffer, so this waits until the commands
+//before it have been handled.
+static void CheckReceiveTimeout(void)
+{
+    if((rxScanLength > 0U) &&
+       (GetFrameByte(0U) == V1HEADERBYTE) &&
+       (commandQueueCount == 0U) &&
+       ((MGBTPortGetTimeMs() - rxFrameStartTime) > RECEIVETIMEOUT))
+    {
+        MGBT_LOGW("Timeout on receive state");
+        ResyncV1Frame();
+    }
+}
+
+void RunCommProto(void)
+{
+    ReleaseTakenCommand();
+    CheckReceiveOverrun();
+    ReleaseSkipped();
+    ReceiveData();
+    CheckReceivedData();
+    CheckReceiveTimeout();
+    RunLinkSpeed();
+}
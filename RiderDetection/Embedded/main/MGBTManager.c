@@ -23,10 +23,14 @@
 static const char* AppName = "MGBTManager";
 
 static MGBTDeviceData deviceList[MAXDEVICES] = {0};
-static MGBTCommandData pendingResponse = {0};
-static uint8_t lastResponseSent = 0U;
+//Command the device list packets answer to, with its sequence number.
+static uint16_t listCmdType = NoOperation;
+static uint16_t packetDataLength = 0U;
 static uint32_t lastTimeCleanup = 0U;
-static uint32_t lastTimeClosestDevice = 0U;
+//Once subscribed to, the closest device is only announced when another device has become the closest.
+static MGBTTopic closestDeviceTopic = {GetClosestDevice, 1U, 0U, CLOSESTDEVICEANNOUNCEINTERVAL, CLOSESTDEVICEMINPERIOD, 0U, 0U};
+static uint8_t lastClosestAddress[ESP_BD_ADDR_LEN] = {0U};
+static uint8_t lastClosestPresent = 0U;
 static uint32_t scanStartTime = 0U;
 static uint32_t lastProgressPacketTime = 0U;
 static uint8_t startLightState = 0U;
@@ -42,7 +46,7 @@ void InitManager(void)
 {
     InitCommProto();
     lastTimeCleanup = GetTimestampMs();
-    lastTimeClosestDevice = lastTimeCleanup;
+    closestDeviceTopic.lastSent = lastTimeCleanup;
 
     gpio_config_t io_conf;
 	//disable interrupt
@@ -140,8 +144,9 @@ static void AddDeviceToListAtIndex(uint16_t index, uint8_t* address, uint8_t all
     }
 }
 
-static void AddDeviceToList(MGBTAllowedDeviceEntry* entry, uint8_t allowed)
+static uint16_t AddDeviceToList(MGBTAllowedDeviceEntry* entry, uint8_t allowed)
 {
+    uint16_t status = 0U;
     uint16_t firstFreeIndex = MAXDEVICES;
     uint16_t indexFound = MAXDEVICES;
 
@@ -152,12 +157,12 @@ static void AddDeviceToList(MGBTAllowedDeviceEntry* entry, uint8_t allowed)
         if(firstFreeIndex != MAXDEVICES)
         {
             AddDeviceToListAtIndex(firstFreeIndex, entry->address, allowed, entry->measuredPowerCorrection);
-            pendingResponse.status = 0U;
+            status = 0U;
             esp_log_buffer_hex("Added device:", entry->address, ESP_BD_ADDR_LEN);
         }
         else
         {
-            pendingResponse.status = 0xFFFEU;
+            status = 0xFFFEU;
         }
     }
     else
@@ -166,17 +171,20 @@ static void AddDeviceToList(MGBTAllowedDeviceEntry* entry, uint8_t allowed)
         if(device->allowed == 0U)
         {
             device->allowed = 0U;
-            pendingResponse.status = 0U;
+            status = 0U;
         }
         else
         {
-            pendingResponse.status = 0xFFFFU;
+            status = 0xFFFFU;
         }
     }
+
+    return status;
 }
 
-static void RemoveDeviceFromList(uint8_t* address)
+static uint16_t RemoveDeviceFromList(uint8_t* address)
 {
+    uint16_t status = 0xFFFFU;
     uint16_t firstFreeIndex = MAXDEVICES;
     uint16_t indexFound = MAXDEVICES;
 
@@ -185,17 +193,15 @@ static void RemoveDeviceFromList(uint8_t* address)
     if(indexFound != MAXDEVICES)
     {
         ClearDeviceEntry(&deviceList[indexFound]);
-        pendingResponse.status = 0U;
-    }
-    else
-    {
-        pendingResponse.status = 0xFFFFU;
+        status = 0U;
     }
+
+    return status;
 }
 
 static uint8_t SpaceLeftInPacket(void)
 {
-    return COMMANDDATAMAXSIZE - pendingResponse.dataLength;
+    return COMMANDDATAMAXSIZE - packetDataLength;
 }
 
 static void PrepareTransportPacket(uint8_t totalDevices)
@@ -226,14 +232,29 @@ static void StartListingAllowedDevices(void)
     managerState = MgBtMState_ListingAllowedDevices;
 }
 
+//Starts the next device list packet in the transmit path, the devices are added as they are found.
 static void SendNextPacket(void)
 {
-    ClearPacketData(&pendingResponse);
-    pendingResponse.status = 1U;
-    pendingResponse.data[0] = currentPacket;
+    uint8_t packetHeader[2] = {currentPacket, totalPackets};
+    (void)BeginResponse(listCmdType, 1U);
+    AddResponseData(packetHeader, sizeof(packetHeader));
+    packetDataLength = sizeof(packetHeader);
     currentPacket++;
-    pendingResponse.data[1] = totalPackets;
-    pendingResponse.dataLength = 2U;
+}
+
+static void AddDeviceToPacket(MGBTDeviceData* device)
+{
+    AddResponseData(&device->device, sizeof(MGBTDevice));
+    packetDataLength += sizeof(MGBTDevice);
+}
+
+static void FinishPacket(void)
+{
+    if(currentDeviceIndex >= MAXDEVICES)
+    {
+        managerState = MgBtMState_Idle;
+    }
+    FinishResponse();
 }
 
 static void SendListAllowedDevicePacket(void)
@@ -246,8 +267,7 @@ static void SendListAllowedDevicePacket(void)
         MGBTDeviceData* device = &deviceList[currentDeviceIndex];
         if(device->allowed != 0U)
         {
-            memcpy(&pendingResponse.data[pendingResponse.dataLength], &device->device, sizeof(MGBTDevice));
-            pendingResponse.dataLength += sizeof(MGBTDevice);
+            AddDeviceToPacket(device);
         }
         currentDeviceIndex++;
     }
@@ -255,10 +275,7 @@ static void SendListAllowedDevicePacket(void)
 
     ESP_LOGI(AppName, "Sending transport packet: AllowedDev, device index: %d", currentDeviceIndex);
 
-    if(currentDeviceIndex >= MAXDEVICES)
-    {
-        lastResponseSent = 1U;
-    }
+    FinishPacket();
 }
 
 static uint32_t GetProgressInterval(void)
@@ -300,11 +317,10 @@ static void SendListAllDevicesProgress(void)
         ESP_LOGI(AppName, "Sending progress packet");
         lastProgressPacketTime = GetTimestampMs();
         uint32_t progress = ((GetTimestampMs() - scanStartTime) * 100U) / GetScanDuration();
-        pendingResponse.dataLength = 2U;
-        pendingResponse.status = 8U;
-        pendingResponse.data[0] = (uint8_t)progress;
-        pendingResponse.data[1] = CountDevices(2U, 2U);
-
+        uint8_t progressData[2] = {(uint8_t)progress, CountDevices(2U, 2U)};
+        (void)BeginResponse(listCmdType, 8U);
+        AddResponseData(progressData, sizeof(progressData));
+        FinishResponse();
     }
 }
 
@@ -328,17 +344,13 @@ static void SendListAllDevicesPacket(void)
             MGBTDeviceData* device = &deviceList[currentDeviceIndex];
             if(IsDeviceEntryEmpty(device) == 0U)
             {
-                memcpy(&pendingResponse.data[pendingResponse.dataLength], &device->device, sizeof(MGBTDevice));
-                pendingResponse.dataLength += sizeof(MGBTDevice);
+                AddDeviceToPacket(device);
             }
             currentDeviceIndex++;
         }
 
         ESP_LOGI(AppName, "Sending transport packet: AllDev, device index: %d", currentDeviceIndex);
-        if(currentDeviceIndex >= MAXDEVICES)
-        {
-            lastResponseSent = 1U;
-        }
+        FinishPacket();
 
     }
 }
@@ -371,20 +383,38 @@ static MGBTDeviceData* GetClosestDeviceFromList(void)
     return retVal;
 }
 
-static void PrepareClosestDeviceData(void)
+//The sequence number is 0 when the device announces the closest device on its own.
+static void SendClosestDeviceData(uint8_t sequence)
 {
+    uint16_t cmdType = (uint16_t)(GetClosestDevice | (sequence << MGBTSEQUENCESHIFT));
     MGBTDeviceData* device = GetClosestDeviceFromList();
     if(device != (MGBTDeviceData*)0)
     {
-        memcpy(pendingResponse.data, &device->device, sizeof(MGBTDevice));
-        pendingResponse.dataLength = sizeof(MGBTDevice);
-        pendingResponse.status = 0U;
+        (void)BeginResponse(cmdType, 0U);
+        AddResponseData(&device->device, sizeof(MGBTDevice));
     }
     else
     {
-        pendingResponse.status = 0xFFFFU;
+        (void)BeginResponse(cmdType, 0xFFFFU);
+    }
+    FinishResponse();
+}
+
+static void CheckClosestDeviceChanged(void)
+{
+    MGBTDeviceData* device = GetClosestDeviceFromList();
+    uint8_t present = (device != (MGBTDeviceData*)0) ? 1U : 0U;
+
+    if((present != lastClosestPresent) ||
+       ((present == 1U) && (BTAddressEquals(device->device.address, lastClosestAddress) == 0U)))
+    {
+        lastClosestPresent = present;
+        if(present == 1U)
+        {
+            memcpy(lastClosestAddress, device->device.address, ESP_BD_ADDR_LEN);
+        }
+        MarkTopicChanged(&closestDeviceTopic);
     }
-    lastResponseSent = 1U;
 }
 
 static void ProcessSetStartLight(uint8_t data)
@@ -392,72 +422,90 @@ static void ProcessSetStartLight(uint8_t data)
 	startLightState = data;
 }
 
-static void ProcessCommand(MGBTCommandData* command)
+//Answers straight into the transmit path, commands that change the device list get their data echoed back.
+static void ProcessCommand(MGBTCommandView* command)
 {
-    lastResponseSent = 0U;
     switch(command->cmdType)
     {
         case AddAllowedDevice:
         {
             ESP_LOGI(AppName, "Add to allowed devices");
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
+            uint16_t status = 0xFEFEU;
             if (command->dataLength >= sizeof(MGBTAllowedDeviceEntry))
             {
-            	AddDeviceToList((MGBTAllowedDeviceEntry*)command->data, 1U);
+            	MGBTAllowedDeviceEntry entry;
+            	(void)CopyCommandData(command, 0U, &entry, sizeof(entry));
+            	status = AddDeviceToList(&entry, 1U);
             }
-            else
-            {
-            	pendingResponse.status = 0xFEFEU;
-            }
-            lastResponseSent = 1U;
+            (void)BeginCommandResponse(command, status);
+            AddResponseCommandData(command);
+            FinishResponse();
             break;
         }
         case RemoveAllowedDevice:
         {
             ESP_LOGI(AppName, "Remove from allowed devices");
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            RemoveDeviceFromList(command->data);
-            lastResponseSent = 1U;
+            uint8_t address[ESP_BD_ADDR_LEN] = {0U};
+            (void)CopyCommandData(command, 0U, address, sizeof(address));
+            (void)BeginCommandResponse(command, RemoveDeviceFromList(address));
+            AddResponseCommandData(command);
+            FinishResponse();
             break;
         }
         case ClearAllowedDevices:
         {
         	ESP_LOGI(AppName, "Clear allowed devices");
-			memcpy(&pendingResponse, command, GetCommandDataSize(command));
 			memset(deviceList, 0U, sizeof(deviceList));
-			lastResponseSent = 1U;
+			(void)BeginCommandResponse(command, command->status);
+			AddResponseCommandData(command);
+			FinishResponse();
         	break;
         }
         case ListAllowedDevices:
         {
             ESP_LOGI(AppName, "List allowed devices");
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
+            listCmdType = (uint16_t)(command->cmdType | (command->sequence << MGBTSEQUENCESHIFT));
             StartListingAllowedDevices();
             break;
         }
         case ListDetectedDevices:
         {
             ESP_LOGI(AppName, "List detected devices");
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
+            listCmdType = (uint16_t)(command->cmdType | (command->sequence << MGBTSEQUENCESHIFT));
+            //Acknowledge straight away, the scan takes a while before the first progress packet.
+            (void)BeginCommandResponse(command, command->status);
+            AddResponseCommandData(command);
+            FinishResponse();
             StartListingAllDevices();
-            //lastResponseSent = 1U;
             break;
         }
         case GetClosestDevice:
         {
             ESP_LOGI(AppName, "Get closest device");
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            PrepareClosestDeviceData();
+            SendClosestDeviceData(command->sequence);
             break;
         }
         case SetStartLightState:
 		{
 			ESP_LOGI(AppName, "Set start light state");
-			memcpy(&pendingResponse, command, GetCommandDataSize(command));
-			ProcessSetStartLight(command->data[0]);
-			lastResponseSent = 1U;
+			ProcessSetStartLight(GetCommandDataByte(command, 0U));
+			(void)BeginCommandResponse(command, command->status);
+			AddResponseCommandData(command);
+			FinishResponse();
 			break;
 		}
+        case SetLinkSpeed:
+        {
+            ESP_LOGI(AppName, "Set link speed");
+            ProcessLinkSpeedCommand(command);
+            break;
+        }
+        case Subscribe:
+        {
+            ESP_LOGI(AppName, "Subscribe");
+            ProcessSubscribeCommand(command, &closestDeviceTopic, 1U);
+            break;
+        }
         default:
         {
             break;
@@ -497,14 +545,14 @@ static void ManagerIdleWork(void)
         CleanUpDeviceList();
 
     }
-    else if((GetTimestampMs() - lastTimeClosestDevice) >= CLOSESTDEVICEANNOUNCEINTERVAL)
+    else
     {
-        if((CanSendResponse() == 1U) && (pendingResponse.cmdType == NoOperation))
+        CheckClosestDeviceChanged();
+        if((IsTopicDue(&closestDeviceTopic) == 1U) &&
+           (CanSendResponse() == 1U))
         {
-            pendingResponse.cmdType = GetClosestDevice;
-            PrepareClosestDeviceData();
-            lastResponseSent = 1U;
-            lastTimeClosestDevice = GetTimestampMs();
+            SendClosestDeviceData(0U);
+            MarkTopicSent(&closestDeviceTopic);
         }
     }
 }
@@ -516,12 +564,18 @@ static void ProcessManagerWork(void)
     {
         case MgBtMState_ListingAllowedDevices:
         {
-            SendListAllowedDevicePacket();
+            if(CanSendResponse() == 1U)
+            {
+                SendListAllowedDevicePacket();
+            }
             break;
         }
         case MgBtMState_ListingAllDetectedDevices:
         {
-            SendListAllDevicesPacket();
+            if(CanSendResponse() == 1U)
+            {
+                SendListAllDevicesPacket();
+            }
             break;
         }
         default:
@@ -537,30 +591,20 @@ static void ProcessManagerWork(void)
     //ESP_LOGI(AppName, "mState2: %d", managerState);
 }
 
-static void SendPendingResponse(void)
-{
-    if(pendingResponse.cmdType != NoOperation)
-    {
-        SendResponse(&pendingResponse, lastResponseSent);
-        if(lastResponseSent == 1U)
-        {
-            memset(&pendingResponse, 0, sizeof(MGBTCommandData));
-            managerState = MgBtMState_Idle;
-        }
-    }
-}
-
+//Commands are read in place from the receive buffer and answered in the order they arrived.
+//Device list packets are built straight into the transmit path once no command is waiting.
 void RunManager(void)
 {
     RunCommProto();
-    if(CommandAvailable() != 0U)
+    while((CommandAvailable() != 0U) &&
+          (CanSendResponse() != 0U))
     {
         ProcessCommand(GetAndClearCommand());
     }
-    ProcessManagerWork();
-    if(CanSendResponse() != 0U)
+
+    if(CommandAvailable() == 0U)
     {
-        SendPendingResponse();
+        ProcessManagerWork();
     }
 }
 
@@ -15,6 +15,8 @@
 #define DEVICELISTSCANTIME 5000U
 #define DEVICELISTPROGRESSINTERVAL 250U
 #define CLOSESTDEVICEANNOUNCEINTERVAL 1000U
+//Shortest period a central can subscribe to the closest device with.
+#define CLOSESTDEVICEMINPERIOD 100U
 #define DEVICELISTCLEANINTERVAL 10000U
 
 typedef enum
@@ -2,3 +2,7 @@
 # "main" pseudo-component makefile.
 #
 # (Uses default behaviour of compiling all source files in directory, adding 'include' to include path.)
+
+# The MGBT protocol is shared with the Timer and built from the top level of the repository.
+COMPONENT_SRCDIRS := . ../../../MGBTProtocol/Src ../../../MGBTProtocol/Ports/ESP32
+COMPONENT_ADD_INCLUDEDIRS := . ../../../MGBTProtocol/Inc ../../../MGBTProtocol/Ports/ESP32
@@ -1,13 +0,0 @@
-/*
- * platformconfig.h
- *
- *  Created on: 10 Jan 2021
- *      Author: cdromke
- */
-
-#ifndef MAIN_PLATFORMCONFIG_H_
-#define MAIN_PLATFORMCONFIG_H_
-
-#include "sdkconfig.h"
-
-#endif /* MAIN_PLATFORMCONFIG_H_ */
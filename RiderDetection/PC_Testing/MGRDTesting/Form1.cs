@@ -184,18 +184,21 @@ namespace MGRDTesting
             try
             {
                 var reader = new BinaryReader(new MemoryStream(cmd.data));
+                long length = reader.BaseStream.Length;
 
-                while (reader.BaseStream.Position < reader.BaseStream.Length)
-                {
-                    UInt32 time = reader.ReadUInt32();
-                    byte timeType = reader.ReadByte();
+                // One time per frame: 32 bit value and type, newer firmware appends the full 64 bit
+                // value in microseconds and, for pushed times, the event sequence number. The 32 bit
+                // value of a lap time is in milliseconds.
+                UInt32 time = reader.ReadUInt32();
+                byte timeType = reader.ReadByte();
+                string fullTime = (length >= 13) ? $", full time: {reader.ReadUInt64()}us" : string.Empty;
+                string sequence = (length >= 17) ? $", sequence: {reader.ReadUInt32()}" : string.Empty;
 
-                    InvocationHelper.InvokeIfRequired(this, new Action(() =>
-                    {
-                        AddLineToStatus($"Got time: {time}");
-                        AddLineToStatus($"Of type: {timeType}");
-                    }));
-                }
+                InvocationHelper.InvokeIfRequired(this, new Action(() =>
+                {
+                    AddLineToStatus($"Got time: {time}{fullTime}{sequence}");
+                    AddLineToStatus($"Of type: {timeType}");
+                }));
             }
             catch (Exception ex)
             {
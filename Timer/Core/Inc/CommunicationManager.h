@@ -8,7 +8,11 @@
 #ifndef INC_COMMUNICATIONMANAGER_H_
 #define INC_COMMUNICATIONMANAGER_H_
 
+#include "TimeMgmt.h"
+
 #define TIMEUPDATEPERIOD 1000U
+//Shortest period a central can subscribe to the current time with.
+#define TIMEUPDATEMINPERIOD 100U
 
 typedef enum
 {
@@ -26,10 +30,7 @@ typedef enum
 } CommManagerState;
 
 void RunCommunicationManager(void);
-void CommMgrSendTimeValue(CommTimeType timeType, uint32_t timeValue);
+uint8_t CommMgrSendTimeValue(CommTimeType timeType, Timestamp1us timeValue, uint32_t traceId);
 uint8_t CommMgrIsReadyToSendNextTime(void);
-uint8_t CommMgrHasNewDisplayUpdate(void);
-uint32_t CommMgrGetNewDisplayValue(void);
-uint8_t CommMgrGetNewConfig(void);
 
 #endif /* INC_COMMUNICATIONMANAGER_H_ */
@@ -52,4 +52,5 @@ void RunAutoConfiguration(void);
 uint8_t RTCInitSuccesful(void);
 uint32_t GetConfigBCDDisplay(void);
 uint8_t SetNewConfigMode(uint8_t mode);
+void RunStatusOutputs(void);
 #endif /* INC_CONFIGURATION_H_ */
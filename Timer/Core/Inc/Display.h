@@ -9,6 +9,7 @@
 #define INC_DISPLAY_H_
 
 #include <stdint.h>
+#include "TimeMgmt.h"
 
 typedef enum
 {
@@ -18,7 +19,7 @@ typedef enum
 
 void UpdateDisplay(uint32_t newTimeInMs, uint32_t displayDurationInMs, DisplayTimeExpiredAction whatsNext);
 void RunDisplay(void);
-void ResetRunningDisplayTime(uint32_t startTime);
+void ResetRunningDisplayTime(Timestamp1us startTime);
 
 #endif /* INC_DISPLAY_H_ */
 
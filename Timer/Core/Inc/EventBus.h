@@ -0,0 +1,50 @@
+/*
+ * EventBus.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Publish/subscribe queue for events between the modules of the main loop.
+ *  Events go into one ring, every subscriber reads them through a cursor of
+ *  its own and only gets the types it subscribed to in EventBus.c. A
+ *  subscriber that falls behind loses its oldest events, they are counted.
+ *  Interrupt handlers do not publish, they have queues of their own.
+ */
+
+#ifndef INC_EVENTBUS_H_
+#define INC_EVENTBUS_H_
+
+#include <stdint.h>
+
+#define EVENTBUSLENGTH 16U //Must be a power of two
+
+typedef enum
+{
+    EventLapFinished = 0U, //Value: index of the lap in laps
+    EventRunStarted = 1U, //Value: index of the lap in laps
+    EventPpsTick = 2U, //Value: PPS edges counted since power up
+    EventDisplayTime = 3U, //Value: time sent by the central to show, in ms
+    EventNewConfig = 4U, //Value: operation mode asked for by the central
+    NbOfEventTypes = 5U
+} EventType;
+
+typedef enum
+{
+    SubscriberRaceTiming = 0U,
+    SubscriberCommunication = 1U,
+    SubscriberStatusLed = 2U,
+    NbOfEventSubscribers = 3U
+} EventSubscriber;
+
+typedef struct
+{
+    uint32_t value;
+    uint8_t type;
+} BusEvent;
+
+void EventBusPublish(EventType type, uint32_t value);
+//Returns 1 and the oldest unread event of a subscribed type, 0 when there is none.
+uint8_t EventBusGet(EventSubscriber subscriber, BusEvent* event);
+//Events of a subscribed type that were overwritten before the subscriber read them.
+uint32_t EventBusGetDropCount(EventSubscriber subscriber);
+
+#endif /* INC_EVENTBUS_H_ */
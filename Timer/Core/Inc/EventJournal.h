@@ -0,0 +1,48 @@
+/*
+ * EventJournal.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Append-only journal of sensor triggers in the flash pages of FlashPort.h,
+ *  so events survive a reset and a lost link. The pages are used as a ring,
+ *  every page is erased once per lap around it, which spreads the wear evenly.
+ *  The oldest page is given up when the ring is full. Records carry a CRC, a
+ *  record cut short by a reset is skipped.
+ */
+
+#ifndef INC_EVENTJOURNAL_H_
+#define INC_EVENTJOURNAL_H_
+
+#include <stdint.h>
+#include "TimeMgmt.h"
+#include "SensorEventQueue.h"
+#include "FlashPort.h"
+
+#define EVENTJOURNALRECORDLENGTH 16U
+//The first slot of every page holds its header.
+#define EVENTJOURNALSLOTSPERPAGE (FLASHPORTPAGESIZE / EVENTJOURNALRECORDLENGTH)
+#define EVENTJOURNALRECORDSPERPAGE (EVENTJOURNALSLOTSPERPAGE - 1U)
+#define EVENTJOURNALPENDINGLENGTH 8U //Must be a power of two
+
+typedef struct
+{
+    uint32_t sequence; //Numbers the events from 1 on, across resets
+    Timestamp1us time;
+    uint8_t sensor; //SensorInput that triggered
+} JournalEvent;
+
+//Finds the end of the journal, call once before the sensor interrupts are enabled.
+void EventJournalInit(void);
+//Called from the EXTI handlers, the event is written to flash by RunEventJournal.
+void EventJournalRecord(SensorInput input, const SensorTimestamp* timeStamp);
+void RunEventJournal(void);
+//Writes an event straight away. Returns 0 when the flash could not be written.
+uint8_t EventJournalAppend(uint8_t sensor, Timestamp1us time);
+//Finds the oldest event still in the journal with a sequence number of at least fromSequence.
+uint8_t EventJournalFind(uint32_t fromSequence, JournalEvent* event);
+//0 while the journal is empty.
+uint32_t EventJournalGetLastSequence(void);
+//Events that were triggered but could not be written.
+uint32_t EventJournalGetLostCount(void);
+
+#endif /* INC_EVENTJOURNAL_H_ */
@@ -0,0 +1,27 @@
+/*
+ * FlashPort.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Access to the flash pages reserved for the event journal, see the JOURNAL
+ *  region in STM32F103C8TX_FLASH.ld. Offsets are relative to the start of the
+ *  region. Erased flash reads 0xFF and a half word can only be programmed
+ *  while it is still erased. The host build links a simulated flash instead.
+ */
+
+#ifndef INC_FLASHPORT_H_
+#define INC_FLASHPORT_H_
+
+#include <stdint.h>
+
+#define FLASHPORTPAGESIZE 1024U
+#define FLASHPORTPAGECOUNT 8U
+#define FLASHPORTSIZE (FLASHPORTPAGESIZE * FLASHPORTPAGECOUNT)
+
+//Both return 1 on success. The CPU stalls while the flash is busy, an erase takes about 20ms.
+uint8_t FlashPortErasePage(uint8_t page);
+uint8_t FlashPortProgram(uint32_t offset, const uint16_t* data, uint16_t halfWords);
+//The region is memory mapped, reads need no driver.
+const uint8_t* FlashPortGetData(uint32_t offset);
+
+#endif /* INC_FLASHPORT_H_ */
@@ -9,19 +9,27 @@
 #define INC_LAPTIMER_H_
 
 #include <stdint.h>
+#include "TimeMgmt.h"
 
+//Both can be set for the build, LapTimer.c checks that they fit together.
+#ifndef MAXLAPCOUNT
 #define MAXLAPCOUNT 32
+#endif
+#ifndef MAXSIMULTANEOUSRIDERS
 #define MAXSIMULTANEOUSRIDERS 10
+#endif
+#define LAPTIMESTAMPINVALID 0xFFFFFFFFFFFFFFFFU
 
 typedef struct
 {
-    uint32_t startTimeStamp;
-    uint32_t endTimeStamp;
+    Timestamp1us startTimeStamp;
+    Timestamp1us endTimeStamp;
+    uint32_t sequence; //Numbers finished laps from 1 on, 0 while the lap runs
+    uint32_t traceId; //Trace of the trigger that finished the lap
+    uint8_t sensorMode; //Sensor mode the lap was timed in
 } Lap;
 
 extern Lap laps[MAXLAPCOUNT];
-extern uint8_t lapFinished;
-extern uint8_t newRunStarted;
 
 void RunStandAloneTimer(void);
 Lap* GetPreviousLap(void);
@@ -31,7 +39,12 @@ Lap* GetCurrentLap(void);
 uint8_t GetLapIndex(Lap* lap);
 Lap* GetLastStartedLap(void);
 uint32_t GetLapDurationMs(Lap* lap);
+Timestamp1us GetLapDuration1us(Lap* lap);
 void InvalidateLapIndex(uint8_t index);
+uint32_t GetLastLapSequence(void);
+Lap* GetFinishedLapAfter(uint32_t sequence);
+//Starts refused because every rider or buffer slot was taken.
+uint32_t GetRejectedStartCount(void);
 
 
 #endif /* INC_LAPTIMER_H_ */
@@ -0,0 +1,69 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Execution time histograms for the main loop tasks and the interrupt
+ *  handlers. Probes count CPU cycles, on the board with the DWT cycle
+ *  counter and in the host build with clock_gettime scaled to the same
+ *  clock, so numbers from the lab and the field compare directly. Each
+ *  probe point keeps a histogram with log2 buckets, GetPerfStats reads
+ *  and clears them one point at a time.
+ */
+
+#ifndef INC_PROFILER_H_
+#define INC_PROFILER_H_
+
+#include <stdint.h>
+
+//SYSCLK as set in SystemClock_Config.
+#define PROFILERCYCLESPER1US 32U
+//Bucket n counts samples of 2^n up to 2^(n+1) cycles, 0 and 1 go in bucket 0. The last one takes everything
+//from about 0.26s on.
+#define PROFILERBUCKETCOUNT 24U
+
+typedef enum
+{
+    ProfileTaskInputs = 0U,
+    ProfileTaskEventJournal = 1U,
+    ProfileTaskStatusOutputs = 2U,
+    ProfileTaskRaceTiming = 3U,
+    ProfileTaskCommunication = 4U,
+    ProfileTaskDisplay = 5U,
+    ProfileSchedulerPass = 6U, //Every task of a pass, the sleep not included
+    ProfileTimerOverflow = 7U,
+    ProfilePpsPulse = 8U,
+    ProfileStartStopSensor = 9U,
+    ProfileStopSensor = 10U,
+    ProfileSensorEntryLatency = 11U, //From the captured edge to the sensor handler
+    NbOfProfilePoints = 12U
+} ProfilePoint;
+
+typedef struct
+{
+    uint32_t samples;
+    uint32_t maxCycles;
+    uint16_t buckets[PROFILERBUCKETCOUNT]; //Stop counting at 0xFFFF
+} ProfileStats;
+
+#ifdef TIMER_HOST_BUILD
+uint32_t ProfilerGetCycles(void);
+#else
+#include "stm32f1xx.h"
+static inline uint32_t ProfilerGetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+//Wraps after 134s at 32MHz, a probe must not last longer.
+#define PROFILER_START(name) uint32_t name = ProfilerGetCycles()
+#define PROFILER_END(point, name) ProfilerRecord((point), ProfilerGetCycles() - (name))
+
+void ProfilerInit(void);
+//Callable from the main loop and from interrupts, as long as a point is only recorded from one of them.
+void ProfilerRecord(ProfilePoint point, uint32_t cycles);
+//Copies the histogram of the point and clears it.
+void ProfilerTakeStats(ProfilePoint point, ProfileStats* stats);
+
+#endif /* INC_PROFILER_H_ */
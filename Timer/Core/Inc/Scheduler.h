@@ -0,0 +1,51 @@
+/*
+ * Scheduler.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Cooperative scheduler for the main loop. The tasks are listed in a
+ *  static table in Scheduler.c with a period and a deadline, interrupts
+ *  can wake a task before its period is over. When nothing is due the
+ *  core sleeps until the next interrupt, SysTick wakes it every ms.
+ */
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include <stdint.h>
+
+//In the order they run within one pass.
+typedef enum
+{
+    TaskInputs = 0U,
+    TaskEventJournal = 1U,
+    TaskStatusOutputs = 2U,
+    TaskRaceTiming = 3U,
+    TaskCommunication = 4U,
+    TaskDisplay = 5U,
+    NbOfSchedulerTasks = 6U
+} SchedulerTask;
+//An enum constant is 0 to the preprocessor, so this cannot be an #if.
+_Static_assert(NbOfSchedulerTasks <= 32U, "Wake requests are kept in a 32 bit mask");
+
+typedef struct
+{
+    uint32_t runCount;
+    uint32_t maxExecution1us;
+    uint64_t totalExecution1us;
+    uint32_t maxLateness1us; //Start of a periodic run after the time it was due
+    uint32_t deadlineMisses;
+} SchedulerTaskStats;
+
+//One pass: runs every task that is due or woken and sleeps when none is left.
+void RunScheduler(void);
+//Callable from interrupts.
+void SchedulerWake(SchedulerTask task);
+void SchedulerGetTaskStats(SchedulerTask task, SchedulerTaskStats* stats);
+//Share of the time since the last reset the core slept, interrupts that woke it included.
+uint8_t SchedulerGetIdlePercent(void);
+//Time the stats cover, since the last reset or since power up.
+uint32_t SchedulerGetStatsPeriod1ms(void);
+void SchedulerResetStats(void);
+
+#endif /* INC_SCHEDULER_H_ */
@@ -0,0 +1,38 @@
+/*
+ * SensorEventQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Single producer, single consumer queue of sensor timestamps per input.
+ *  The EXTI handlers push, the main loop pops. Neither side masks interrupts.
+ */
+
+#ifndef INC_SENSOREVENTQUEUE_H_
+#define INC_SENSOREVENTQUEUE_H_
+
+#include <stdint.h>
+#include "TimeMgmt.h"
+
+#define SENSOREVENTQUEUELENGTH 8U //Must be a power of two
+
+typedef enum
+{
+    SensorInputStartStop = 0U,
+    SensorInputStop = 1U,
+    NbOfSensorInputs = 2U
+} SensorInput;
+
+typedef struct
+{
+    SensorTimestamp events[SENSOREVENTQUEUELENGTH];
+    uint8_t head; //Only written by the interrupt handler
+    uint8_t tail; //Only written by the main loop
+    uint32_t overflowCount;
+} SensorEventQueue;
+
+uint8_t SensorEventQueuePush(SensorInput input, volatile SensorTimestamp* timeStamp);
+uint8_t SensorEventQueuePop(SensorInput input, SensorTimestamp* timeStamp);
+uint8_t SensorEventQueueGetCount(SensorInput input);
+uint32_t SensorEventQueueGetOverflowCount(SensorInput input);
+
+#endif /* INC_SENSOREVENTQUEUE_H_ */
@@ -0,0 +1,58 @@
+/*
+ * SensorTrace.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Follows each accepted sensor trigger from the captured edge to the last
+ *  byte of the frame that tells the central about it. The trigger gets a
+ *  trace ID in the interrupt handler, which travels with its timestamp,
+ *  lap and time event. Every stage stamps the trace once, so a retransmit
+ *  does not hide how long the first frame took. When the central shows a
+ *  time late, the stages tell whether the firmware, the UART or the radio
+ *  link after it held it up. GetSensorTraces reads the traces back.
+ */
+
+#ifndef INC_SENSORTRACE_H_
+#define INC_SENSORTRACE_H_
+
+#include <stdint.h>
+#include "TimeMgmt.h"
+#include "SensorEventQueue.h"
+
+#define SENSORTRACELENGTH 16U //Must be a power of two
+//Offset of a stage the trigger has not reached (yet).
+#define SENSORTRACENOTREACHED 0xFFFFFFFFU
+
+typedef enum
+{
+    TraceStageHandler = 0U, //The sensor interrupt handler started
+    TraceStageDequeued = 1U, //The timer or the timestamp collector took it from the sensor queue
+    TraceStageHandedOff = 2U, //Queued for the central by CommMgrSendTimeValue
+    TraceStageFrameQueued = 3U, //The frame carrying it went into the transmit ring
+    TraceStageTransmitted = 4U, //The DMA controller handed the last byte of that frame to the USART
+    NbOfTraceStages = 5U
+} SensorTraceStage;
+
+typedef struct
+{
+    Timestamp1us captureTime1us; //System time of the captured edge
+    Timestamp1us ppsTime1us; //The same edge in PPS time, as the central gets it
+    uint32_t stageOffset1us[NbOfTraceStages]; //Since the captured edge
+    uint32_t frameEnd; //Bytes queued on the UART up to the end of the frame
+    uint32_t traceId; //Numbers the triggers from 1 on
+    uint8_t sensor;
+} SensorTrace;
+
+//From the sensor interrupt handlers. Returns the trace ID for the timestamp.
+uint32_t SensorTraceBegin(SensorInput sensor, SensorTimestamp* timeStamp, uint32_t entryLatency1us);
+//From the main loop. Traces that have been reused for newer triggers are left alone.
+void SensorTraceMark(uint32_t traceId, SensorTraceStage stage);
+//After the frame that carries the trigger has been committed to the protocol UART.
+void SensorTraceFrameQueued(uint32_t traceId);
+//From the DMA transfer complete interrupt of a UART.
+void SensorTraceTransmitComplete(uint8_t uartId);
+uint32_t SensorTraceGetLastId(void);
+//Copies the trace. One that is no longer kept comes back with ID 0 and no stage reached, and 0 is returned.
+uint8_t SensorTraceGet(uint32_t traceId, SensorTrace* trace);
+
+#endif /* INC_SENSORTRACE_H_ */
@@ -1,29 +1,37 @@
 #ifndef TIMEMGMT_H
 #define TIMEMGMT_H
 #include <stdint.h>
-#define MIN_SENSOR_INTERRUPT_WAIT 20000U
+#define MIN_SENSOR_INTERRUPT_WAIT 2000000U //in microseconds
+#define TIMERPERIOD1US 50000U //TIM2 free-runs at 1MHz and overflows every 50ms.
+
+//Microseconds. Monotonic since power up and only wraps after thousands of years,
+//so plain comparisons and subtractions are always safe.
+typedef uint64_t Timestamp1us;
 
 typedef struct
 {
+    Timestamp1us time1us; //When the event happened
+    Timestamp1us ppsTime1us; //When the last PPS edge before the event arrived
     uint32_t timeStampPps;
-    uint32_t ppsOffset100us;
-    uint32_t timeStamp100us;
+    uint32_t traceId; //Sensor triggers only, 0 for everything else. See SensorTrace.h
 } SensorTimestamp;
 
-extern volatile SensorTimestamp systemTime;
-extern volatile SensorTimestamp sensorStartStopTimeStamp;
-extern volatile SensorTimestamp sensorStopTimeStamp;
-
-extern volatile uint8_t sensorStartStopInterrupt;
-extern volatile uint8_t sensorStopInterrupt;
-extern volatile uint8_t ppsTick;
-
 
-uint32_t GetMillisecondsFromTimeStampPPS(SensorTimestamp* timeStamp);
-uint32_t GetMillisecondsFromTimeStamp(SensorTimestamp* timeStamp);
+Timestamp1us GetPpsTimestamp1us(SensorTimestamp* timeStamp);
+Timestamp1us GetSystemTime1us(void);
+//32 bit variants for short intervals. They wrap at 2^32 and must only be compared by subtraction.
 uint32_t GetSystemTimeStampMs(void);
+uint32_t GetSystemTimeStamp100us(void);
+//Consistent copy of the system time without masking interrupts. Callable from the main loop
+//and from interrupts with a lower priority than TIM2 and the PPS input.
+void GetSystemTimeSnapshot(SensorTimestamp* snapshot);
+//Publishes an EventPpsTick for every PPS edge since the last call, from the main loop.
+void RunTimeMgmt(void);
 
-void GetStartStopSensorTimeStamp(SensorTimestamp* copy);
-void GetStopSensorTimeStamp(SensorTimestamp* copy);
+//Interrupt handler bodies, called from stm32f1xx_it.c or from the host simulation engine.
+void HandleTimerOverflow(void);
+void HandlePpsPulse(void);
+void HandleStartStopSensorTrigger(void);
+void HandleStopSensorTrigger(void);
 
 #endif
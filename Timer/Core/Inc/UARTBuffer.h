@@ -10,27 +10,52 @@
 
 #include "stm32f1xx.h"
 
-#define UART_BUFFER_SIZE 256U
+//Holds the largest v2 protocol frame, which is parsed in place, with room for the next one.
+#define UART_BUFFER_SIZE 1024U
+//Received bytes that may still arrive while the ones held in the receive ring are being used.
+#define UART_RX_GUARD 64U
 
 typedef struct
 {
-    uint8_t rxBuffer[UART_BUFFER_SIZE];
-    uint8_t txBuffer[UART_BUFFER_SIZE];
-    uint16_t currentRxBufferPosition;
+    uint8_t rxBuffer[UART_BUFFER_SIZE]; //Written by the DMA controller in circular mode
+    uint8_t txBuffer[UART_BUFFER_SIZE]; //Ring, read by the DMA controller
+    uint16_t currentRxBufferPosition; //DMA write position, published from interrupts
     uint16_t rxBufferStartPosition;
+    uint32_t rxBytesReceived; //Since reception started, published together with the write position
+    uint32_t rxBytesConsumed; //Only written by the main loop
     uint16_t currentTxBufferPosition;
-    uint16_t txBufferTxPosition;
+    uint16_t txBufferTxPosition; //Start of the running DMA transfer, moved by the completion interrupt
+    uint16_t txDmaLength;
+    uint8_t txDmaBusy;
+    uint32_t txBytesQueued; //Since power up, wraps at 2^32
+    uint32_t txBytesSent; //Handed to the USART by the DMA controller, moved by the completion interrupt
     USART_TypeDef* uartHandle;
+    uint32_t rxDmaChannel;
+    uint32_t txDmaChannel;
 } UARTBuffer;
 
-void UARTBufferProcessReceivedByte(UARTBuffer* buffer, uint8_t byte);
+void UARTBufferStartReception(UARTBuffer* buffer, uint32_t dmaChannel);
+void UARTBufferProcessReceivedData(UARTBuffer* buffer);
+void UARTBufferStartTransmission(UARTBuffer* buffer, uint32_t dmaChannel);
+void UARTBufferProcessTransmitComplete(UARTBuffer* buffer);
 void UARTBufferClear(UARTBuffer* buffer);
+void UARTBufferSkipData(UARTBuffer* buffer, uint16_t length);
 void UARTBufferGetData(UARTBuffer* buffer, uint8_t* dstBuffer, uint8_t length);
-uint8_t UARTBufferHasNewData(UARTBuffer* buffer);
+uint16_t UARTBufferPeekData(UARTBuffer* buffer, uint16_t offset, const uint8_t** data);
+void UARTBufferWriteRxData(UARTBuffer* buffer, uint16_t offset, const uint8_t* data, uint16_t length);
+uint16_t UARTBufferHasNewData(UARTBuffer* buffer);
+uint8_t UARTBufferRxOverrun(UARTBuffer* buffer);
 UARTBuffer* UARTBufferGetUART(uint8_t index);
-void UARTBufferRunTxWork(void);
 uint8_t UARTBufferTxBufferEmpty(UARTBuffer* buffer);
-void UARTBufferSendData(UARTBuffer* buffer, uint8_t* data, uint8_t length);
+uint8_t UARTBufferTxComplete(UARTBuffer* buffer);
+void UARTBufferSetBaudRate(UARTBuffer* buffer, uint32_t baudRate);
+uint16_t UARTBufferGetTxFreeSpace(UARTBuffer* buffer);
+uint8_t UARTBufferSendData(UARTBuffer* buffer, uint8_t* data, uint8_t length);
+void UARTBufferWriteTxData(UARTBuffer* buffer, uint16_t offset, const uint8_t* data, uint16_t length);
+void UARTBufferReadTxData(UARTBuffer* buffer, uint16_t offset, uint8_t* dst, uint16_t length);
+void UARTBufferCommitTxData(UARTBuffer* buffer, uint16_t length);
+uint32_t UARTBufferGetTxBytesQueued(UARTBuffer* buffer);
+uint32_t UARTBufferGetTxBytesSent(UARTBuffer* buffer);
 
 
 #endif /* INC_UARTBUFFER_H_ */
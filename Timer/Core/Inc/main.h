@@ -71,7 +71,8 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-void ProcessUARTByte(uint8_t uartId, uint8_t uartByte);
+void ProcessUARTReception(uint8_t uartId);
+void ProcessUARTTransmitComplete(uint8_t uartId);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
@@ -1,13 +0,0 @@
-/*
- * platformconfig.h
- *
- *  Created on: Jan 10, 2021
- *      Author: cdromke
- */
-
-#ifndef INC_PLATFORMCONFIG_H_
-#define INC_PLATFORMCONFIG_H_
-
-
-
-#endif /* INC_PLATFORMCONFIG_H_ */
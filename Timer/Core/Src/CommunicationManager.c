@@ -5,45 +5,283 @@
  *      Author: cdromke
  */
 
-#include <string.h>
 #include "Configuration.h"
 #include "TimeMgmt.h"
 #include "LapTimer.h"
+#include "EventJournal.h"
+#include "EventBus.h"
+#include "Profiler.h"
+#include "SensorTrace.h"
+#include "Scheduler.h"
 #include "MGBTCommProto.h"
 #include "CommunicationManager.h"
 
-static MGBTCommandData pendingResponse = {0};
-static uint8_t lastResponseSent = 0U;
-static uint32_t lastTimeTimeUpdate = 0U;
-static uint32_t latestTimestamp = 0U;
+//Time events waiting to be acknowledged by the central.
+#define TIMEEVENTQUEUELENGTH 16U
+//Unacknowledged time events are sent again once this long has passed without progress.
+#define TIMEEVENTRETRANSMITTIMEOUT 500U
+//Sequence, type, full 64 bit value.
+#define TIMEEVENTRECORDLENGTH 13U
+//A batch goes out before its window has passed once it fills a v1 frame.
+#define TIMEEVENTBATCHRECORDS ((COMMANDDATAMAXSIZE - 1U) / TIMEEVENTRECORDLENGTH)
+//Longest time an event may be held back to be batched with the next ones.
+#define TIMEEVENTBATCHMAXWINDOW 1000U
+
+typedef struct
+{
+    Timestamp1us time;
+    uint32_t sequence;
+    uint32_t queueTime; //Milliseconds
+    uint32_t traceId;
+    CommTimeType type;
+} TimeEvent;
+
+static MGBTTopic currentTimeTopic = {GetCurrentTime, 0U, 0U, TIMEUPDATEPERIOD, TIMEUPDATEMINPERIOD, 0U, 0U};
+static Timestamp1us latestTimestamp = 0U;
 static CommTimeType latestTimestampType = NoTimeType;
-static uint8_t timeUpdated = 0U;
+static uint32_t latestTimestampSequence = 0U;
+
+//Oldest first. Entries before timeEventsSent have gone out and wait for their acknowledgement.
+static TimeEvent timeEvents[TIMEEVENTQUEUELENGTH] = {0};
+static uint8_t timeEventHead = 0U;
+static uint8_t timeEventCount = 0U;
+static uint8_t timeEventsSent = 0U;
+static uint32_t timeEventRetransmitTime = 0U;
+//Central units that never acknowledge get every event once, as they always did.
+static uint8_t timeEventsAcknowledged = 0U;
+//Central units that asked for batches get the events in TimeEventBatch frames.
+static uint8_t timeEventBatching = 0U;
+static uint16_t timeEventBatchWindow = 0U;
+
+//Sequence, start, end, sensor mode.
+#define LAPRECORDLENGTH 21U
+//Last sequence and record count in front of the records.
+#define LAPPAGEHEADERLENGTH 5U
+
+//Sequence, time, sensor.
+#define JOURNALRECORDLENGTH 13U
+//Newest sequence and record count in front of the records.
+#define JOURNALPAGEHEADERLENGTH 5U
+
+//Trace ID, sensor, PPS time of the edge, stage offsets.
+#define TRACERECORDLENGTH (13U + (4U * NbOfTraceStages))
+//Newest trace ID and record count in front of the records.
+#define TRACEPAGEHEADERLENGTH 5U
+
+//Runs, average and longest execution, longest lateness, deadline misses.
+#define SCHEDULERSTATSRECORDLENGTH 20U
+//Number of tasks, idle percentage and the period the stats cover in front of the records.
+#define SCHEDULERSTATSHEADERLENGTH 6U
+_Static_assert((SCHEDULERSTATSHEADERLENGTH + (NbOfSchedulerTasks * SCHEDULERSTATSRECORDLENGTH)) <= COMMANDDATAMAXSIZE,
+               "The scheduler stats have to fit a v1 frame");
 
-static uint32_t displayTime = 0U;
-static uint8_t newConfig = 0U;
+//Frames of a journal replay are tagged as answers to the command that started it.
+static MGBTCommandView replayCommand = {0};
+static uint8_t replayActive = 0U;
+static uint32_t replayNextSequence = 0U;
+static uint32_t replayLastSequence = 0U;
+
+//Layout: 32 bit value (wraps), type byte, full 64 bit value. Older central units only read the first 5 bytes,
+//the short value keeps the unit they expect.
+static void AddTimeToResponse(CommTimeType timeType, uint32_t shortTimeValue, Timestamp1us timeValue)
+{
+    uint8_t typeValue = (uint8_t)timeType;
+    AddResponseData(&shortTimeValue, sizeof(shortTimeValue));
+    AddResponseData(&typeValue, sizeof(typeValue));
+    AddResponseData(&timeValue, sizeof(timeValue));
+}
+
+//Layout: time, see AddTimeToResponse, followed by the sequence number of the event.
+//The command sequence number is 0 when the device sends the time on its own.
+static uint8_t SendTimeEvent(uint8_t sequence, CommTimeType timeType, Timestamp1us timeValue, uint32_t eventSequence)
+{
+    uint8_t retVal = BeginResponse((uint16_t)(GetLatestTimeStamp | (sequence << MGBTSEQUENCESHIFT)), 0U);
+    if(retVal == 1U)
+    {
+        //Lap times were sent in milliseconds, sensor times in microseconds.
+        uint32_t shortTimeValue = (timeType == LastLapTime) ? (uint32_t)(timeValue / 1000U) : (uint32_t)timeValue;
+        AddTimeToResponse(timeType, shortTimeValue, timeValue);
+        AddResponseData(&eventSequence, sizeof(eventSequence));
+        FinishResponse();
+    }
+    return retVal;
+}
+
+static uint8_t SendLatestTimestamp(uint8_t sequence)
+{
+    return SendTimeEvent(sequence, latestTimestampType, latestTimestamp, latestTimestampSequence);
+}
+
+static void DropOldestTimeEvent(void)
+{
+    timeEventHead = (uint8_t)((timeEventHead + 1U) % TIMEEVENTQUEUELENGTH);
+    timeEventCount--;
+    if(timeEventsSent > 0U)
+    {
+        timeEventsSent--;
+    }
+}
+
+//The acknowledgement is cumulative, it covers every event up to and including the given sequence number.
+static void AcknowledgeTimeEvents(uint32_t eventSequence)
+{
+    timeEventsAcknowledged = 1U;
+    while((timeEventCount > 0U) &&
+          (timeEvents[timeEventHead].sequence <= eventSequence))
+    {
+        DropOldestTimeEvent();
+    }
+    timeEventRetransmitTime = GetSystemTimeStampMs();
+}
+
+static void MarkTimeEventsSent(uint8_t count, uint32_t sysTimeStamp)
+{
+    uint8_t index;
+
+    if(timeEventsSent == 0U)
+    {
+        timeEventRetransmitTime = sysTimeStamp;
+    }
+    timeEventsSent += count;
+    if(timeEventsAcknowledged == 0U)
+    {
+        for(index = 0U; index < count; index++)
+        {
+            DropOldestTimeEvent();
+        }
+    }
+}
+
+//The oldest unsent event has waited out the window, or there are enough to fill a frame.
+static uint8_t IsTimeEventBatchDue(uint32_t sysTimeStamp)
+{
+    uint8_t retVal = 0U;
+    uint8_t unsent = timeEventCount - timeEventsSent;
+
+    if(unsent > 0U)
+    {
+        TimeEvent* event = &timeEvents[(timeEventHead + timeEventsSent) % TIMEEVENTQUEUELENGTH];
+        if(((sysTimeStamp - event->queueTime) >= timeEventBatchWindow) ||
+           (unsent >= TIMEEVENTBATCHRECORDS))
+        {
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+//Layout: number of records, records of sequence, type and full 64 bit value, oldest first.
+//Returns 0 when there was no room for the frame.
+static uint8_t SendTimeEventBatch(uint32_t sysTimeStamp)
+{
+    uint8_t retVal = BeginResponse(TimeEventBatch, 0U);
+    if(retVal == 1U)
+    {
+        uint8_t count = timeEventCount - timeEventsSent;
+        uint8_t maxCount = (uint8_t)((GetResponseSpaceLeft() - 1U) / TIMEEVENTRECORDLENGTH);
+        uint8_t index;
+
+        if(count > maxCount)
+        {
+            count = maxCount;
+        }
+        AddResponseData(&count, sizeof(count));
+        for(index = 0U; index < count; index++)
+        {
+            TimeEvent* event = &timeEvents[(timeEventHead + timeEventsSent + index) % TIMEEVENTQUEUELENGTH];
+            uint8_t typeValue = (uint8_t)event->type;
+            AddResponseData(&event->sequence, sizeof(event->sequence));
+            AddResponseData(&typeValue, sizeof(typeValue));
+            AddResponseData(&event->time, sizeof(event->time));
+        }
+        FinishResponse();
+        for(index = 0U; index < count; index++)
+        {
+            SensorTraceFrameQueued(timeEvents[(timeEventHead + timeEventsSent + index) % TIMEEVENTQUEUELENGTH].traceId);
+        }
+        MarkTimeEventsSent(count, sysTimeStamp);
+    }
+    return retVal;
+}
 
-static void PutTimeInPendingResponse(CommTimeType timeType, uint32_t timeValue)
+//Events go out in order as fast as the link allows, or batched when the central asked for it.
+//When the acknowledgements stall, everything that is still unacknowledged is sent again, the
+//central ignores sequence numbers it already has.
+static void SendTimeEvents(void)
 {
-    memcpy(pendingResponse.data, &timeValue, sizeof(timeValue));
-    pendingResponse.data[sizeof(timeValue)] = (uint8_t)timeType;
-    pendingResponse.dataLength = 1 + sizeof(timeValue);
+    uint32_t sysTimeStamp = GetSystemTimeStampMs();
+
+    if((timeEventsSent > 0U) &&
+       ((sysTimeStamp - timeEventRetransmitTime) > TIMEEVENTRETRANSMITTIMEOUT))
+    {
+        timeEventsSent = 0U;
+    }
+
+    if(timeEventBatching == 1U)
+    {
+        while((IsTimeEventBatchDue(sysTimeStamp) == 1U) &&
+              (SendTimeEventBatch(sysTimeStamp) == 1U))
+        {
+        }
+    }
+    else
+    {
+        while((timeEventsSent < timeEventCount) &&
+              (CanSendResponse() != 0U))
+        {
+            TimeEvent* event = &timeEvents[(timeEventHead + timeEventsSent) % TIMEEVENTQUEUELENGTH];
+            //An event that was not framed is not in flight, it goes out on the next pass.
+            if(SendTimeEvent(0U, event->type, event->time, event->sequence) == 0U)
+            {
+                break;
+            }
+            SensorTraceFrameQueued(event->traceId);
+            MarkTimeEventsSent(1U, sysTimeStamp);
+        }
+    }
 }
 
-static void SendLatestTimestamp(void)
+//Layout: window in milliseconds, 16 bit, echoed as it is used. Events are held back at most
+//this long to be sent together, 0 sends whatever is waiting straight away.
+static void ProcessTimeEventBatchCommand(MGBTCommandView* command)
 {
-    pendingResponse.cmdType = GetLatestTimeStamp;
-    pendingResponse.status = 0U;
-    PutTimeInPendingResponse(latestTimestampType, latestTimestamp);
+    uint16_t window = 0U;
+
+    if(command->dataLength >= sizeof(window))
+    {
+        (void)CopyCommandData(command, 0U, &window, sizeof(window));
+        if(window > TIMEEVENTBATCHMAXWINDOW)
+        {
+            window = TIMEEVENTBATCHMAXWINDOW;
+        }
+        timeEventBatchWindow = window;
+        timeEventBatching = 1U;
+        (void)BeginCommandResponse(command, 0U);
+        AddResponseData(&window, sizeof(window));
+    }
+    else
+    {
+        (void)BeginCommandResponse(command, 0xFFFFU);
+        AddResponseCommandData(command);
+    }
+    FinishResponse();
 }
 
-static void SendCurrentTime(void)
+static uint8_t SendCurrentTime(uint8_t sequence)
 {
-    pendingResponse.cmdType = GetCurrentTime;
-    pendingResponse.status = 0U;
-    PutTimeInPendingResponse(NoTimeType, GetSystemTimeStampMs());
+    uint8_t retVal = BeginResponse((uint16_t)(GetCurrentTime | (sequence << MGBTSEQUENCESHIFT)), 0U);
+    if(retVal == 1U)
+    {
+        Timestamp1us now = GetSystemTime1us();
+        //Milliseconds in the short value, as it always was.
+        AddTimeToResponse(NoTimeType, (uint32_t)(now / 1000U), now);
+        FinishResponse();
+    }
+    return retVal;
 }
 
-static void MoveAllLapsToResponsData(void)
+static void AddAllLapsToResponse(void)
 {
     uint8_t currentLapIndex = 0U;
     uint8_t currentDataIndex = 0U;
@@ -53,89 +291,376 @@ static void MoveAllLapsToResponsData(void)
         if(currentDataIndex < (COMMANDDATAMAXSIZE - 3U))
         {
             uint32_t lapTimeMs = GetLapDurationMs(&laps[currentLapIndex]);
-            memcpy(&pendingResponse.data[currentDataIndex], &lapTimeMs, 3U);
+            AddResponseData(&lapTimeMs, 3U);
             currentDataIndex += 3U;
-            pendingResponse.dataLength = currentDataIndex;
         }
     }
 }
 
-static void UpdateDisplayedTimeValue(uint32_t* data)
+static void AddLapRecordToResponse(Lap* lap)
+{
+    AddResponseData(&lap->sequence, sizeof(lap->sequence));
+    AddResponseData(&lap->startTimeStamp, sizeof(lap->startTimeStamp));
+    AddResponseData(&lap->endTimeStamp, sizeof(lap->endTimeStamp));
+    AddResponseData(&lap->sensorMode, sizeof(lap->sensorMode));
+}
+
+//Layout: sequence of the last finished lap, number of records, records of the laps finished after cursor,
+//oldest first. A page holds as many as the framing allows, the central asks again with the sequence
+//of the last record until it has caught up. Works in every operation mode.
+static void AddLapsSinceToResponse(uint32_t cursor)
+{
+    uint32_t lastSequence = GetLastLapSequence();
+    uint8_t maxCount = (uint8_t)((GetResponseSpaceLeft() - LAPPAGEHEADERLENGTH) / LAPRECORDLENGTH);
+    uint8_t count = 0U;
+    uint8_t index;
+    Lap* lap = GetFinishedLapAfter(cursor);
+
+    while((lap != (Lap*)0) && (count < maxCount))
+    {
+        count++;
+        lap = GetFinishedLapAfter(lap->sequence);
+    }
+
+    AddResponseData(&lastSequence, sizeof(lastSequence));
+    AddResponseData(&count, sizeof(count));
+    lap = GetFinishedLapAfter(cursor);
+    for(index = 0U; index < count; index++)
+    {
+        AddLapRecordToResponse(lap);
+        lap = GetFinishedLapAfter(lap->sequence);
+    }
+}
+
+static void AddJournalRecordToResponse(JournalEvent* event)
+{
+    AddResponseData(&event->sequence, sizeof(event->sequence));
+    AddResponseData(&event->time, sizeof(event->time));
+    AddResponseData(&event->sensor, sizeof(event->sensor));
+}
+
+//Layout: newest sequence when the replay started, number of records, records oldest first.
+//The replay ends with the frame that holds the newest event, or with an empty frame when
+//there was nothing to send. Returns 0 when there was no room for the frame.
+static uint8_t SendJournalReplayFrame(void)
+{
+    uint8_t retVal = BeginCommandResponse(&replayCommand, 0U);
+    if(retVal == 1U)
+    {
+        JournalEvent event;
+        uint8_t maxCount = (uint8_t)((GetResponseSpaceLeft() - JOURNALPAGEHEADERLENGTH) / JOURNALRECORDLENGTH);
+        uint8_t count = 0U;
+        uint8_t index;
+        uint32_t sequence = replayNextSequence;
+
+        while((count < maxCount) &&
+              (EventJournalFind(sequence, &event) == 1U) &&
+              (event.sequence <= replayLastSequence))
+        {
+            count++;
+            sequence = event.sequence + 1U;
+        }
+
+        AddResponseData(&replayLastSequence, sizeof(replayLastSequence));
+        AddResponseData(&count, sizeof(count));
+        sequence = replayNextSequence;
+        for(index = 0U; index < count; index++)
+        {
+            (void)EventJournalFind(sequence, &event);
+            AddJournalRecordToResponse(&event);
+            sequence = event.sequence + 1U;
+        }
+        FinishResponse();
+
+        replayNextSequence = sequence;
+        if((count < maxCount) || (sequence > replayLastSequence))
+        {
+            replayActive = 0U;
+        }
+    }
+    return retVal;
+}
+
+//Replays the journal from the given sequence on, events that were already given up are skipped.
+//A new replay replaces one that is still running.
+static void StartJournalReplay(MGBTCommandView* command)
 {
-    displayTime = (*data);
+    uint32_t fromSequence = 0U;
+    (void)CopyCommandData(command, 0U, &fromSequence, sizeof(fromSequence));
+
+    replayCommand.cmdType = command->cmdType;
+    replayCommand.sequence = command->sequence;
+    replayCommand.framing = command->framing;
+    replayNextSequence = fromSequence;
+    replayLastSequence = EventJournalGetLastSequence();
+    replayActive = 1U;
+    (void)SendJournalReplayFrame();
 }
 
-static void PrepareIDData(void)
+static void UpdateDisplayedTimeValue(MGBTCommandView* command)
+{
+    uint32_t value = 0U;
+    (void)CopyCommandData(command, 0U, &value, sizeof(value));
+    //0 was never shown.
+    if(value > 0U)
+    {
+        EventBusPublish(EventDisplayTime, value);
+    }
+}
+
+static void AddTraceRecordToResponse(uint32_t traceId)
+{
+    SensorTrace trace = {0};
+    (void)SensorTraceGet(traceId, &trace);
+    AddResponseData(&trace.traceId, sizeof(trace.traceId));
+    AddResponseData(&trace.sensor, sizeof(trace.sensor));
+    AddResponseData(&trace.ppsTime1us, sizeof(trace.ppsTime1us));
+    AddResponseData(trace.stageOffset1us, sizeof(trace.stageOffset1us));
+}
+
+//Layout: newest trace ID, number of records, records oldest first. Stage offsets are microseconds
+//since the edge, 0xFFFFFFFF for stages not reached. A trace that was reused while the page was put
+//together is sent with ID 0.
+static void ProcessSensorTracesCommand(const MGBTCommandView* command)
+{
+    uint32_t cursor = 0U;
+    uint32_t lastId = SensorTraceGetLastId();
+    uint8_t maxCount;
+    uint8_t count = 0U;
+    uint8_t index;
+
+    (void)CopyCommandData(command, 0U, &cursor, sizeof(cursor));
+    (void)BeginCommandResponse(command, 0U);
+    maxCount = (uint8_t)((GetResponseSpaceLeft() - TRACEPAGEHEADERLENGTH) / TRACERECORDLENGTH);
+    //Older traces have been reused.
+    if((lastId > SENSORTRACELENGTH) &&
+       (cursor < (lastId - SENSORTRACELENGTH)))
+    {
+        cursor = lastId - SENSORTRACELENGTH;
+    }
+    if(cursor < lastId)
+    {
+        count = ((lastId - cursor) < maxCount) ? (uint8_t)(lastId - cursor) : maxCount;
+    }
+
+    AddResponseData(&lastId, sizeof(lastId));
+    AddResponseData(&count, sizeof(count));
+    for(index = 0U; index < count; index++)
+    {
+        AddTraceRecordToResponse(cursor + 1U + index);
+    }
+    FinishResponse();
+}
+
+//Layout: point, number of points, number of buckets, cycles per microsecond, samples, longest in cycles,
+//16 bit bucket counts. The point is cleared once it has been read, a point out of range only gets the count.
+static void ProcessPerfStatsCommand(const MGBTCommandView* command)
+{
+    uint8_t point = GetCommandDataByte(command, 0U);
+    uint8_t header[4] = {point, (uint8_t)NbOfProfilePoints, (uint8_t)PROFILERBUCKETCOUNT, (uint8_t)PROFILERCYCLESPER1US};
+
+    if(point < (uint8_t)NbOfProfilePoints)
+    {
+        ProfileStats stats;
+        ProfilerTakeStats((ProfilePoint)point, &stats);
+        (void)BeginCommandResponse(command, 0U);
+        AddResponseData(header, sizeof(header));
+        AddResponseData(&stats.samples, sizeof(stats.samples));
+        AddResponseData(&stats.maxCycles, sizeof(stats.maxCycles));
+        AddResponseData(stats.buckets, sizeof(stats.buckets));
+    }
+    else
+    {
+        (void)BeginCommandResponse(command, 0xFFFFU);
+        AddResponseData(header, sizeof(header));
+    }
+    FinishResponse();
+}
+
+//Layout: number of tasks, idle percentage, milliseconds covered, one record per task in scheduler order.
+//Times are in microseconds. The stats start over once they have been read.
+static void ProcessSchedulerStatsCommand(const MGBTCommandView* command)
+{
+    uint8_t header[2] = {(uint8_t)NbOfSchedulerTasks, SchedulerGetIdlePercent()};
+    uint32_t period = SchedulerGetStatsPeriod1ms();
+    uint8_t task;
+
+    (void)BeginCommandResponse(command, 0U);
+    AddResponseData(header, sizeof(header));
+    AddResponseData(&period, sizeof(period));
+    for(task = 0U; task < (uint8_t)NbOfSchedulerTasks; task++)
+    {
+        SchedulerTaskStats stats;
+        uint32_t averageExecution = 0U;
+        SchedulerGetTaskStats((SchedulerTask)task, &stats);
+        if(stats.runCount > 0U)
+        {
+            averageExecution = (uint32_t)(stats.totalExecution1us / stats.runCount);
+        }
+        AddResponseData(&stats.runCount, sizeof(stats.runCount));
+        AddResponseData(&averageExecution, sizeof(averageExecution));
+        AddResponseData(&stats.maxExecution1us, sizeof(stats.maxExecution1us));
+        AddResponseData(&stats.maxLateness1us, sizeof(stats.maxLateness1us));
+        AddResponseData(&stats.deadlineMisses, sizeof(stats.deadlineMisses));
+    }
+    FinishResponse();
+    SchedulerResetStats();
+}
+
+//Layout: device type, display configuration, protocol capabilities.
+//Central units that only know the first 5 bytes keep using v1 framing.
+static void AddIDDataToResponse(void)
 {
     uint32_t bcdConfig = GetConfigBCDDisplay();
-    pendingResponse.data[0] = (uint8_t)(DeviceTypeTimer | DeviceTypeDisplay);
-    pendingResponse.dataLength = 1U;
-    memcpy(&pendingResponse.data[1], &bcdConfig, sizeof(uint32_t));
-    pendingResponse.dataLength += sizeof(uint32_t);
+    uint8_t deviceType = (uint8_t)(DeviceTypeTimer | DeviceTypeDisplay);
+    AddResponseData(&deviceType, sizeof(deviceType));
+    AddResponseData(&bcdConfig, sizeof(bcdConfig));
+    AddProtocolInfoToResponse();
 }
 
-static void ProcessCommand(MGBTCommandData* command)
+//Answers straight into the transmit ring, the caller made sure it has room.
+//Commands that carry a value get their data echoed back.
+static void ProcessCommand(MGBTCommandView* command)
 {
-    lastResponseSent = 0U;
     switch(command->cmdType)
     {
         case GetLatestTimeStamp:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            lastResponseSent = 1U;
-            SendLatestTimestamp();
+            (void)SendLatestTimestamp(command->sequence);
             break;
         }
         case GetAllLaps:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
             if((operationMode == LaptimerOperation) ||
                (operationMode == SingleRunTimerOperation))
             {
-                MoveAllLapsToResponsData();
-                pendingResponse.status = 0U;
+                (void)BeginCommandResponse(command, 0U);
+                AddAllLapsToResponse();
+            }
+            else
+            {
+                (void)BeginCommandResponse(command, 0xFFFFU);
+                AddResponseCommandData(command);
+            }
+            FinishResponse();
+            break;
+        }
+        case GetLapsSince:
+        {
+            uint32_t cursor = 0U;
+            (void)CopyCommandData(command, 0U, &cursor, sizeof(cursor));
+            (void)BeginCommandResponse(command, 0U);
+            AddLapsSinceToResponse(cursor);
+            FinishResponse();
+            break;
+        }
+        case AckTimestamps:
+        {
+            uint32_t eventSequence = 0U;
+            if(command->dataLength >= sizeof(eventSequence))
+            {
+                (void)CopyCommandData(command, 0U, &eventSequence, sizeof(eventSequence));
+                AcknowledgeTimeEvents(eventSequence);
+                (void)BeginCommandResponse(command, 0U);
+            }
+            else
+            {
+                (void)BeginCommandResponse(command, 0xFFFFU);
+            }
+            AddResponseData(&timeEventCount, sizeof(timeEventCount));
+            FinishResponse();
+            break;
+        }
+        case TimeEventBatch:
+        {
+            ProcessTimeEventBatchCommand(command);
+            break;
+        }
+        case GetPerfStats:
+        {
+            ProcessPerfStatsCommand(command);
+            break;
+        }
+        case GetSchedulerStats:
+        {
+            ProcessSchedulerStatsCommand(command);
+            break;
+        }
+        case GetSensorTraces:
+        {
+            if(command->dataLength >= sizeof(uint32_t))
+            {
+                ProcessSensorTracesCommand(command);
             }
             else
             {
-                pendingResponse.status = 0xFFFFU;
+                (void)BeginCommandResponse(command, 0xFFFFU);
+                AddResponseCommandData(command);
+                FinishResponse();
+            }
+            break;
+        }
+        case ReplayJournal:
+        {
+            if(command->dataLength >= sizeof(uint32_t))
+            {
+                StartJournalReplay(command);
+            }
+            else
+            {
+                (void)BeginCommandResponse(command, 0xFFFFU);
+                AddResponseCommandData(command);
+                FinishResponse();
             }
-            lastResponseSent = 1U;
             break;
         }
         case GetCurrentTime:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            lastResponseSent = 1U;
-            SendCurrentTime();
+            (void)SendCurrentTime(command->sequence);
             break;
         }
         case GetIdentification:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            lastResponseSent = 1U;
-            PrepareIDData();
+            (void)BeginCommandResponse(command, command->status);
+            AddIDDataToResponse();
+            FinishResponse();
             break;
         }
         case UpdateDisplayedTime:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            lastResponseSent = 1U;
             if(command->dataLength >= sizeof(uint32_t))
             {
-                UpdateDisplayedTimeValue((uint32_t*)command->data);
-                pendingResponse.status = 0U;
+                UpdateDisplayedTimeValue(command);
+                (void)BeginCommandResponse(command, 0U);
             }
             else
             {
-                pendingResponse.status = 0xFFFFU;
+                (void)BeginCommandResponse(command, 0xFFFFU);
             }
+            AddResponseCommandData(command);
+            FinishResponse();
             break;
         }
         case UpdateOpMode:
         {
-            memcpy(&pendingResponse, command, GetCommandDataSize(command));
-            lastResponseSent = 1U;
-            newConfig = command->data[0];
+            uint8_t newConfig = GetCommandDataByte(command, 0U);
+            if(newConfig != 0U)
+            {
+                EventBusPublish(EventNewConfig, newConfig);
+            }
+            (void)BeginCommandResponse(command, command->status);
+            AddResponseCommandData(command);
+            FinishResponse();
+            break;
+        }
+        case SetLinkSpeed:
+        {
+            ProcessLinkSpeedCommand(command);
+            break;
+        }
+        case Subscribe:
+        {
+            ProcessSubscribeCommand(command, &currentTimeTopic, 1U);
             break;
         }
 
@@ -146,93 +671,89 @@ static void ProcessCommand(MGBTCommandData* command)
     }
 }
 
+//Each frame is queued as soon as there is room for it, so timestamp pushes and the periodic
+//current time can go out back to back in the same pass. A journal replay yields to new events.
 static void ProcessManagerWork(void)
 {
-    uint32_t sysTimeStamp = GetSystemTimeStampMs();
-    if(pendingResponse.cmdType == NoOperation)
+    SendTimeEvents();
+
+    while((replayActive == 1U) &&
+          (SendJournalReplayFrame() == 1U))
     {
-        if(timeUpdated != 0U)
-        {
-            timeUpdated = 0U;
-            SendLatestTimestamp();
-            lastResponseSent = 1U;
-        }
-        else if((lastTimeTimeUpdate + TIMEUPDATEPERIOD) <= sysTimeStamp)
-        {
-            lastTimeTimeUpdate = sysTimeStamp;
-            SendCurrentTime();
-            lastResponseSent = 1U;
-        }
+    }
+
+    if((IsTopicDue(&currentTimeTopic) == 1U) &&
+       (CanSendResponse() != 0U) &&
+       (SendCurrentTime(0U) == 1U))
+    {
+        MarkTopicSent(&currentTimeTopic);
     }
 }
 
-static void SendPendingResponse(void)
+//Finished laps are sent to the central as they come in. While the time event queue is full they wait
+//on the bus, for a central that does not acknowledge them they only get lost once the bus runs over.
+static void HandleEvents(void)
 {
-    if(pendingResponse.cmdType != NoOperation)
+    BusEvent event;
+
+    while((CommMgrIsReadyToSendNextTime() == 1U) &&
+          (EventBusGet(SubscriberCommunication, &event) == 1U))
     {
-        SendResponse(&pendingResponse, lastResponseSent);
-        if(lastResponseSent == 1U)
+        if(event.type == EventLapFinished)
         {
-            memset(&pendingResponse, 0, sizeof(MGBTCommandData));
+            (void)CommMgrSendTimeValue(LastLapTime, GetLapDuration1us(&laps[event.value]), laps[event.value].traceId);
         }
     }
 }
 
+//Commands are read in place from the receive ring and answered in the order they arrived,
+//as many as the transmit ring has room for. Pushes wait until none are left.
 void RunCommunicationManager(void)
 {
+    HandleEvents();
     RunCommProto();
-    if(CommandAvailable() != 0U)
+    while((CommandAvailable() != 0U) &&
+          (CanSendResponse() != 0U))
     {
         ProcessCommand(GetAndClearCommand());
     }
-    ProcessManagerWork();
-    if(CanSendResponse() != 0U)
-    {
-        SendPendingResponse();
-    }
-}
 
-void CommMgrSendTimeValue(CommTimeType timeType, uint32_t timeValue)
-{
-    timeUpdated = 1U;
-    latestTimestampType = timeType;
-    latestTimestamp = timeValue;
-}
-
-uint8_t CommMgrIsReadyToSendNextTime(void)
-{
-    uint8_t retVal = 0U;
-    if(timeUpdated == 0U)
+    if(CommandAvailable() == 0U)
     {
-        retVal = 1U;
+        ProcessManagerWork();
     }
-    return retVal;
 }
 
-uint8_t CommMgrHasNewDisplayUpdate(void)
+//Queues the time for the central and numbers it. Returns 0 when the queue is full, the time is dropped then.
+//The trace ID is that of the sensor trigger behind the time, 0 for none.
+uint8_t CommMgrSendTimeValue(CommTimeType timeType, Timestamp1us timeValue, uint32_t traceId)
 {
     uint8_t retVal = 0U;
-    if(displayTime > 0U)
+    if(timeEventCount < TIMEEVENTQUEUELENGTH)
     {
+        TimeEvent* event = &timeEvents[(timeEventHead + timeEventCount) % TIMEEVENTQUEUELENGTH];
+        latestTimestampSequence++;
+        latestTimestampType = timeType;
+        latestTimestamp = timeValue;
+        event->sequence = latestTimestampSequence;
+        event->type = timeType;
+        event->time = timeValue;
+        event->queueTime = GetSystemTimeStampMs();
+        event->traceId = traceId;
+        timeEventCount++;
+        SensorTraceMark(traceId, TraceStageHandedOff);
         retVal = 1U;
     }
     return retVal;
 }
 
-uint32_t CommMgrGetNewDisplayValue(void)
-{
-    uint32_t retVal = displayTime;
-    displayTime = 0U;
-    return retVal;
-}
-
-uint8_t CommMgrGetNewConfig(void)
+//There is room for another time in the queue.
+uint8_t CommMgrIsReadyToSendNextTime(void)
 {
     uint8_t retVal = 0U;
-    if(newConfig != 0U)
+    if(timeEventCount < TIMEEVENTQUEUELENGTH)
     {
-        retVal = newConfig;
-        newConfig = 0U;
+        retVal = 1U;
     }
     return retVal;
 }
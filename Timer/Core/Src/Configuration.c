@@ -8,8 +8,10 @@
 #include "Configuration.h"
 #include "TimeMgmt.h"
 #include "Inputs.h"
+#include "EventBus.h"
 
 #include "stm32f1xx_ll_i2c.h"
+#include "stm32f1xx_ll_gpio.h"
 #include <stdint.h>
 
 #define RTC_SLAVE_ADDRESS 0x68
@@ -160,6 +162,28 @@ void RunAutoConfiguration(void)
     }
 }
 
+//Blinks the LED on every PPS pulse and powers the display lines once the supply has settled.
+void RunStatusOutputs(void)
+{
+    BusEvent ledEvent;
+
+    RunTimeMgmt();
+    while(EventBusGet(SubscriberStatusLed, &ledEvent) == 1U)
+    {
+        LL_GPIO_TogglePin(GPIOC, LL_GPIO_PIN_13);
+    }
+
+    //Display line 1 and 2 enable on PB0 and PB1.
+    if(enableDisplayLines != 0U)
+    {
+        LL_GPIO_SetOutputPin(GPIOB, LL_GPIO_PIN_0 | LL_GPIO_PIN_1);
+    }
+    else
+    {
+        LL_GPIO_ResetOutputPin(GPIOB, LL_GPIO_PIN_0 | LL_GPIO_PIN_1);
+    }
+}
+
 uint32_t GetConfigBCDDisplay(void)
 {
     uint32_t retVal = 0U;
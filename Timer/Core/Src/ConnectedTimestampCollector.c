@@ -5,62 +5,26 @@
  *      Author: cdromke
  */
 
-#include <string.h>
-
 #include "TimeMgmt.h"
+#include "SensorEventQueue.h"
 #include "CommunicationManager.h"
 #include "ConnectedTimestampCollector.h"
 
-typedef struct
-{
-    uint32_t time;
-    CommTimeType type;
-} CommunicatedTimeStamp;
-
-static CommunicatedTimeStamp lastStartTime = {0};
-static CommunicatedTimeStamp lastFinishTime = {0};
-
-static void SendTimeValue(CommunicatedTimeStamp* timeStamp)
-{
-    if(timeStamp != (CommunicatedTimeStamp*)0)
-    {
-        CommMgrSendTimeValue(timeStamp->type, timeStamp->time);
-        memset(timeStamp, 0, sizeof(CommunicatedTimeStamp));
-    }
-}
-
+//Sensor events stay in their queue until the communication manager has room for them,
+//so back to back starts and finishes are all sent and none is overwritten.
 void RunConnectedTimestampCollector()
 {
     SensorTimestamp timeStamp;
 
-    if(sensorStartStopInterrupt == 1U)
+    if((CommMgrIsReadyToSendNextTime() == 1U) &&
+       (SensorEventQueuePop(SensorInputStartStop, &timeStamp) == 1U))
     {
-        sensorStartStopInterrupt = 0U;
-        GetStartStopSensorTimeStamp(&timeStamp);
-        lastStartTime.time = GetMillisecondsFromTimeStampPPS(&timeStamp) * 100U;
-        lastStartTime.type = StartSensorTimeStamp;
+        (void)CommMgrSendTimeValue(StartSensorTimeStamp, GetPpsTimestamp1us(&timeStamp), timeStamp.traceId);
     }
 
-    if(sensorStopInterrupt == 1U)
+    if((CommMgrIsReadyToSendNextTime() == 1U) &&
+       (SensorEventQueuePop(SensorInputStop, &timeStamp) == 1U))
     {
-        sensorStopInterrupt = 0U;
-        GetStopSensorTimeStamp(&timeStamp);
-        lastFinishTime.time = GetMillisecondsFromTimeStampPPS(&timeStamp) * 100U;
-        lastFinishTime.type = FinishSensorTimeStamp;
+        (void)CommMgrSendTimeValue(FinishSensorTimeStamp, GetPpsTimestamp1us(&timeStamp), timeStamp.traceId);
     }
-
-    if(CommMgrIsReadyToSendNextTime() == 1U)
-    {
-        if(lastStartTime.type == StartSensorTimeStamp)
-        {
-            SendTimeValue(&lastStartTime);
-
-        }
-        else if(lastFinishTime.type == FinishSensorTimeStamp)
-        {
-            SendTimeValue(&lastFinishTime);
-        }
-    }
-
-
 }
@@ -16,11 +16,11 @@ static uint32_t CalculateSecondsComponent(uint32_t milliSeconds);
 static uint32_t CalculateMillisecondsComponent(uint32_t milliSeconds);
 static void UpdateDisplayedTime(uint32_t milliseconds, uint8_t cutOffLastDigits);
 
-static uint32_t displayResultUntil = 0U;
+static Timestamp1us displayResultUntil = 0U;
 static uint8_t permanentResultDisplay = 0U;
 static uint32_t displayedResult = 0U;
-static uint32_t runningTimeStartTime = 0U;
-static uint32_t lastDisplayUpdate = 0U;
+static Timestamp1us runningTimeStartTime = 0U;
+static Timestamp1us lastDisplayUpdate = 0U;
 static DisplayTimeExpiredAction timeExpiredAction = DTEA_ShowRunningTime;
 
 static uint8_t displayConfig = 1U;
@@ -31,7 +31,7 @@ void UpdateDisplay(uint32_t newTimeInMs, uint32_t displayDurationInMs, DisplayTi
     {
         if(displayDurationInMs > 0U)
         {
-            displayResultUntil = GetSystemTimeStampMs() + displayDurationInMs;
+            displayResultUntil = GetSystemTime1us() + ((Timestamp1us)displayDurationInMs * 1000U);
             permanentResultDisplay = 0U;
         }
         else
@@ -48,11 +48,11 @@ void UpdateDisplay(uint32_t newTimeInMs, uint32_t displayDurationInMs, DisplayTi
 
 }
 
-void ResetRunningDisplayTime(uint32_t startTime)
+void ResetRunningDisplayTime(Timestamp1us startTime)
 {
     if(startTime == 0U)
     {
-        runningTimeStartTime = GetSystemTimeStampMs();
+        runningTimeStartTime = GetSystemTime1us();
     }
     else
     {
@@ -62,7 +62,7 @@ void ResetRunningDisplayTime(uint32_t startTime)
     displayConfig = 0U;
 }
 
-static void UpdateDisplayAfterTimeElapsed(uint32_t timeStamp)
+static void UpdateDisplayAfterTimeElapsed(Timestamp1us timeStamp)
 {
     switch(timeExpiredAction)
     {
@@ -70,19 +70,19 @@ static void UpdateDisplayAfterTimeElapsed(uint32_t timeStamp)
             UpdateDisplayedTime(0, 0U);
             break;
         default:
-            UpdateDisplayedTime(timeStamp - runningTimeStartTime, 1U);
+            UpdateDisplayedTime((uint32_t)((timeStamp - runningTimeStartTime) / 1000U), 1U);
             break;
     }
 }
 
 void RunDisplay(void)
 {
-    uint32_t timeStamp = GetSystemTimeStampMs();
+    Timestamp1us timeStamp = GetSystemTime1us();
 
     if((timeStamp < displayResultUntil) ||
        (permanentResultDisplay == 1U))
     {
-        if(((lastDisplayUpdate + 500U) < timeStamp))
+        if(((lastDisplayUpdate + 500000U) < timeStamp))
         {
             UpdateDisplayedTime(displayedResult, 0U);
 
@@ -90,7 +90,7 @@ void RunDisplay(void)
     }
     else
     {
-        if((lastDisplayUpdate + 100U) < timeStamp)
+        if((lastDisplayUpdate + 100000U) < timeStamp)
         {
             UpdateDisplayAfterTimeElapsed(timeStamp);
         }
@@ -134,7 +134,7 @@ static void UpdateDisplayedTime(uint32_t milliseconds, uint8_t cutOffLastDigits)
     {
         UpdateMax7219Display(bcdDisplayData);
     }
-    lastDisplayUpdate = GetSystemTimeStampMs();
+    lastDisplayUpdate = GetSystemTime1us();
 }
 
 static uint32_t CalculateMinutesComponent(uint32_t milliSeconds)
@@ -0,0 +1,80 @@
+/*
+ * EventBus.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "EventBus.h"
+
+#if (EVENTBUSLENGTH & (EVENTBUSLENGTH - 1U)) != 0U
+#error "EVENTBUSLENGTH must be a power of two"
+#endif
+
+#define EVENTBUSMASK (EVENTBUSLENGTH - 1U)
+#define EVENTTYPEBIT(type) (1U << (type))
+
+//Event types per subscriber. A new consumer gets an entry here, the publishers stay as they are.
+static const uint32_t subscriptions[NbOfEventSubscribers] =
+{
+    EVENTTYPEBIT(EventLapFinished) | EVENTTYPEBIT(EventRunStarted) |
+    EVENTTYPEBIT(EventDisplayTime) | EVENTTYPEBIT(EventNewConfig), //SubscriberRaceTiming
+    EVENTTYPEBIT(EventLapFinished), //SubscriberCommunication
+    EVENTTYPEBIT(EventPpsTick) //SubscriberStatusLed
+};
+
+static BusEvent events[EVENTBUSLENGTH] = {0};
+//Number of events published, the next one goes to events[head & EVENTBUSMASK].
+static uint32_t head = 0U;
+//Number of the next event each subscriber reads. Never more than EVENTBUSLENGTH behind head.
+static uint32_t cursors[NbOfEventSubscribers] = {0U};
+static uint32_t dropCounts[NbOfEventSubscribers] = {0U};
+
+static uint8_t IsSubscribed(uint8_t subscriber, uint8_t type)
+{
+    return ((subscriptions[subscriber] & EVENTTYPEBIT(type)) != 0U) ? 1U : 0U;
+}
+
+void EventBusPublish(EventType type, uint32_t value)
+{
+    uint8_t subscriber;
+
+    //The oldest event makes room, subscribers that have not read it move past it.
+    for(subscriber = 0U; subscriber < NbOfEventSubscribers; subscriber++)
+    {
+        if((head - cursors[subscriber]) == EVENTBUSLENGTH)
+        {
+            if(IsSubscribed(subscriber, events[cursors[subscriber] & EVENTBUSMASK].type) == 1U)
+            {
+                dropCounts[subscriber]++;
+            }
+            cursors[subscriber]++;
+        }
+    }
+
+    events[head & EVENTBUSMASK].type = (uint8_t)type;
+    events[head & EVENTBUSMASK].value = value;
+    head++;
+}
+
+uint8_t EventBusGet(EventSubscriber subscriber, BusEvent* event)
+{
+    uint8_t retVal = 0U;
+
+    while((retVal == 0U) && (cursors[subscriber] != head))
+    {
+        const BusEvent* next = &events[cursors[subscriber] & EVENTBUSMASK];
+        cursors[subscriber]++;
+        if(IsSubscribed((uint8_t)subscriber, next->type) == 1U)
+        {
+            (*event) = (*next);
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+uint32_t EventBusGetDropCount(EventSubscriber subscriber)
+{
+    return dropCounts[subscriber];
+}
@@ -0,0 +1,309 @@
+/*
+ * EventJournal.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <string.h>
+
+#include "MGBTCrc.h"
+#include "EventJournal.h"
+
+#if (EVENTJOURNALPENDINGLENGTH & (EVENTJOURNALPENDINGLENGTH - 1U)) != 0U
+#error "EVENTJOURNALPENDINGLENGTH must be a power of two"
+#endif
+
+#define EVENTJOURNALPENDINGMASK (EVENTJOURNALPENDINGLENGTH - 1U)
+//"JRNL", written to the first slot of a page once it has been erased.
+#define PAGEMAGIC 0x4C4E524AU
+//Record layout: sequence, sensor, 0xFF, CRC, time. The CRC covers every other byte,
+//so a record that was only partly programmed never passes.
+#define RECORDSENSOROFFSET 4U
+#define RECORDCRCOFFSET 6U
+#define RECORDTIMEOFFSET 8U
+//Slots that fail to program are skipped, this many are tried for one event.
+#define APPENDATTEMPTS 3U
+
+typedef struct
+{
+    SensorTimestamp timeStamp;
+    uint8_t sensor;
+} PendingEvent;
+
+static uint8_t currentPage = FLASHPORTPAGECOUNT - 1U;
+static uint8_t nextSlot = EVENTJOURNALSLOTSPERPAGE;
+static uint32_t lastSequence = 0U;
+static uint32_t lostCount = 0U;
+
+//Single producer, single consumer like SensorEventQueue. Head is only written by the EXTI handlers.
+static PendingEvent pendingEvents[EVENTJOURNALPENDINGLENGTH] = {0};
+static uint8_t pendingHead = 0U;
+static uint8_t pendingTail = 0U;
+
+static uint32_t GetSlotOffset(uint8_t page, uint8_t slot)
+{
+    return ((uint32_t)page * FLASHPORTPAGESIZE) + ((uint32_t)slot * EVENTJOURNALRECORDLENGTH);
+}
+
+static uint8_t IsSlotErased(uint8_t page, uint8_t slot)
+{
+    const uint8_t* data = FlashPortGetData(GetSlotOffset(page, slot));
+    uint8_t retVal = 1U;
+    uint8_t index;
+
+    for(index = 0U; index < EVENTJOURNALRECORDLENGTH; index++)
+    {
+        if(data[index] != 0xFFU)
+        {
+            retVal = 0U;
+        }
+    }
+
+    return retVal;
+}
+
+static uint8_t IsPageFormatted(uint8_t page)
+{
+    uint32_t magic;
+    memcpy(&magic, FlashPortGetData(GetSlotOffset(page, 0U)), sizeof(magic));
+    return (magic == PAGEMAGIC) ? 1U : 0U;
+}
+
+static uint16_t GetRecordCrc(const uint8_t* record)
+{
+    uint16_t crc = MGBTCrcCalculate(record, RECORDCRCOFFSET);
+    return MGBTCrcUpdate(crc, &record[RECORDTIMEOFFSET], EVENTJOURNALRECORDLENGTH - RECORDTIMEOFFSET);
+}
+
+//Returns 1 when the slot holds a complete record.
+static uint8_t ReadRecord(uint8_t page, uint8_t slot, JournalEvent* event)
+{
+    const uint8_t* record = FlashPortGetData(GetSlotOffset(page, slot));
+    uint8_t retVal = 0U;
+    uint16_t crc;
+
+    memcpy(&crc, &record[RECORDCRCOFFSET], sizeof(crc));
+    if(crc == GetRecordCrc(record))
+    {
+        memcpy(&event->sequence, record, sizeof(event->sequence));
+        memcpy(&event->time, &record[RECORDTIMEOFFSET], sizeof(event->time));
+        event->sensor = record[RECORDSENSOROFFSET];
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+//Finds the first complete record at or after slot, records of a page are written in order
+//and the first erased slot ends them.
+static uint8_t FindRecordInPage(uint8_t page, uint8_t slot, uint32_t fromSequence, JournalEvent* event)
+{
+    uint8_t retVal = 0U;
+
+    while((retVal == 0U) && (slot < EVENTJOURNALSLOTSPERPAGE) && (IsSlotErased(page, slot) == 0U))
+    {
+        if((ReadRecord(page, slot, event) == 1U) && (event->sequence >= fromSequence))
+        {
+            retVal = 1U;
+        }
+        slot++;
+    }
+
+    return retVal;
+}
+
+static uint8_t StartNextPage(void)
+{
+    const uint16_t header[2] = {(uint16_t)(PAGEMAGIC & 0xFFFFU), (uint16_t)(PAGEMAGIC >> 16)};
+    uint8_t page = (uint8_t)((currentPage + 1U) % FLASHPORTPAGECOUNT);
+    uint8_t retVal = 0U;
+
+    if((FlashPortErasePage(page) == 1U) &&
+       (FlashPortProgram(GetSlotOffset(page, 0U), header, 2U) == 1U))
+    {
+        retVal = 1U;
+    }
+    //A page that failed is passed over next time, its header does not match.
+    currentPage = page;
+    nextSlot = (retVal == 1U) ? 1U : EVENTJOURNALSLOTSPERPAGE;
+
+    return retVal;
+}
+
+//The newest record decides where writing continues. Slots behind it, including ones a reset
+//left half written, cannot be programmed again until their page is erased.
+void EventJournalInit(void)
+{
+    uint8_t page;
+    uint8_t slot;
+    JournalEvent event;
+
+    currentPage = FLASHPORTPAGECOUNT - 1U;
+    nextSlot = EVENTJOURNALSLOTSPERPAGE;
+    lastSequence = 0U;
+
+    for(page = 0U; page < FLASHPORTPAGECOUNT; page++)
+    {
+        if(IsPageFormatted(page) == 1U)
+        {
+            uint8_t usedSlots = 1U;
+            uint32_t pageSequence = 0U;
+            for(slot = 1U; slot < EVENTJOURNALSLOTSPERPAGE; slot++)
+            {
+                if(IsSlotErased(page, slot) == 0U)
+                {
+                    usedSlots = (uint8_t)(slot + 1U);
+                    if((ReadRecord(page, slot, &event) == 1U) && (event.sequence > pageSequence))
+                    {
+                        pageSequence = event.sequence;
+                    }
+                }
+            }
+
+            if(pageSequence > lastSequence)
+            {
+                lastSequence = pageSequence;
+                currentPage = page;
+                nextSlot = usedSlots;
+            }
+        }
+    }
+}
+
+void EventJournalRecord(SensorInput input, const SensorTimestamp* timeStamp)
+{
+    uint8_t head = pendingHead;
+    uint8_t tail = __atomic_load_n(&pendingTail, __ATOMIC_ACQUIRE);
+
+    if((uint8_t)(head - tail) < EVENTJOURNALPENDINGLENGTH)
+    {
+        PendingEvent* pending = &pendingEvents[head & EVENTJOURNALPENDINGMASK];
+        pending->timeStamp = (*timeStamp);
+        pending->sensor = (uint8_t)input;
+        //Publish the event only after its contents are written.
+        __atomic_store_n(&pendingHead, (uint8_t)(head + 1U), __ATOMIC_RELEASE);
+    }
+    else
+    {
+        lostCount++;
+    }
+}
+
+//Writing stalls the CPU for about 0.5ms per event and 20ms when a page has to be erased.
+//The sensor times are captured by the timers, so a stalled interrupt still gets the exact time.
+void RunEventJournal(void)
+{
+    uint8_t tail = pendingTail;
+    uint8_t head = __atomic_load_n(&pendingHead, __ATOMIC_ACQUIRE);
+
+    while(head != tail)
+    {
+        PendingEvent pending = pendingEvents[tail & EVENTJOURNALPENDINGMASK];
+        //Hand the slot back only after it has been copied.
+        tail++;
+        __atomic_store_n(&pendingTail, tail, __ATOMIC_RELEASE);
+        if(EventJournalAppend(pending.sensor, GetPpsTimestamp1us(&pending.timeStamp)) == 0U)
+        {
+            lostCount++;
+        }
+    }
+}
+
+uint8_t EventJournalAppend(uint8_t sensor, Timestamp1us time)
+{
+    uint8_t record[EVENTJOURNALRECORDLENGTH];
+    uint16_t halfWords[EVENTJOURNALRECORDLENGTH / 2U];
+    uint32_t sequence = lastSequence + 1U;
+    uint16_t crc;
+    uint8_t attempt;
+    uint8_t retVal = 0U;
+
+    memset(record, 0xFF, sizeof(record));
+    memcpy(record, &sequence, sizeof(sequence));
+    record[RECORDSENSOROFFSET] = sensor;
+    memcpy(&record[RECORDTIMEOFFSET], &time, sizeof(time));
+    crc = GetRecordCrc(record);
+    memcpy(&record[RECORDCRCOFFSET], &crc, sizeof(crc));
+    memcpy(halfWords, record, sizeof(halfWords));
+
+    for(attempt = 0U; (attempt < APPENDATTEMPTS) && (retVal == 0U); attempt++)
+    {
+        if((nextSlot < EVENTJOURNALSLOTSPERPAGE) || (StartNextPage() == 1U))
+        {
+            uint8_t slot = nextSlot;
+            nextSlot++;
+            retVal = FlashPortProgram(GetSlotOffset(currentPage, slot), halfWords, EVENTJOURNALRECORDLENGTH / 2U);
+        }
+    }
+
+    if(retVal == 1U)
+    {
+        lastSequence = sequence;
+    }
+
+    return retVal;
+}
+
+//The pages are searched from the oldest, the one after the current page, to the current page.
+//The search starts in the last page that begins at or before fromSequence. Without lost slots
+//the record sits at a known distance from the first one of that page.
+uint8_t EventJournalFind(uint32_t fromSequence, JournalEvent* event)
+{
+    uint8_t retVal = 0U;
+    uint8_t startIndex = FLASHPORTPAGECOUNT;
+    uint8_t startSlot = 1U;
+    uint8_t index;
+
+    if((lastSequence != 0U) && (fromSequence <= lastSequence))
+    {
+        for(index = 0U; index < FLASHPORTPAGECOUNT; index++)
+        {
+            uint8_t page = (uint8_t)((currentPage + 1U + index) % FLASHPORTPAGECOUNT);
+            if((IsPageFormatted(page) == 1U) &&
+               (FindRecordInPage(page, 1U, 0U, event) == 1U) &&
+               ((startIndex == FLASHPORTPAGECOUNT) || (event->sequence <= fromSequence)))
+            {
+                startIndex = index;
+                startSlot = 1U;
+                if(fromSequence > event->sequence)
+                {
+                    uint32_t distance = fromSequence - event->sequence;
+                    if(distance < EVENTJOURNALRECORDSPERPAGE)
+                    {
+                        startSlot = (uint8_t)(1U + distance);
+                    }
+                }
+            }
+        }
+
+        for(index = startIndex; (index < FLASHPORTPAGECOUNT) && (retVal == 0U); index++)
+        {
+            uint8_t page = (uint8_t)((currentPage + 1U + index) % FLASHPORTPAGECOUNT);
+            if(IsPageFormatted(page) == 1U)
+            {
+                //Try the expected slot first and fall back to the whole page when slots were lost.
+                if((index == startIndex) && (startSlot > 1U) &&
+                   (ReadRecord(page, startSlot, event) == 1U) && (event->sequence == fromSequence))
+                {
+                    retVal = 1U;
+                }
+                else
+                {
+                    retVal = FindRecordInPage(page, 1U, fromSequence, event);
+                }
+            }
+        }
+    }
+
+    return retVal;
+}
+
+uint32_t EventJournalGetLastSequence(void)
+{
+    return lastSequence;
+}
+
+uint32_t EventJournalGetLostCount(void)
+{
+    return lostCount;
+}
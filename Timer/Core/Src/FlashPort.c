@@ -0,0 +1,90 @@
+/*
+ * FlashPort.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "stm32f1xx.h"
+#include "FlashPort.h"
+
+//Start of the JOURNAL region in STM32F103C8TX_FLASH.ld.
+#define FLASHPORTBASE 0x0800E000U
+
+//Programming needs the HSI oscillator, which stays on after the switch to the PLL.
+static void Unlock(void)
+{
+    if((FLASH->CR & FLASH_CR_LOCK) != 0U)
+    {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+}
+
+static void Lock(void)
+{
+    FLASH->CR |= FLASH_CR_LOCK;
+}
+
+//Returns 1 when the last operation finished without a programming or write protection error.
+static uint8_t WaitForOperation(void)
+{
+    uint8_t retVal = 0U;
+
+    while((FLASH->SR & FLASH_SR_BSY) != 0U)
+    {
+    }
+    if((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) == 0U)
+    {
+        retVal = 1U;
+    }
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+
+    return retVal;
+}
+
+uint8_t FlashPortErasePage(uint8_t page)
+{
+    uint8_t retVal = 0U;
+
+    if(page < FLASHPORTPAGECOUNT)
+    {
+        Unlock();
+        FLASH->CR |= FLASH_CR_PER;
+        FLASH->AR = FLASHPORTBASE + ((uint32_t)page * FLASHPORTPAGESIZE);
+        FLASH->CR |= FLASH_CR_STRT;
+        retVal = WaitForOperation();
+        FLASH->CR &= ~FLASH_CR_PER;
+        Lock();
+    }
+
+    return retVal;
+}
+
+//Stops at the first half word that fails, a half word that is not erased cannot be programmed.
+uint8_t FlashPortProgram(uint32_t offset, const uint16_t* data, uint16_t halfWords)
+{
+    uint8_t retVal = 0U;
+    uint16_t index;
+
+    if(((offset & 1U) == 0U) && ((offset + ((uint32_t)halfWords * 2U)) <= FLASHPORTSIZE))
+    {
+        volatile uint16_t* destination = (volatile uint16_t*)(FLASHPORTBASE + offset);
+        retVal = 1U;
+        Unlock();
+        FLASH->CR |= FLASH_CR_PG;
+        for(index = 0U; (index < halfWords) && (retVal == 1U); index++)
+        {
+            destination[index] = data[index];
+            retVal = WaitForOperation();
+        }
+        FLASH->CR &= ~FLASH_CR_PG;
+        Lock();
+    }
+
+    return retVal;
+}
+
+const uint8_t* FlashPortGetData(uint32_t offset)
+{
+    return (const uint8_t*)(FLASHPORTBASE + offset);
+}
@@ -9,12 +9,8 @@
 #include "TimeMgmt.h"
 #include "stm32f1xx_ll_gpio.h"
 
-#define INPUTUPDATETIME 100U // In increments of 100us. Div by 10 for update cycle time in ms.
-
 DigitalInput UserInputs[NbOfInputs] = { 0 };
 
-static uint32_t NextUpdateTime;
-
 void InitInputs(void)
 {
     UserInputs[Button1].ioPin.ioPort = GPIOA;
@@ -31,39 +27,32 @@ void InitInputs(void)
 
     UserInputs[JmpSensorCount].ioPin.ioPort = GPIOB;
     UserInputs[JmpSensorCount].ioPin.gpioPin = LL_GPIO_PIN_9;
-
-    NextUpdateTime = systemTime.timeStamp100us + INPUTUPDATETIME;
 }
 
+//Runs as a scheduler task every 10ms.
 void UpdateAllInputs(void)
 {
+    uint32_t currentTimeStamp = GetSystemTimeStamp100us();
+    uint8_t index;
 
-    uint32_t currentTimeStamp = systemTime.timeStamp100us;
-    if(currentTimeStamp > NextUpdateTime)
+    for(index = (uint8_t)Button1; index < (uint8_t)NbOfInputs; index++)
     {
-        uint8_t index;
+        DigitalInput* input = &UserInputs[index];
+        uint8_t inputState = input->currentState;
+        input->currentState = (uint8_t)LL_GPIO_IsInputPinSet(input->ioPin.ioPort, input->ioPin.gpioPin);
 
-        for(index = (uint8_t)Button1; index < (uint8_t)NbOfInputs; index++)
+        if((input->currentState == inputState))
         {
-            DigitalInput* input = &UserInputs[index];
-            uint8_t inputState = input->currentState;
-            input->currentState = (uint8_t)LL_GPIO_IsInputPinSet(input->ioPin.ioPort, input->ioPin.gpioPin);
-
-            if((input->currentState == inputState))
+            if((currentTimeStamp - input->timestampLastEdge) > DEBOUNCETIME)
             {
-                if((input->timestampLastEdge + DEBOUNCETIME) < currentTimeStamp)
-                {
-                    input->currentStateAfterDebounce = input->currentState;
-                }
+                input->currentStateAfterDebounce = input->currentState;
             }
-            else
-            {
-                input->timestampLastEdge = currentTimeStamp;
-            }
-
+        }
+        else
+        {
+            input->timestampLastEdge = currentTimeStamp;
         }
 
-        NextUpdateTime = currentTimeStamp + INPUTUPDATETIME;
     }
 }
 
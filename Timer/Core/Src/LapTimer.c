@@ -15,54 +15,75 @@
 #include "LapTimer.h"
 #include "Configuration.h"
 #include "TimeMgmt.h"
+#include "SensorEventQueue.h"
+#include "EventBus.h"
+
+#if (MAXLAPCOUNT < 2) || (MAXLAPCOUNT > 255)
+#error "MAXLAPCOUNT must be between 2 and 255, lap indexes are 8 bit"
+#endif
+#if (MAXSIMULTANEOUSRIDERS < 1) || (MAXSIMULTANEOUSRIDERS >= MAXLAPCOUNT)
+#error "MAXSIMULTANEOUSRIDERS must be at least 1 and below MAXLAPCOUNT, so the last finished lap stays in the buffer"
+#endif
 
 Lap laps[MAXLAPCOUNT] = { 0 };
-static Lap* currentLap = 0U;
+//Laps are numbered in the order they start, lap n is kept in laps[n % MAXLAPCOUNT].
+//The laps from lapTail up to lapHead have started and not finished, the oldest finishes first.
+//The single run modes start the next lap ahead, with a start time of 0 until it is triggered.
+static uint32_t lapHead = 0U;
+static uint32_t lapTail = 0U;
 static Lap* previousLap = 0U;
-static Lap* lastStartedLap = 0U;
-uint8_t lapFinished = 0U;
-uint8_t newRunStarted = 0U;
+static uint32_t lastLapSequence = 0U;
+//Finished lap n sits in laps[finishedLapIndex[n % MAXLAPCOUNT]] until its slot is reused.
+static uint8_t finishedLapIndex[MAXLAPCOUNT] = { 0 };
+static uint32_t rejectedStartCount = 0U;
 
 
 static void SingleSensorLaptimer(void);
 static void SingleSensorSingeRuntimer(void);
 static void DualSensorSingleRunTimer(void);
 static void DualSensorMultiRunTimer(void);
-static uint8_t IsLastLap(Lap* lap);
 static uint8_t IsLapValid(Lap* lap);
 static void InvalidateLap(Lap* lap);
-static uint8_t GetRunningLapCount(void);
-static Lap* GetNextLap(Lap* lap);
+
+static Lap* GetLapByNumber(uint32_t number)
+{
+	return &laps[number % MAXLAPCOUNT];
+}
 
 uint8_t GetLapIndex(Lap* lap)
 {
 	uint8_t retVal = MAXLAPCOUNT;
 
-	if(lap != (Lap*)0U)
+	if((lap != (Lap*)0U) && (lap >= &laps[0]) && (lap < &laps[MAXLAPCOUNT]))
 	{
-		uint8_t index;
-		for(index = 0U; index < MAXLAPCOUNT; index++)
-		{
-			if(lap == &laps[index])
-			{
-				retVal = index;
-			}
-		}
+		retVal = (uint8_t)(lap - &laps[0]);
 	}
 
 	return retVal;
 }
 
+//The lap that finishes next or, while none runs, the last one that started.
 Lap* GetCurrentLap(void)
 {
-    return currentLap;
+	Lap* retVal = (Lap*)0U;
+
+	if(lapHead != lapTail)
+	{
+		retVal = GetLapByNumber(lapTail);
+	}
+	else if(lapHead != 0U)
+	{
+		retVal = GetLapByNumber(lapHead - 1U);
+	}
+
+	return retVal;
 }
 
 uint8_t IsFirstLap(void)
 {
     uint8_t retVal = 0U;
 
-    if((currentLap != (Lap*)0U) && (previousLap == (Lap*)0U))
+    if((GetCurrentLap() != (Lap*)0U) && (previousLap == (Lap*)0U))
     {
         retVal = 1U;
     }
@@ -72,43 +93,27 @@ uint8_t IsFirstLap(void)
 
 static uint8_t GetRunningLapCount(void)
 {
-	uint8_t retVal = 0U;
-	if (lastStartedLap != (Lap*)0U)
-	{
-		if (lastStartedLap < currentLap)
-		{
-			retVal = (uint8_t)(&laps[MAXLAPCOUNT-1] - currentLap);
-			//By looking at the pointer to the last position in the array, we don't count that last position. Correct this.
-			retVal++;
-			retVal += (uint8_t)(lastStartedLap - &laps[0]);
-			//This branch will only be reached when more than one rider is in the field.
-			//By looking at the pointer to the last started lap and subtracting the start of the array from it, we don't count the last started lap.
-			retVal++;
-		}
-		else
-		{
-			retVal = (uint8_t)(lastStartedLap - currentLap);
-			//In case the current lap and last started lap are the same, but current lap is still running, count it.
-			if (currentLap->endTimeStamp == 0U)
-			{
-				retVal++;
-			}
-		}
-	}
-	return retVal;
+	return (uint8_t)(lapHead - lapTail);
 }
 
-static Lap* GetNextLap(Lap* lap)
+//Takes the slot after the last started lap. A start never overwrites a lap that has not finished,
+//when every slot holds one it is refused and 0 is returned.
+static Lap* StartLap(void)
 {
 	Lap* retVal = (Lap*)0U;
-	if (IsLastLap(lap) == 1U)
+
+	if(GetRunningLapCount() < MAXLAPCOUNT)
 	{
-		retVal = &laps[0];
+		retVal = GetLapByNumber(lapHead);
+		retVal->startTimeStamp = 0U;
+		retVal->endTimeStamp = 0U;
+		retVal->sequence = 0U;
+		retVal->traceId = 0U;
+		lapHead++;
 	}
 	else
 	{
-		retVal = lap;
-		retVal++;
+		rejectedStartCount++;
 	}
 
 	return retVal;
@@ -116,9 +121,10 @@ static Lap* GetNextLap(Lap* lap)
 
 uint32_t GetCurrentLapStartTime(void)
 {
+    Lap* currentLap = GetCurrentLap();
     if(currentLap != (Lap*)0U)
     {
-        return currentLap->startTimeStamp / 10U;
+        return (uint32_t)(currentLap->startTimeStamp / 1000U);
     }
 
     return 0U;
@@ -126,10 +132,15 @@ uint32_t GetCurrentLapStartTime(void)
 
 uint32_t GetLapDurationMs(Lap* lap)
 {
-    uint32_t retVal = 0U;
+    return (uint32_t)(GetLapDuration1us(lap) / 1000U);
+}
+
+Timestamp1us GetLapDuration1us(Lap* lap)
+{
+    Timestamp1us retVal = 0U;
     if(lap != (Lap*)0U)
     {
-        retVal = ((lap->endTimeStamp - lap->startTimeStamp) / 10U);
+        retVal = lap->endTimeStamp - lap->startTimeStamp;
     }
     return retVal;
 }
@@ -141,7 +152,14 @@ Lap* GetPreviousLap(void)
 
 Lap* GetLastStartedLap(void)
 {
-	return lastStartedLap;
+	Lap* retVal = (Lap*)0U;
+
+	if(lapHead != 0U)
+	{
+		retVal = GetLapByNumber(lapHead - 1U);
+	}
+
+	return retVal;
 }
 
 static uint8_t IsLapValid(Lap* lap)
@@ -150,8 +168,8 @@ static uint8_t IsLapValid(Lap* lap)
 
 	if (lap != (Lap*)0U)
 	{
-		if ((lap->startTimeStamp != 0xFFFFFFFFU) &&
-			(lap->endTimeStamp != 0xFFFFFFFFU))
+		if ((lap->startTimeStamp != LAPTIMESTAMPINVALID) &&
+			(lap->endTimeStamp != LAPTIMESTAMPINVALID))
 		{
 			retVal = 1U;
 		}
@@ -164,8 +182,8 @@ static void InvalidateLap(Lap* lap)
 {
 	if (lap != (Lap*)0U)
 	{
-		lap->startTimeStamp = 0xFFFFFFFFU;
-		lap->endTimeStamp = 0xFFFFFFFFU;
+		lap->startTimeStamp = LAPTIMESTAMPINVALID;
+		lap->endTimeStamp = LAPTIMESTAMPINVALID;
 	}
 }
 
@@ -177,6 +195,58 @@ void InvalidateLapIndex(uint8_t index)
 	}
 }
 
+uint32_t GetLastLapSequence(void)
+{
+	return lastLapSequence;
+}
+
+uint32_t GetRejectedStartCount(void)
+{
+	return rejectedStartCount;
+}
+
+//Oldest finished lap numbered after sequence. Laps that have been overwritten in the buffer are gone,
+//the gap in the sequence numbers tells the central. Only older laps than the buffer holds are skipped
+//one by one, reading laps in order takes one step per lap.
+Lap* GetFinishedLapAfter(uint32_t sequence)
+{
+	Lap* retVal = (Lap*)0U;
+	uint32_t candidate = sequence + 1U;
+
+	//Lap numbers before this one have had their index entry reused.
+	if(lastLapSequence >= MAXLAPCOUNT)
+	{
+		uint32_t oldest = lastLapSequence - MAXLAPCOUNT + 1U;
+		if(candidate < oldest)
+		{
+			candidate = oldest;
+		}
+	}
+
+	while((retVal == (Lap*)0U) &&
+		  (candidate > sequence) &&
+		  (candidate <= lastLapSequence))
+	{
+		Lap* lap = &laps[finishedLapIndex[candidate % MAXLAPCOUNT]];
+		if((lap->sequence == candidate) &&
+		   (IsLapValid(lap) == 1U))
+		{
+			retVal = lap;
+		}
+		candidate++;
+	}
+
+	return retVal;
+}
+
+static void NumberFinishedLap(Lap* lap)
+{
+	lastLapSequence++;
+	lap->sequence = lastLapSequence;
+	lap->sensorMode = (uint8_t)sensorMode;
+	finishedLapIndex[lastLapSequence % MAXLAPCOUNT] = GetLapIndex(lap);
+}
+
 void RunStandAloneTimer(void)
 {
     switch(operationMode)
@@ -216,82 +286,96 @@ void RunStandAloneTimer(void)
     }
 }
 
-static uint8_t IsLastLap(Lap* lap)
+static void FinishCurrentLap(SensorTimestamp* timeStamp)
 {
-    uint8_t retVal = 0U;
-    if(lap == (&laps[MAXLAPCOUNT - 1]))
-    {
-        retVal = 1U;
-    }
+    Lap* lap = GetLapByNumber(lapTail);
+    lap->endTimeStamp = GetPpsTimestamp1us(timeStamp);
+    lap->traceId = timeStamp->traceId;
+    NumberFinishedLap(lap);
+    EventBusPublish(EventLapFinished, GetLapIndex(lap));
+    previousLap = lap;
+    lapTail++;
+}
 
-    return retVal;
+//Returns the next lap, it has not started yet.
+static Lap* FinishCurrentLapAndPrepareNext(SensorTimestamp* timeStamp)
+{
+    FinishCurrentLap(timeStamp);
+    return StartLap();
 }
 
-static void FinishCurrentLapAndPrepareNext(SensorTimestamp* timeStamp)
+static uint8_t IsLapRunning(Lap* lap)
 {
-    currentLap->endTimeStamp = GetMillisecondsFromTimeStampPPS(timeStamp);
-    lapFinished = 1U;
-    previousLap = currentLap;
-    if(IsLastLap(currentLap) == 0U)
-    {
-    	//Pointer math!
-        currentLap++;
-    }
-    else
-    {
-        currentLap = &laps[0];
-    }
+	uint8_t retVal = 0U;
+
+	if((IsLapValid(lap) == 1U) && (lap->startTimeStamp != 0U) && (lap->endTimeStamp == 0U))
+	{
+		retVal = 1U;
+	}
+
+	return retVal;
+}
+
+//Invalidated laps, and a lap a single run mode started ahead, hold no rider.
+static void DropStaleLaps(void)
+{
+	while((lapHead != lapTail) && (IsLapRunning(GetLapByNumber(lapTail)) == 0U))
+	{
+		lapTail++;
+	}
 }
 
 static void SingleSensorLaptimer(void)
 {
     SensorTimestamp timeStamp;
 
-    if(sensorStartStopInterrupt == 1U)
+    if(SensorEventQueuePop(SensorInputStartStop, &timeStamp) == 1U)
     {
-        sensorStartStopInterrupt = 0U;
-        GetStartStopSensorTimeStamp(&timeStamp);
-        newRunStarted = 1U;
+        Lap* lap;
 
-        if(currentLap == (Lap*)0U)
+        if(lapHead == lapTail)
         {
-            currentLap = &laps[0];
+            lap = StartLap();
         }
         else
         {
-            FinishCurrentLapAndPrepareNext(&timeStamp);
+            lap = FinishCurrentLapAndPrepareNext(&timeStamp);
         }
-        currentLap->startTimeStamp = GetMillisecondsFromTimeStampPPS(&timeStamp);
+        lap->startTimeStamp = GetPpsTimestamp1us(&timeStamp);
+        EventBusPublish(EventRunStarted, GetLapIndex(lap));
     }
 
 }
 
+//A start or stop trigger either finishes the running lap or starts the one prepared after it.
+static void StartOrFinishSingleRun(SensorTimestamp* timeStamp, uint8_t canStart, uint8_t canFinish)
+{
+    Lap* lap = GetCurrentLap();
+
+    if((canFinish == 1U) && (IsLapRunning(lap) == 1U))
+    {
+        (void)FinishCurrentLapAndPrepareNext(timeStamp);
+    }
+    else if((canStart == 1U) && (lap->startTimeStamp == 0U))
+    {
+        lap->startTimeStamp = GetPpsTimestamp1us(timeStamp);
+        lap->endTimeStamp = 0U;
+        EventBusPublish(EventRunStarted, GetLapIndex(lap));
+    }
+}
+
 static void SingleSensorSingeRuntimer(void)
 {
     SensorTimestamp timeStamp;
 
-    if(currentLap == (Lap*)0U)
-	{
-		currentLap = &laps[0];
-		currentLap->startTimeStamp = 0U;
-	}
-
-    if(sensorStartStopInterrupt == 1U)
+    if(lapHead == lapTail)
     {
-        sensorStartStopInterrupt = 0U;
-        GetStartStopSensorTimeStamp(&timeStamp);
+        (void)StartLap();
+    }
 
-		if((currentLap->endTimeStamp == 0U) && (currentLap->startTimeStamp != 0U))
-		{
-			FinishCurrentLapAndPrepareNext(&timeStamp);
-			currentLap->startTimeStamp = 0U;
-		}
-		else if(currentLap->startTimeStamp == 0U)
-		{
-			currentLap->startTimeStamp = GetMillisecondsFromTimeStampPPS(&timeStamp);
-			currentLap->endTimeStamp = 0U;
-			newRunStarted = 1U;
-		}
+    if(SensorEventQueuePop(SensorInputStartStop, &timeStamp) == 1U)
+    {
+        StartOrFinishSingleRun(&timeStamp, 1U, 1U);
     }
 }
 
@@ -299,114 +383,49 @@ static void DualSensorSingleRunTimer(void)
 {
     SensorTimestamp timeStamp;
 
-    if(currentLap == (Lap*)0U)
+    if(lapHead == lapTail)
     {
-        currentLap = &laps[0];
-        currentLap->startTimeStamp = 0U;
+        (void)StartLap();
     }
 
-    if(sensorStartStopInterrupt == 1U)
+    if(SensorEventQueuePop(SensorInputStartStop, &timeStamp) == 1U)
     {
-        sensorStartStopInterrupt = 0U;
-        GetStartStopSensorTimeStamp(&timeStamp);
-
-
-        if(currentLap->startTimeStamp == 0U)
-        {
-            currentLap->startTimeStamp = GetMillisecondsFromTimeStampPPS(&timeStamp);
-            currentLap->endTimeStamp = 0U;
-            newRunStarted = 1U;
-        }
+        StartOrFinishSingleRun(&timeStamp, 1U, 0U);
     }
 
-    if(sensorStopInterrupt == 1U)
+    if(SensorEventQueuePop(SensorInputStop, &timeStamp) == 1U)
     {
-        sensorStopInterrupt = 0U;
-        GetStopSensorTimeStamp(&timeStamp);
-
-        if((currentLap->endTimeStamp == 0U) && (currentLap->startTimeStamp != 0U))
-        {
-            FinishCurrentLapAndPrepareNext(&timeStamp);
-            currentLap->startTimeStamp = 0U;
-        }
-
+        StartOrFinishSingleRun(&timeStamp, 0U, 1U);
     }
 }
 
+//Riders finish in the order they started.
 static void DualSensorMultiRunTimer(void)
 {
-
 	SensorTimestamp timeStamp;
 
-	if(currentLap == (Lap*)0U)
+	if(SensorEventQueuePop(SensorInputStartStop, &timeStamp) == 1U)
 	{
-		currentLap = &laps[0];
-		currentLap->startTimeStamp = 0U;
-	}
-
-	if(sensorStartStopInterrupt == 1U)
-	{
-		sensorStartStopInterrupt = 0U;
-		GetStartStopSensorTimeStamp(&timeStamp);
-
+		DropStaleLaps();
 		if (GetRunningLapCount() < MAXSIMULTANEOUSRIDERS)
 		{
-			Lap* nextLap;
-			if (lastStartedLap == (Lap*)0U)
-			{
-				nextLap = &laps[0];
-			}
-			else
-			{
-				nextLap = GetNextLap(lastStartedLap);
-			}
-
-			nextLap->startTimeStamp = GetMillisecondsFromTimeStampPPS(&timeStamp);
-			nextLap->endTimeStamp = 0U;
-
-			if (GetRunningLapCount() == 0U)
-			{
-				currentLap = nextLap;
-			}
-
-			lastStartedLap = nextLap;
-
-			newRunStarted = 1U;
+			Lap* nextLap = StartLap();
+			nextLap->startTimeStamp = GetPpsTimestamp1us(&timeStamp);
+			EventBusPublish(EventRunStarted, GetLapIndex(nextLap));
 		}
-	}
-
-	if(sensorStopInterrupt == 1U)
-	{
-		sensorStopInterrupt = 0U;
-		GetStopSensorTimeStamp(&timeStamp);
-
-		//Skip invalid laps
-		while ((IsLapValid(currentLap)== 0U) && (currentLap != lastStartedLap))
+		else
 		{
-			currentLap = GetNextLap(currentLap);
+			rejectedStartCount++;
 		}
+	}
 
-		if((currentLap->endTimeStamp == 0U) && (currentLap->startTimeStamp != 0U))
+	if(SensorEventQueuePop(SensorInputStop, &timeStamp) == 1U)
+	{
+		DropStaleLaps();
+		if (lapHead != lapTail)
 		{
-			currentLap->endTimeStamp = GetMillisecondsFromTimeStampPPS(&timeStamp);
-			previousLap = currentLap;
-			lapFinished = 1U;
-
-			if (currentLap != lastStartedLap)
-			{
-				//Move 'current' or 'next to finish' lap up one position in the buffer
-				currentLap = GetNextLap(currentLap);
-
-				//Move up further when next to finish lap is invalid.
-				while ((IsLapValid(currentLap)== 0U) && (currentLap != lastStartedLap))
-				{
-					currentLap = GetNextLap(currentLap);
-				}
-			}
+			FinishCurrentLap(&timeStamp);
 		}
-
-
 	}
 
 }
-
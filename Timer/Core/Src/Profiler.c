@@ -0,0 +1,76 @@
+/*
+ * Profiler.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <string.h>
+
+#include "stm32f1xx.h"
+#include "Profiler.h"
+
+#ifdef TIMER_HOST_BUILD
+#include <time.h>
+#endif
+
+static ProfileStats profileStats[NbOfProfilePoints] = {0};
+
+#ifdef TIMER_HOST_BUILD
+//Nanoseconds as cycles of the board clock. Only differences are used, the truncation to 32 bit wraps like CYCCNT.
+uint32_t ProfilerGetCycles(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(((((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec) * PROFILERCYCLESPER1US) / 1000U);
+}
+#endif
+
+void ProfilerInit(void)
+{
+#ifndef TIMER_HOST_BUILD
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static uint8_t GetBucket(uint32_t cycles)
+{
+    uint8_t retVal = 0U;
+
+    if(cycles > 1U)
+    {
+        retVal = (uint8_t)(31U - (uint32_t)__builtin_clz(cycles));
+        if(retVal >= PROFILERBUCKETCOUNT)
+        {
+            retVal = PROFILERBUCKETCOUNT - 1U;
+        }
+    }
+
+    return retVal;
+}
+
+void ProfilerRecord(ProfilePoint point, uint32_t cycles)
+{
+    ProfileStats* stats = &profileStats[point];
+    uint8_t bucket = GetBucket(cycles);
+
+    stats->samples++;
+    if(cycles > stats->maxCycles)
+    {
+        stats->maxCycles = cycles;
+    }
+    if(stats->buckets[bucket] < 0xFFFFU)
+    {
+        stats->buckets[bucket]++;
+    }
+}
+
+//The interrupts are masked so a handler cannot record into the point halfway the copy.
+void ProfilerTakeStats(ProfilePoint point, ProfileStats* stats)
+{
+    __disable_irq();
+    (*stats) = profileStats[point];
+    memset(&profileStats[point], 0, sizeof(profileStats[point]));
+    __enable_irq();
+}
@@ -11,51 +11,18 @@
 #include "Display.h"
 #include "Inputs.h"
 #include "TimeMgmt.h"
-#include "CommunicationManager.h"
 #include "ConnectedTimestampCollector.h"
+#include "EventBus.h"
 
 #define DISPLAYBUFFERINDEX 1500U
-#define COMMPROTOPERIOD 10U
 
 static uint8_t lastCycleButtonState = 0U;
 static uint8_t currentBufferDisplayIndex = MAXLAPCOUNT;
 static uint32_t lastBufferDisplayChange = 0U;
 static Lap* currentlyDisplayedLapFromBuffer = (Lap*)0U;
 static DigitalInput* buttonInput = &UserInputs[JmpCommMode];
-static uint32_t lastCommunicationRun = 0U;
-
-static void RunCommunication(void)
-{
-    uint32_t timeStmp = GetSystemTimeStampMs();
-    if((timeStmp - lastCommunicationRun) >= COMMPROTOPERIOD)
-    {
-        lastCommunicationRun = timeStmp;
-        RunCommunicationManager();
-        uint8_t newConfig = CommMgrGetNewConfig();
-        if(newConfig != 0U)
-        {
-            SetNewConfigMode(newConfig);
-        }
-
-    }
-
-}
-
-static Lap* GetPreviousBufferedResult(void)
-{
-	Lap* retVal = currentlyDisplayedLapFromBuffer;
-    if(retVal == &laps[0])
-    {
-        retVal = &laps[MAXLAPCOUNT - 1U];
-    }
-    else
-    {
-    	//Pointer math
-        retVal--;
-    }
-
-    return retVal;
-}
+//A started run is shown once the display is free.
+static uint8_t runStartPending = 0U;
 
 static void ResetBufferedDisplayed(void)
 {
@@ -71,7 +38,7 @@ static void UpdateDisplayWithBufferedLap(Lap* lapToDisplay)
     {
         if(lapToDisplay->endTimeStamp != 0U)
         {
-            if(GetSystemTimeStampMs() > (lastBufferDisplayChange + DISPLAYBUFFERINDEX))
+            if((GetSystemTimeStampMs() - lastBufferDisplayChange) > DISPLAYBUFFERINDEX)
             {
                 UpdateDisplay(GetLapDurationMs(lapToDisplay), LAPTIMERDISPLAYDURATION, DTEA_ClearDisplay);
             }
@@ -102,15 +69,10 @@ static Lap* HandleBufferedDisplayButtonRisingEdge(void)
     	retVal = GetCurrentLap();
     }
 
+    //The last finished lap, when no lap has run yet.
     if(retVal == (Lap*)0U)
     {
-		retVal = GetPreviousBufferedResult();
-		uint8_t step = 0U;
-		while((retVal->endTimeStamp == 0) && (step < MAXLAPCOUNT))
-		{
-			retVal = GetPreviousBufferedResult();
-			step++;
-		}
+		retVal = GetPreviousLap();
     }
 
     return retVal;
@@ -139,7 +101,7 @@ static void ManageDisplayButton(void)
         }
         else
         {
-            if((lastBufferDisplayChange + LAPTIMERDISPLAYDURATION) < GetSystemTimeStampMs())
+            if((GetSystemTimeStampMs() - lastBufferDisplayChange) > LAPTIMERDISPLAYDURATION)
             {
             	ResetBufferedDisplayed();
             }
@@ -151,46 +113,41 @@ static void ManageDisplayButton(void)
     UpdateDisplayWithBufferedLap(currentlyDisplayedLapFromBuffer);
 }
 
-static void RunLocalTimer(void)
+static void HandleLapFinished(Lap* finishedLap)
 {
-    RunStandAloneTimer();
-    if(lapFinished == 1U)
-    {
-        lapFinished = 0U;
-        uint32_t duration = 0U;
-        Lap* finishedLap = GetPreviousLap();
+    uint32_t duration = 0U;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wimplicit-fallthrough="
 //Fallthrough is intentional here.
-        switch (operationMode)
-        {
-        	case LaptimerOperation:
-        	{
-        		duration = LAPTIMERDISPLAYDURATION;
-        	}
-        	case SingleRunTimerOperation:
-			{
-				ResetBufferedDisplayed();
-				CommMgrSendTimeValue(LastLapTime, GetLapDurationMs(finishedLap));
-				UpdateDisplay(GetLapDurationMs(finishedLap), duration, DTEA_ShowRunningTime);
-				break;
-			}
-        	case MultiRunTimerOperation:
-        	{
-        		CommMgrSendTimeValue(LastLapTime, GetLapDurationMs(finishedLap));
-        		UpdateDisplayWithBufferedLap(finishedLap);
-        		break;
-        	}
-        	default:
-        	{
-        		break;
-        	}
+    switch (operationMode)
+    {
+    	case LaptimerOperation:
+    	{
+    		duration = LAPTIMERDISPLAYDURATION;
+    	}
+    	case SingleRunTimerOperation:
+		{
+			ResetBufferedDisplayed();
+			UpdateDisplay(GetLapDurationMs(finishedLap), duration, DTEA_ShowRunningTime);
+			break;
+		}
+    	case MultiRunTimerOperation:
+    	{
+    		UpdateDisplayWithBufferedLap(finishedLap);
+    		break;
+    	}
+    	default:
+    	{
+    		break;
+    	}
 
-        }
     }
-#pragma GCC diagnostic push
+#pragma GCC diagnostic pop
+}
 
-    if(newRunStarted == 1U)
+static void HandleRunStarted(void)
+{
+    if(runStartPending == 1U)
 	{
 
     	switch (operationMode)
@@ -198,7 +155,7 @@ static void RunLocalTimer(void)
 			case LaptimerOperation:
 			case SingleRunTimerOperation:
 			{
-				newRunStarted = 0U;
+				runStartPending = 0U;
 				ResetRunningDisplayTime(0U);
 				break;
 			}
@@ -206,7 +163,7 @@ static void RunLocalTimer(void)
 			{
 				if (currentlyDisplayedLapFromBuffer == (Lap*)0U)
 				{
-					newRunStarted = 0U;
+					runStartPending = 0U;
 					UpdateDisplay((GetLapIndex(GetLastStartedLap()) + 1U), DISPLAYBUFFERINDEX, DTEA_ClearDisplay);
 					ResetRunningDisplayTime(0U);
 				}
@@ -220,47 +177,91 @@ static void RunLocalTimer(void)
 		}
 
 	}
+}
 
+static void HandleEvents(void)
+{
+    BusEvent event;
 
+    while(EventBusGet(SubscriberRaceTiming, &event) == 1U)
+    {
+        switch(event.type)
+        {
+            case EventLapFinished:
+            {
+                HandleLapFinished(&laps[event.value]);
+                break;
+            }
+            case EventRunStarted:
+            {
+                runStartPending = 1U;
+                break;
+            }
+            case EventDisplayTime:
+            {
+                //Times from the central are only shown while it does the timing.
+                if(operationMode == ConnectedTimestampCollector)
+                {
+                    UpdateDisplay(event.value, LAPTIMERDISPLAYDURATION, DTEA_ClearDisplay);
+                }
+                break;
+            }
+            case EventNewConfig:
+            {
+                (void)SetNewConfigMode((uint8_t)event.value);
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+}
+
+static void RunLocalTimer(void)
+{
+    RunStandAloneTimer();
+    HandleEvents();
+    HandleRunStarted();
     ManageDisplayButton();
 }
 
 static void RunConnectedTimer(void)
 {
     RunConnectedTimestampCollector();
-
-    if(CommMgrHasNewDisplayUpdate() == 1U)
-    {
-        UpdateDisplay(CommMgrGetNewDisplayValue(), LAPTIMERDISPLAYDURATION, DTEA_ClearDisplay);
-    }
-
+    HandleEvents();
 }
 
+//Communication and display run as tasks of their own.
 void RunRaceTiming(void)
 {
-    switch(operationMode)
+    if(autoConfigurationDone == 0U)
     {
-        case SingleRunTimerOperation:
-        case LaptimerOperation:
-        case MultiRunTimerOperation:
-        {
-            RunLocalTimer();
-
-            break;
-        }
-        case ConnectedTimestampCollector:
-        {
-            RunConnectedTimer();
-            break;
-        }
-        default:
+        RunAutoConfiguration();
+    }
+    else
+    {
+        switch(operationMode)
         {
-            //Do nothing
-            break;
+            case SingleRunTimerOperation:
+            case LaptimerOperation:
+            case MultiRunTimerOperation:
+            {
+                RunLocalTimer();
+                break;
+            }
+            case ConnectedTimestampCollector:
+            {
+                RunConnectedTimer();
+                break;
+            }
+            default:
+            {
+                //A new configuration still has to get through.
+                HandleEvents();
+                break;
+            }
         }
     }
-
-    RunCommunication();
-
-    RunDisplay();
 }
@@ -0,0 +1,178 @@
+/*
+ * Scheduler.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "stm32f1xx.h"
+#include "Scheduler.h"
+#include "TimeMgmt.h"
+#include "Configuration.h"
+#include "Inputs.h"
+#include "EventJournal.h"
+#include "RaceTiming.h"
+#include "CommunicationManager.h"
+#include "Display.h"
+#include "Profiler.h"
+
+typedef struct
+{
+    void (*run)(void);
+    uint32_t period1us; //At least 1ms, SysTick is the only wakeup that is certain
+    uint32_t deadline1us; //Lateness allowed before a run counts as missed
+    uint8_t afterConfiguration; //Held back until the auto configuration is done
+    ProfilePoint profilePoint;
+} SchedulerTaskConfig;
+
+static const SchedulerTaskConfig tasks[NbOfSchedulerTasks] =
+{
+    {UpdateAllInputs, 10000U, 10000U, 0U, ProfileTaskInputs}, //Sampled for the debounce
+    {RunEventJournal, 100000U, 100000U, 0U, ProfileTaskEventJournal}, //Woken by the sensors
+    {RunStatusOutputs, 100000U, 100000U, 0U, ProfileTaskStatusOutputs}, //Woken by the PPS
+    {RunRaceTiming, 1000U, 2000U, 0U, ProfileTaskRaceTiming}, //Woken by the sensors
+    {RunCommunicationManager, 10000U, 10000U, 1U, ProfileTaskCommunication},
+    {RunDisplay, 1000U, 5000U, 1U, ProfileTaskDisplay} //Moves one SPI word per run
+};
+
+static Timestamp1us nextRun[NbOfSchedulerTasks] = {0U};
+static volatile uint32_t wakeRequests = 0U;
+static SchedulerTaskStats taskStats[NbOfSchedulerTasks] = {0};
+static Timestamp1us statsStart = 0U;
+static Timestamp1us idleTime = 0U;
+static Timestamp1us sleepStart = 0U;
+static uint8_t sleeping = 0U;
+
+static void RunTask(uint8_t task, Timestamp1us now, uint8_t due)
+{
+    SchedulerTaskStats* stats = &taskStats[task];
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t execution;
+
+    if(due == 1U)
+    {
+        Timestamp1us lateness = now - nextRun[task];
+        if(lateness > stats->maxLateness1us)
+        {
+            stats->maxLateness1us = (lateness > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)lateness;
+        }
+        if(lateness > tasks[task].deadline1us)
+        {
+            stats->deadlineMisses++;
+        }
+
+        //Runs that were missed altogether are skipped, the period stays in phase otherwise.
+        nextRun[task] += tasks[task].period1us;
+        if(nextRun[task] <= now)
+        {
+            nextRun[task] = now + tasks[task].period1us;
+        }
+    }
+
+    start = ProfilerGetCycles();
+    tasks[task].run();
+    cycles = ProfilerGetCycles() - start;
+    ProfilerRecord(tasks[task].profilePoint, cycles);
+    execution = cycles / PROFILERCYCLESPER1US;
+
+    stats->runCount++;
+    stats->totalExecution1us += execution;
+    if(execution > stats->maxExecution1us)
+    {
+        stats->maxExecution1us = execution;
+    }
+}
+
+void RunScheduler(void)
+{
+    PROFILER_START(passStart);
+    Timestamp1us now = GetSystemTime1us();
+    Timestamp1us nextDue = 0xFFFFFFFFFFFFFFFFU;
+    uint32_t wakeups = __atomic_exchange_n(&wakeRequests, 0U, __ATOMIC_ACQUIRE);
+    uint8_t task;
+
+    if(sleeping == 1U)
+    {
+        idleTime += now - sleepStart;
+        sleeping = 0U;
+    }
+
+    for(task = 0U; task < NbOfSchedulerTasks; task++)
+    {
+        if((tasks[task].afterConfiguration == 0U) || (autoConfigurationDone == 1U))
+        {
+            uint8_t due;
+            //The first run is due right away, the time before it does not count as lateness.
+            if(nextRun[task] == 0U)
+            {
+                nextRun[task] = now;
+            }
+            due = (now >= nextRun[task]) ? 1U : 0U;
+            if((due == 1U) || ((wakeups & (1U << task)) != 0U))
+            {
+                RunTask(task, now, due);
+            }
+            if(nextRun[task] < nextDue)
+            {
+                nextDue = nextRun[task];
+            }
+        }
+    }
+
+    PROFILER_END(ProfileSchedulerPass, passStart);
+    now = GetSystemTime1us();
+    if(now < nextDue)
+    {
+        //A wake request that comes in after this check still ends the sleep, WFI returns on any
+        //pending interrupt while they are masked. The handler runs once they are enabled again.
+        __disable_irq();
+        if(wakeRequests == 0U)
+        {
+            sleepStart = now;
+            sleeping = 1U;
+            __WFI();
+        }
+        __enable_irq();
+    }
+}
+
+void SchedulerWake(SchedulerTask task)
+{
+    (void)__atomic_fetch_or(&wakeRequests, (1U << task), __ATOMIC_RELEASE);
+}
+
+void SchedulerGetTaskStats(SchedulerTask task, SchedulerTaskStats* stats)
+{
+    (*stats) = taskStats[task];
+}
+
+uint8_t SchedulerGetIdlePercent(void)
+{
+    Timestamp1us elapsed = GetSystemTime1us() - statsStart;
+    uint8_t retVal = 0U;
+
+    if(elapsed > 0U)
+    {
+        retVal = (uint8_t)((idleTime * 100U) / elapsed);
+    }
+
+    return retVal;
+}
+
+uint32_t SchedulerGetStatsPeriod1ms(void)
+{
+    return (uint32_t)((GetSystemTime1us() - statsStart) / 1000U);
+}
+
+void SchedulerResetStats(void)
+{
+    uint8_t task;
+
+    for(task = 0U; task < NbOfSchedulerTasks; task++)
+    {
+        SchedulerTaskStats empty = {0};
+        taskStats[task] = empty;
+    }
+    statsStart = GetSystemTime1us();
+    idleTime = 0U;
+}
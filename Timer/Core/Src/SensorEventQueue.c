@@ -0,0 +1,105 @@
+/*
+ * SensorEventQueue.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "SensorEventQueue.h"
+#include "SensorTrace.h"
+
+#if (SENSOREVENTQUEUELENGTH & (SENSOREVENTQUEUELENGTH - 1U)) != 0U
+#error "SENSOREVENTQUEUELENGTH must be a power of two"
+#endif
+
+#define SENSOREVENTQUEUEMASK (SENSOREVENTQUEUELENGTH - 1U)
+
+static SensorEventQueue queues[NbOfSensorInputs] = {0};
+
+static SensorEventQueue* GetQueue(SensorInput input)
+{
+    SensorEventQueue* retVal = (SensorEventQueue*)0;
+    if(input < NbOfSensorInputs)
+    {
+        retVal = &queues[input];
+    }
+    return retVal;
+}
+
+uint8_t SensorEventQueuePush(SensorInput input, volatile SensorTimestamp* timeStamp)
+{
+    uint8_t retVal = 0U;
+    SensorEventQueue* queue = GetQueue(input);
+
+    if(queue != (SensorEventQueue*)0)
+    {
+        uint8_t head = queue->head;
+        uint8_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+        if((uint8_t)(head - tail) < SENSOREVENTQUEUELENGTH)
+        {
+            SensorTimestamp* event = &queue->events[head & SENSOREVENTQUEUEMASK];
+            event->time1us = timeStamp->time1us;
+            event->ppsTime1us = timeStamp->ppsTime1us;
+            event->timeStampPps = timeStamp->timeStampPps;
+            event->traceId = timeStamp->traceId;
+            //Publish the event only after its contents are written.
+            __atomic_store_n(&queue->head, (uint8_t)(head + 1U), __ATOMIC_RELEASE);
+            retVal = 1U;
+        }
+        else
+        {
+            queue->overflowCount++;
+        }
+    }
+
+    return retVal;
+}
+
+uint8_t SensorEventQueuePop(SensorInput input, SensorTimestamp* timeStamp)
+{
+    uint8_t retVal = 0U;
+    SensorEventQueue* queue = GetQueue(input);
+
+    if(queue != (SensorEventQueue*)0)
+    {
+        uint8_t tail = queue->tail;
+        uint8_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+        if(head != tail)
+        {
+            (*timeStamp) = queue->events[tail & SENSOREVENTQUEUEMASK];
+            //Hand the slot back only after it has been copied.
+            __atomic_store_n(&queue->tail, (uint8_t)(tail + 1U), __ATOMIC_RELEASE);
+            SensorTraceMark(timeStamp->traceId, TraceStageDequeued);
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+uint8_t SensorEventQueueGetCount(SensorInput input)
+{
+    uint8_t retVal = 0U;
+    SensorEventQueue* queue = GetQueue(input);
+
+    if(queue != (SensorEventQueue*)0)
+    {
+        retVal = (uint8_t)(__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) - queue->tail);
+    }
+
+    return retVal;
+}
+
+uint32_t SensorEventQueueGetOverflowCount(SensorInput input)
+{
+    uint32_t retVal = 0U;
+    SensorEventQueue* queue = GetQueue(input);
+
+    if(queue != (SensorEventQueue*)0)
+    {
+        retVal = __atomic_load_n(&queue->overflowCount, __ATOMIC_RELAXED);
+    }
+
+    return retVal;
+}
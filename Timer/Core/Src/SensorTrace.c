@@ -0,0 +1,160 @@
+/*
+ * SensorTrace.c
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "SensorTrace.h"
+#include "UARTBuffer.h"
+#include "MGBTPortConfig.h"
+
+#if (SENSORTRACELENGTH & (SENSORTRACELENGTH - 1U)) != 0U
+#error "SENSORTRACELENGTH must be a power of two"
+#endif
+
+#define SENSORTRACEMASK (SENSORTRACELENGTH - 1U)
+
+//Trace n is kept in traces[n & SENSORTRACEMASK] until trigger n + SENSORTRACELENGTH takes its place.
+//A trace is rewritten with ID 0, so readers can tell when it changed under them.
+static SensorTrace traces[SENSORTRACELENGTH] = {0};
+//Only written by the sensor handlers, they run at the same priority and never preempt each other.
+static uint32_t lastTraceId = 0U;
+
+static SensorTrace* GetTrace(uint32_t traceId)
+{
+    SensorTrace* retVal = (SensorTrace*)0;
+    SensorTrace* trace = &traces[traceId & SENSORTRACEMASK];
+
+    if((traceId != 0U) &&
+       (__atomic_load_n(&trace->traceId, __ATOMIC_SEQ_CST) == traceId))
+    {
+        retVal = trace;
+    }
+
+    return retVal;
+}
+
+//A stage keeps the time it was reached first.
+static void StampStage(SensorTrace* trace, SensorTraceStage stage, Timestamp1us now)
+{
+    if(__atomic_load_n(&trace->stageOffset1us[stage], __ATOMIC_SEQ_CST) == SENSORTRACENOTREACHED)
+    {
+        Timestamp1us offset1us = now - trace->captureTime1us;
+        if(offset1us >= SENSORTRACENOTREACHED)
+        {
+            offset1us = SENSORTRACENOTREACHED - 1U;
+        }
+        __atomic_store_n(&trace->stageOffset1us[stage], (uint32_t)offset1us, __ATOMIC_SEQ_CST);
+    }
+}
+
+//The frame end is written before the frame queued stage, which tells the interrupt it is valid.
+static void StampIfTransmitted(SensorTrace* trace, uint32_t bytesSent, Timestamp1us now)
+{
+    if((__atomic_load_n(&trace->traceId, __ATOMIC_SEQ_CST) != 0U) &&
+       (__atomic_load_n(&trace->stageOffset1us[TraceStageFrameQueued], __ATOMIC_SEQ_CST) != SENSORTRACENOTREACHED) &&
+       ((int32_t)(bytesSent - trace->frameEnd) >= 0))
+    {
+        StampStage(trace, TraceStageTransmitted, now);
+    }
+}
+
+uint32_t SensorTraceBegin(SensorInput sensor, SensorTimestamp* timeStamp, uint32_t entryLatency1us)
+{
+    uint32_t traceId = lastTraceId + 1U;
+    SensorTrace* trace = &traces[traceId & SENSORTRACEMASK];
+    uint8_t stage;
+
+    __atomic_store_n(&trace->traceId, 0U, __ATOMIC_SEQ_CST);
+    trace->captureTime1us = timeStamp->time1us;
+    trace->ppsTime1us = GetPpsTimestamp1us(timeStamp);
+    trace->frameEnd = 0U;
+    trace->sensor = (uint8_t)sensor;
+    trace->stageOffset1us[TraceStageHandler] = entryLatency1us;
+    for(stage = TraceStageDequeued; stage < NbOfTraceStages; stage++)
+    {
+        trace->stageOffset1us[stage] = SENSORTRACENOTREACHED;
+    }
+    __atomic_store_n(&trace->traceId, traceId, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&lastTraceId, traceId, __ATOMIC_SEQ_CST);
+
+    return traceId;
+}
+
+void SensorTraceMark(uint32_t traceId, SensorTraceStage stage)
+{
+    SensorTrace* trace = GetTrace(traceId);
+
+    if((trace != (SensorTrace*)0) &&
+       (stage < NbOfTraceStages))
+    {
+        StampStage(trace, stage, GetSystemTime1us());
+    }
+}
+
+//A transfer that already ended before the frame got marked is caught here instead of in the interrupt.
+void SensorTraceFrameQueued(uint32_t traceId)
+{
+    SensorTrace* trace = GetTrace(traceId);
+
+    if((trace != (SensorTrace*)0) &&
+       (trace->stageOffset1us[TraceStageFrameQueued] == SENSORTRACENOTREACHED))
+    {
+        UARTBuffer* uart = UARTBufferGetUART(MGBT_UART);
+        Timestamp1us now = GetSystemTime1us();
+
+        trace->frameEnd = UARTBufferGetTxBytesQueued(uart);
+        StampStage(trace, TraceStageFrameQueued, now);
+        StampIfTransmitted(trace, UARTBufferGetTxBytesSent(uart), now);
+    }
+}
+
+//The DMA controller is done one character time before the last stop bit leaves the USART.
+void SensorTraceTransmitComplete(uint8_t uartId)
+{
+    if(uartId == MGBT_UART)
+    {
+        uint32_t bytesSent = UARTBufferGetTxBytesSent(UARTBufferGetUART(uartId));
+        Timestamp1us now = GetSystemTime1us();
+        uint8_t index;
+
+        for(index = 0U; index < SENSORTRACELENGTH; index++)
+        {
+            StampIfTransmitted(&traces[index], bytesSent, now);
+        }
+    }
+}
+
+uint32_t SensorTraceGetLastId(void)
+{
+    return __atomic_load_n(&lastTraceId, __ATOMIC_SEQ_CST);
+}
+
+uint8_t SensorTraceGet(uint32_t traceId, SensorTrace* trace)
+{
+    uint8_t retVal = 0U;
+    SensorTrace* source = GetTrace(traceId);
+
+    if(source != (SensorTrace*)0)
+    {
+        (*trace) = (*source);
+        //A sensor handler may have started to reuse it during the copy.
+        if((trace->traceId == traceId) &&
+           (GetTrace(traceId) == source))
+        {
+            retVal = 1U;
+        }
+    }
+
+    if(retVal == 0U)
+    {
+        uint8_t stage;
+        trace->traceId = 0U;
+        for(stage = 0U; stage < NbOfTraceStages; stage++)
+        {
+            trace->stageOffset1us[stage] = SENSORTRACENOTREACHED;
+        }
+    }
+
+    return retVal;
+}
@@ -5,47 +5,242 @@
  *      Author: r.boonstra
  */
 #include "TimeMgmt.h"
-#include "stm32f1xx_ll_exti.h"
-#include <string.h>
+#include "SensorEventQueue.h"
+#include "EventJournal.h"
+#include "EventBus.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "SensorTrace.h"
+#include "stm32f1xx_ll_tim.h"
 
-volatile SensorTimestamp systemTime;
-volatile SensorTimestamp sensorStartStopTimeStamp;
-volatile SensorTimestamp sensorStopTimeStamp;
+typedef struct
+{
+    uint32_t timerPeriods; //Overflows of the free-running TIM2 counter, wraps after 6.8 years
+    uint32_t timeStampPps;
+    Timestamp1us ppsTime1us; //When the last PPS edge arrived
+} SystemTime;
+
+//Written by the TIM2 overflow and PPS interrupts only. Readers go through ReadSystemTime,
+//which retries until it has seen the same even sequence number before and after the copy.
+static volatile SystemTime systemTime;
+static volatile uint32_t systemTimeSequence = 0U;
+//PPS edges that have been published on the event bus.
+static uint32_t publishedPpsCount = 0U;
 
-volatile uint8_t sensorStartStopInterrupt = 0U;
-volatile uint8_t sensorStopInterrupt = 0U;
-volatile uint8_t ppsTick = 0U;
+//Last accepted trigger per input, only used by the interrupt handlers to suppress bouncing sensors.
+static volatile SensorTimestamp sensorStartStopTimeStamp;
+static volatile SensorTimestamp sensorStopTimeStamp;
 
-uint32_t GetMillisecondsFromTimeStampPPS(SensorTimestamp* timeStamp)
+//Microseconds since the first PPS edge, counting whole PPS pulses plus the time since the last one.
+Timestamp1us GetPpsTimestamp1us(SensorTimestamp* timeStamp)
 {
-    return ((timeStamp->timeStampPps * 10000U) + timeStamp->ppsOffset100us);
+    return (((Timestamp1us)timeStamp->timeStampPps * 1000000U) + (timeStamp->time1us - timeStamp->ppsTime1us));
 }
 
-uint32_t GetMillisecondsFromTimeStamp(SensorTimestamp* timeStamp)
+//Copies the time state together with the TIM2 counter value that belongs to it.
+static void ReadSystemTime(SystemTime* time, uint32_t* counter1us)
 {
-    return (timeStamp->timeStamp100us / 10U);
+    uint32_t sequenceStart;
+    uint32_t sequenceEnd;
+    uint32_t updatePending;
+
+    do
+    {
+        sequenceStart = __atomic_load_n(&systemTimeSequence, __ATOMIC_ACQUIRE);
+        time->timerPeriods = systemTime.timerPeriods;
+        time->timeStampPps = systemTime.timeStampPps;
+        time->ppsTime1us = systemTime.ppsTime1us;
+        (*counter1us) = LL_TIM_GetCounter(TIM2);
+        //The counter may have wrapped just before the overflow interrupt got to run.
+        updatePending = LL_TIM_IsActiveFlag_UPDATE(TIM2);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        sequenceEnd = __atomic_load_n(&systemTimeSequence, __ATOMIC_RELAXED);
+    } while(((sequenceStart & 1U) != 0U) || (sequenceStart != sequenceEnd) || (updatePending != 0U));
 }
 
+static Timestamp1us GetTime1us(uint32_t timerPeriods, uint32_t counter1us)
+{
+    return (((Timestamp1us)timerPeriods * TIMERPERIOD1US) + counter1us);
+}
+
+Timestamp1us GetSystemTime1us(void)
+{
+    SystemTime time;
+    uint32_t counter1us;
+
+    ReadSystemTime(&time, &counter1us);
+
+    return GetTime1us(time.timerPeriods, counter1us);
+}
+
+//The timer period is a whole number of milliseconds, so this wraps cleanly at 2^32
+//without a 64 bit division.
 uint32_t GetSystemTimeStampMs(void)
 {
-    return systemTime.timeStamp100us / 10U;
+    SystemTime time;
+    uint32_t counter1us;
+
+    ReadSystemTime(&time, &counter1us);
+
+    return (time.timerPeriods * (TIMERPERIOD1US / 1000U)) + (counter1us / 1000U);
+}
+
+uint32_t GetSystemTimeStamp100us(void)
+{
+    SystemTime time;
+    uint32_t counter1us;
+
+    ReadSystemTime(&time, &counter1us);
+
+    return (time.timerPeriods * (TIMERPERIOD1US / 100U)) + (counter1us / 100U);
 }
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdiscarded-qualifiers"
-//We know an willingly ignore the volatile qualifier, as we temporarily
-//disable interrupts that might cause the change that justifies the volatile
-//keyword.
-void GetStartStopSensorTimeStamp(SensorTimestamp* copy)
+
+void GetSystemTimeSnapshot(SensorTimestamp* snapshot)
 {
-    LL_EXTI_DisableRisingTrig_0_31(LL_EXTI_LINE_8);
-    memcpy(copy, &sensorStartStopTimeStamp, sizeof(SensorTimestamp));
-    LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_8);
+    SystemTime time;
+    uint32_t counter1us;
+
+    ReadSystemTime(&time, &counter1us);
+    snapshot->time1us = GetTime1us(time.timerPeriods, counter1us);
+    snapshot->ppsTime1us = time.ppsTime1us;
+    snapshot->timeStampPps = time.timeStampPps;
+    snapshot->traceId = 0U;
+}
+
+//Combines a captured counter value with the current time. A capture larger than the counter
+//was latched before the overflow that has been counted since. Without a capture the counter
+//value at handler entry is used.
+static void GetCapturedTimeStamp(uint32_t captureValid, uint32_t capture1us, SensorTimestamp* timeStamp)
+{
+    SystemTime time;
+    uint32_t counter1us;
+    uint32_t timerPeriods;
+
+    ReadSystemTime(&time, &counter1us);
+    timerPeriods = time.timerPeriods;
+
+    if(captureValid != 0U)
+    {
+        if(capture1us > counter1us)
+        {
+            timerPeriods--;
+        }
+        counter1us = capture1us;
+    }
+
+    timeStamp->time1us = GetTime1us(timerPeriods, counter1us);
+    timeStamp->ppsTime1us = time.ppsTime1us;
+    timeStamp->timeStampPps = time.timeStampPps;
+    timeStamp->traceId = 0U;
 }
 
-void GetStopSensorTimeStamp(SensorTimestamp* copy)
+//Returns how long after the captured edge the handler started, 0 without a capture, and records it
+//in cycles. The counter may have wrapped since.
+static uint32_t RecordEntryLatency(uint32_t captureValid, uint32_t capture1us, uint32_t entry1us)
 {
-    LL_EXTI_DisableRisingTrig_0_31(LL_EXTI_LINE_11);
-    memcpy(copy, &sensorStopTimeStamp, sizeof(SensorTimestamp));
-    LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_11);
+    uint32_t latency1us = 0U;
+    if(captureValid != 0U)
+    {
+        latency1us = (entry1us >= capture1us) ? (entry1us - capture1us) : ((entry1us + TIMERPERIOD1US) - capture1us);
+        ProfilerRecord(ProfileSensorEntryLatency, latency1us * PROFILERCYCLESPER1US);
+    }
+    return latency1us;
+}
+
+//The PPS interrupt can be preempted by TIM2, so updates may nest. The nested update
+//completes before the outer one resumes and readers never run in between.
+static void BeginSystemTimeUpdate(void)
+{
+    __atomic_store_n(&systemTimeSequence, systemTimeSequence + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void EndSystemTimeUpdate(void)
+{
+    __atomic_store_n(&systemTimeSequence, systemTimeSequence + 1U, __ATOMIC_RELEASE);
+}
+
+void RunTimeMgmt(void)
+{
+    SensorTimestamp now;
+    GetSystemTimeSnapshot(&now);
+
+    while(publishedPpsCount != now.timeStampPps)
+    {
+        publishedPpsCount++;
+        EventBusPublish(EventPpsTick, publishedPpsCount);
+    }
+}
+
+void HandleTimerOverflow(void)
+{
+    PROFILER_START(start);
+    BeginSystemTimeUpdate();
+    systemTime.timerPeriods++;
+    EndSystemTimeUpdate();
+    PROFILER_END(ProfileTimerOverflow, start);
+}
+
+//The PPS edge is stored as an absolute time rather than by resetting an offset,
+//so an overflow that preempts this handler is never lost.
+void HandlePpsPulse(void)
+{
+    PROFILER_START(start);
+    SensorTimestamp now;
+    uint32_t captureValid = LL_TIM_IsActiveFlag_CC2(TIM2);
+    uint32_t capture1us = LL_TIM_IC_GetCaptureCH2(TIM2);
+    GetCapturedTimeStamp(captureValid, capture1us, &now);
+
+    BeginSystemTimeUpdate();
+    systemTime.timeStampPps++;
+    systemTime.ppsTime1us = now.time1us;
+    EndSystemTimeUpdate();
+    SchedulerWake(TaskStatusOutputs);
+    PROFILER_END(ProfilePpsPulse, start);
+}
+
+void HandleStartStopSensorTrigger(void)
+{
+    PROFILER_START(start);
+    uint32_t entry1us = LL_TIM_GetCounter(TIM1);
+    SensorTimestamp now;
+    //Always read the capture, a bouncing edge must not leave a stale value behind.
+    uint32_t captureValid = LL_TIM_IsActiveFlag_CC1(TIM1);
+    uint32_t capture1us = LL_TIM_IC_GetCaptureCH1(TIM1);
+    GetCapturedTimeStamp(captureValid, capture1us, &now);
+    uint32_t latency1us = RecordEntryLatency(captureValid, capture1us, entry1us);
+
+    if((sensorStartStopTimeStamp.time1us + MIN_SENSOR_INTERRUPT_WAIT) <= now.time1us)
+    {
+        now.traceId = SensorTraceBegin(SensorInputStartStop, &now, latency1us);
+        sensorStartStopTimeStamp = now;
+        SensorEventQueuePush(SensorInputStartStop, &sensorStartStopTimeStamp);
+        EventJournalRecord(SensorInputStartStop, &now);
+        SchedulerWake(TaskRaceTiming);
+        SchedulerWake(TaskEventJournal);
+    }
+    PROFILER_END(ProfileStartStopSensor, start);
+}
+
+void HandleStopSensorTrigger(void)
+{
+    PROFILER_START(start);
+    uint32_t entry1us = LL_TIM_GetCounter(TIM2);
+    SensorTimestamp now;
+    //Always read the capture, a bouncing edge must not leave a stale value behind.
+    uint32_t captureValid = LL_TIM_IsActiveFlag_CC4(TIM2);
+    uint32_t capture1us = LL_TIM_IC_GetCaptureCH4(TIM2);
+    GetCapturedTimeStamp(captureValid, capture1us, &now);
+    uint32_t latency1us = RecordEntryLatency(captureValid, capture1us, entry1us);
+
+    if((sensorStopTimeStamp.time1us + MIN_SENSOR_INTERRUPT_WAIT) <= now.time1us)
+    {
+        now.traceId = SensorTraceBegin(SensorInputStop, &now, latency1us);
+        sensorStopTimeStamp = now;
+        SensorEventQueuePush(SensorInputStop, &sensorStopTimeStamp);
+        EventJournalRecord(SensorInputStop, &now);
+        SchedulerWake(TaskRaceTiming);
+        SchedulerWake(TaskEventJournal);
+    }
+    PROFILER_END(ProfileStopSensor, start);
 }
-#pragma GCC diagnostic pop
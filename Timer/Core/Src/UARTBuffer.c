@@ -9,6 +9,8 @@
 
 #include "UARTBuffer.h"
 #include "stm32f1xx.h"
+#include "stm32f1xx_ll_dma.h"
+#include "stm32f1xx_ll_rcc.h"
 #include "stm32f1xx_ll_usart.h"
 
 #define NO_OF_UART 2
@@ -25,33 +27,84 @@ UARTBuffer* UARTBufferGetUART(uint8_t index)
     return buff;
 }
 
-void UARTBufferProcessReceivedByte(UARTBuffer* buffer, uint8_t byte)
+//Reception runs in circular DMA mode straight into rxBuffer, so received bytes cost no CPU time.
+//The idle-line interrupt and the DMA half and full transfer interrupts publish the write position.
+void UARTBufferStartReception(UARTBuffer* buffer, uint32_t dmaChannel)
 {
     if(buffer != (UARTBuffer*)0)
     {
-        buffer->rxBuffer[buffer->currentRxBufferPosition] = byte;
-        buffer->currentRxBufferPosition++;
-        if(buffer->currentRxBufferPosition >= UART_BUFFER_SIZE)
-        {
-            buffer->currentRxBufferPosition = 0U;
-        }
+        buffer->rxDmaChannel = dmaChannel;
+        buffer->currentRxBufferPosition = 0U;
+        buffer->rxBufferStartPosition = 0U;
+        buffer->rxBytesReceived = 0U;
+        buffer->rxBytesConsumed = 0U;
+
+        LL_DMA_ConfigTransfer(DMA1, dmaChannel,
+                              LL_DMA_DIRECTION_PERIPH_TO_MEMORY |
+                              LL_DMA_MODE_CIRCULAR |
+                              LL_DMA_PERIPH_NOINCREMENT |
+                              LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_BYTE |
+                              LL_DMA_MDATAALIGN_BYTE |
+                              LL_DMA_PRIORITY_MEDIUM);
+        LL_DMA_ConfigAddresses(DMA1, dmaChannel,
+                               LL_USART_DMA_GetRegAddr(buffer->uartHandle),
+                               (uintptr_t)buffer->rxBuffer,
+                               LL_DMA_DIRECTION_PERIPH_TO_MEMORY);
+        LL_DMA_SetDataLength(DMA1, dmaChannel, UART_BUFFER_SIZE);
+        LL_DMA_EnableIT_HT(DMA1, dmaChannel);
+        LL_DMA_EnableIT_TC(DMA1, dmaChannel);
+        LL_DMA_EnableChannel(DMA1, dmaChannel);
+
+        LL_USART_EnableDMAReq_RX(buffer->uartHandle);
+        LL_USART_EnableIT_IDLE(buffer->uartHandle);
     }
 }
 
-uint8_t UARTBufferHasNewData(UARTBuffer* buffer)
+static uint16_t GetRxDmaPosition(UARTBuffer* buffer)
+{
+    uint16_t position = (uint16_t)(UART_BUFFER_SIZE - LL_DMA_GetDataLength(DMA1, buffer->rxDmaChannel));
+    if(position >= UART_BUFFER_SIZE)
+    {
+        position = 0U;
+    }
+    return position;
+}
+
+//Called from the USART idle-line interrupt and the DMA half/full transfer interrupts. They all run
+//at the same priority and the half and full transfer points are never a whole ring apart.
+void UARTBufferProcessReceivedData(UARTBuffer* buffer)
 {
-    uint8_t retVal = 0U;
     if(buffer != (UARTBuffer*)0)
     {
-        if(buffer->rxBufferStartPosition != buffer->currentRxBufferPosition)
+        uint16_t position = GetRxDmaPosition(buffer);
+        uint16_t newBytes = (uint16_t)((position + UART_BUFFER_SIZE - buffer->currentRxBufferPosition) % UART_BUFFER_SIZE);
+        __atomic_store_n(&buffer->rxBytesReceived, buffer->rxBytesReceived + newBytes, __ATOMIC_RELEASE);
+        //Release: the bytes the DMA controller wrote before this position are visible to the reader.
+        __atomic_store_n(&buffer->currentRxBufferPosition, position, __ATOMIC_RELEASE);
+    }
+}
+
+static uint16_t GetRxWritePosition(UARTBuffer* buffer)
+{
+    return __atomic_load_n(&buffer->currentRxBufferPosition, __ATOMIC_ACQUIRE);
+}
+
+uint16_t UARTBufferHasNewData(UARTBuffer* buffer)
+{
+    uint16_t retVal = 0U;
+    if(buffer != (UARTBuffer*)0)
+    {
+        uint16_t writePosition = GetRxWritePosition(buffer);
+        if(buffer->rxBufferStartPosition != writePosition)
         {
-            if(buffer->rxBufferStartPosition < buffer->currentRxBufferPosition)
+            if(buffer->rxBufferStartPosition < writePosition)
             {
-                retVal = buffer->currentRxBufferPosition - buffer->rxBufferStartPosition;
+                retVal = writePosition - buffer->rxBufferStartPosition;
             }
             else
             {
-                retVal = (UART_BUFFER_SIZE - buffer->rxBufferStartPosition) + buffer->currentRxBufferPosition;
+                retVal = (UART_BUFFER_SIZE - buffer->rxBufferStartPosition) + writePosition;
             }
         }
     }
@@ -59,87 +112,199 @@ uint8_t UARTBufferHasNewData(UARTBuffer* buffer)
     return retVal;
 }
 
+//The DMA controller does not know where the reader is. Returns 1 once it has written, or is about to
+//write, over bytes that have not been consumed; the ring then has to be cleared. The bytes it wrote
+//since the last interrupt are counted from its live position.
+uint8_t UARTBufferRxOverrun(UARTBuffer* buffer)
+{
+    uint8_t retVal = 0U;
+    if(buffer != (UARTBuffer*)0)
+    {
+        uint32_t received = __atomic_load_n(&buffer->rxBytesReceived, __ATOMIC_ACQUIRE);
+        uint16_t position = GetRxDmaPosition(buffer);
+        received += (uint16_t)((position + UART_BUFFER_SIZE - (received % UART_BUFFER_SIZE)) % UART_BUFFER_SIZE);
+        if((received - buffer->rxBytesConsumed) > (UART_BUFFER_SIZE - UART_RX_GUARD))
+        {
+            retVal = 1U;
+        }
+    }
+
+    return retVal;
+}
+
+//Only the main loop moves the read position, so no interrupts need to be masked while copying.
 void UARTBufferGetData(UARTBuffer* buffer, uint8_t* dstBuffer, uint8_t length)
 {
     if(buffer != (UARTBuffer*)0)
     {
-        uint8_t index;
-        LL_USART_DisableIT_RXNE(buffer->uartHandle);
-        uint8_t availableDataLength = UARTBufferHasNewData(buffer);
-        uint8_t returnedDataLength = availableDataLength;
+        uint16_t returnedDataLength = UARTBufferHasNewData(buffer);
+        uint16_t firstPartLength;
         if(returnedDataLength > length)
         {
             returnedDataLength = length;
         }
 
-        for(index = 0U; index < returnedDataLength; index++)
+        firstPartLength = UART_BUFFER_SIZE - buffer->rxBufferStartPosition;
+        if(firstPartLength > returnedDataLength)
         {
-            if((buffer->rxBufferStartPosition + index) >= UART_BUFFER_SIZE)
-            {
-                dstBuffer[index] = buffer->rxBuffer[((buffer->rxBufferStartPosition + index) - UART_BUFFER_SIZE)];
-            }
-            else
-            {
-                dstBuffer[index] = buffer->rxBuffer[buffer->rxBufferStartPosition + index];
-            }
+            firstPartLength = returnedDataLength;
         }
+        memcpy(dstBuffer, &buffer->rxBuffer[buffer->rxBufferStartPosition], firstPartLength);
+        memcpy(&dstBuffer[firstPartLength], buffer->rxBuffer, returnedDataLength - firstPartLength);
 
-
-        if(returnedDataLength == availableDataLength)
+        buffer->rxBytesConsumed += returnedDataLength;
+        buffer->rxBufferStartPosition += returnedDataLength;
+        if(buffer->rxBufferStartPosition >= UART_BUFFER_SIZE)
         {
-            buffer->rxBufferStartPosition = buffer->currentRxBufferPosition;
+            buffer->rxBufferStartPosition -= UART_BUFFER_SIZE;
         }
-        else
+    }
+}
+
+//Points data at the received bytes starting offset bytes after the read position, without
+//consuming them. Returns how many of those bytes are contiguous in the ring, 0 when there are none.
+uint16_t UARTBufferPeekData(UARTBuffer* buffer, uint16_t offset, const uint8_t** data)
+{
+    uint16_t retVal = 0U;
+    if((buffer != (UARTBuffer*)0) && (data != (const uint8_t**)0))
+    {
+        uint16_t available = UARTBufferHasNewData(buffer);
+        if(offset < available)
         {
-            buffer->rxBufferStartPosition += returnedDataLength;
-            if(buffer->rxBufferStartPosition >= UART_BUFFER_SIZE)
+            uint16_t position = (uint16_t)((buffer->rxBufferStartPosition + offset) % UART_BUFFER_SIZE);
+            retVal = available - offset;
+            if(retVal > (UART_BUFFER_SIZE - position))
             {
-                buffer->rxBufferStartPosition -= UART_BUFFER_SIZE;
+                retVal = UART_BUFFER_SIZE - position;
             }
+            (*data) = &buffer->rxBuffer[position];
         }
+    }
 
-        LL_USART_EnableIT_RXNE(buffer->uartHandle);
+    return retVal;
+}
+
+//Overwrites received bytes that have not been consumed yet, starting offset bytes after the read
+//position, so received data can be decoded in place. The DMA controller only writes past these bytes.
+void UARTBufferWriteRxData(UARTBuffer* buffer, uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    if((buffer != (UARTBuffer*)0) &&
+       (data != (const uint8_t*)0))
+    {
+        uint16_t writePosition = (uint16_t)((buffer->rxBufferStartPosition + offset) % UART_BUFFER_SIZE);
+        uint16_t firstPartLength = UART_BUFFER_SIZE - writePosition;
+        if(firstPartLength > length)
+        {
+            firstPartLength = length;
+        }
+        memmove(&buffer->rxBuffer[writePosition], data, firstPartLength);
+        memmove(buffer->rxBuffer, &data[firstPartLength], length - firstPartLength);
     }
 }
 
+//The write position always is the received count modulo the ring size.
 void UARTBufferClear(UARTBuffer* buffer)
 {
     if(buffer != (UARTBuffer*)0)
     {
-        buffer->rxBufferStartPosition = buffer->currentRxBufferPosition;
+        buffer->rxBytesConsumed = __atomic_load_n(&buffer->rxBytesReceived, __ATOMIC_ACQUIRE);
+        buffer->rxBufferStartPosition = (uint16_t)(buffer->rxBytesConsumed % UART_BUFFER_SIZE);
     }
 }
 
-void UARTBufferProcessTXData(UARTBuffer* buffer)
+//Consumes length bytes from the read position, for data that was read in place with UARTBufferPeekData.
+void UARTBufferSkipData(UARTBuffer* buffer, uint16_t length)
 {
     if(buffer != (UARTBuffer*)0)
     {
-        if(LL_USART_IsActiveFlag_TXE(buffer->uartHandle))
+        uint16_t available = UARTBufferHasNewData(buffer);
+        if(length > available)
         {
-            if(buffer->txBufferTxPosition != buffer->currentTxBufferPosition)
-            {
-                LL_USART_TransmitData8(buffer->uartHandle, buffer->txBuffer[buffer->txBufferTxPosition]);
-                buffer->txBufferTxPosition++;
-                if(buffer->txBufferTxPosition >= sizeof(buffer->txBuffer))
-                {
-                    buffer->txBufferTxPosition = 0U;
-                }
-            }
-            else
-            {
-                buffer->currentTxBufferPosition = 0U;
-                buffer->txBufferTxPosition = 0U;
-            }
+            length = available;
         }
+        buffer->rxBytesConsumed += length;
+        buffer->rxBufferStartPosition = (uint16_t)((buffer->rxBufferStartPosition + length) % UART_BUFFER_SIZE);
+    }
+}
+
+void UARTBufferStartTransmission(UARTBuffer* buffer, uint32_t dmaChannel)
+{
+    if(buffer != (UARTBuffer*)0)
+    {
+        buffer->txDmaChannel = dmaChannel;
+        buffer->currentTxBufferPosition = 0U;
+        buffer->txBufferTxPosition = 0U;
+        buffer->txDmaBusy = 0U;
+
+        LL_DMA_ConfigTransfer(DMA1, dmaChannel,
+                              LL_DMA_DIRECTION_MEMORY_TO_PERIPH |
+                              LL_DMA_MODE_NORMAL |
+                              LL_DMA_PERIPH_NOINCREMENT |
+                              LL_DMA_MEMORY_INCREMENT |
+                              LL_DMA_PDATAALIGN_BYTE |
+                              LL_DMA_MDATAALIGN_BYTE |
+                              LL_DMA_PRIORITY_MEDIUM);
+        LL_DMA_SetPeriphAddress(DMA1, dmaChannel, LL_USART_DMA_GetRegAddr(buffer->uartHandle));
+        LL_DMA_EnableIT_TC(DMA1, dmaChannel);
+
+        LL_USART_EnableDMAReq_TX(buffer->uartHandle);
     }
 }
 
-void UARTBufferRunTxWork(void)
+static uint16_t GetTxUsedSpace(UARTBuffer* buffer)
 {
-    uint8_t index;
-    for(index = 0U; index < NO_OF_UART; index++)
+    uint16_t writePosition = __atomic_load_n(&buffer->currentTxBufferPosition, __ATOMIC_SEQ_CST);
+    uint16_t readPosition = __atomic_load_n(&buffer->txBufferTxPosition, __ATOMIC_SEQ_CST);
+
+    return (uint16_t)((writePosition + UART_BUFFER_SIZE - readPosition) % UART_BUFFER_SIZE);
+}
+
+//Hands the queued data from txBufferTxPosition up to the write position or the end of the ring,
+//whichever comes first, to the DMA controller.
+//Runs in the main loop while no transfer is busy, or in the completion interrupt.
+static void StartTxTransfer(UARTBuffer* buffer)
+{
+    uint16_t writePosition = __atomic_load_n(&buffer->currentTxBufferPosition, __ATOMIC_SEQ_CST);
+    uint16_t length;
+
+    if(writePosition > buffer->txBufferTxPosition)
     {
-        UARTBufferProcessTXData(&uarts[index]);
+        length = writePosition - buffer->txBufferTxPosition;
+    }
+    else
+    {
+        length = UART_BUFFER_SIZE - buffer->txBufferTxPosition;
+    }
+
+    buffer->txDmaLength = length;
+    LL_DMA_DisableChannel(DMA1, buffer->txDmaChannel);
+    LL_DMA_SetMemoryAddress(DMA1, buffer->txDmaChannel, (uintptr_t)&buffer->txBuffer[buffer->txBufferTxPosition]);
+    LL_DMA_SetDataLength(DMA1, buffer->txDmaChannel, length);
+    __atomic_store_n(&buffer->txDmaBusy, 1U, __ATOMIC_SEQ_CST);
+    //The DMA writes to DR do not clear TC, left set it would report the last bytes as sent.
+    LL_USART_ClearFlag_TC(buffer->uartHandle);
+    LL_DMA_EnableChannel(DMA1, buffer->txDmaChannel);
+}
+
+//Called from the DMA transfer complete interrupt. Data queued while the transfer ran goes out
+//straight away, so throughput only depends on the baud rate.
+void UARTBufferProcessTransmitComplete(UARTBuffer* buffer)
+{
+    if(buffer != (UARTBuffer*)0)
+    {
+        uint16_t readPosition = (uint16_t)((buffer->txBufferTxPosition + buffer->txDmaLength) % UART_BUFFER_SIZE);
+        __atomic_store_n(&buffer->txBufferTxPosition, readPosition, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&buffer->txBytesSent, buffer->txBytesSent + buffer->txDmaLength, __ATOMIC_SEQ_CST);
+        buffer->txDmaLength = 0U;
+        if(__atomic_load_n(&buffer->currentTxBufferPosition, __ATOMIC_SEQ_CST) != readPosition)
+        {
+            StartTxTransfer(buffer);
+        }
+        else
+        {
+            LL_DMA_DisableChannel(DMA1, buffer->txDmaChannel);
+            __atomic_store_n(&buffer->txDmaBusy, 0U, __ATOMIC_SEQ_CST);
+        }
     }
 }
 
@@ -148,7 +313,8 @@ uint8_t UARTBufferTxBufferEmpty(UARTBuffer* buffer)
     uint8_t retVal = 0U;
     if(buffer != (UARTBuffer*)0)
     {
-        if(buffer->currentTxBufferPosition == buffer->txBufferTxPosition)
+        if((__atomic_load_n(&buffer->txDmaBusy, __ATOMIC_SEQ_CST) == 0U) &&
+           (GetTxUsedSpace(buffer) == 0U))
         {
             retVal = 1U;
         }
@@ -157,18 +323,143 @@ uint8_t UARTBufferTxBufferEmpty(UARTBuffer* buffer)
     return retVal;
 }
 
-void UARTBufferSendData(UARTBuffer* buffer, uint8_t* data, uint8_t length)
+//The ring and the DMA transfer can be done while the USART still shifts out the last byte.
+uint8_t UARTBufferTxComplete(UARTBuffer* buffer)
+{
+    uint8_t retVal = 0U;
+    if((UARTBufferTxBufferEmpty(buffer) == 1U) &&
+       (LL_USART_IsActiveFlag_TC(buffer->uartHandle) == 1U))
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+//USART1 runs from APB2, USART2 from APB1. Bytes still going out or coming in are garbled,
+//callers wait for UARTBufferTxComplete first.
+void UARTBufferSetBaudRate(UARTBuffer* buffer, uint32_t baudRate)
 {
     if((buffer != (UARTBuffer*)0) &&
-       (data != (uint8_t*)0) &&
-       length > 0)
+       (baudRate > 0U))
+    {
+        LL_RCC_ClocksTypeDef clocks;
+        uint32_t periphClk;
+
+        LL_RCC_GetSystemClocksFreq(&clocks);
+        periphClk = clocks.PCLK1_Frequency;
+        if(buffer->uartHandle == USART1)
+        {
+            periphClk = clocks.PCLK2_Frequency;
+        }
+        LL_USART_Disable(buffer->uartHandle);
+        LL_USART_SetBaudRate(buffer->uartHandle, periphClk, baudRate);
+        LL_USART_Enable(buffer->uartHandle);
+    }
+}
+
+//One slot stays unused to tell a full ring from an empty one.
+uint16_t UARTBufferGetTxFreeSpace(UARTBuffer* buffer)
+{
+    uint16_t retVal = 0U;
+    if(buffer != (UARTBuffer*)0)
+    {
+        retVal = (UART_BUFFER_SIZE - 1U) - GetTxUsedSpace(buffer);
+    }
+
+    return retVal;
+}
+
+//Writes data offset bytes past the write position without publishing it, so a frame can be
+//assembled in place. The caller makes sure the ring has room for it.
+void UARTBufferWriteTxData(UARTBuffer* buffer, uint16_t offset, const uint8_t* data, uint16_t length)
+{
+    if((buffer != (UARTBuffer*)0) &&
+       (data != (const uint8_t*)0))
+    {
+        uint16_t writePosition = (uint16_t)((buffer->currentTxBufferPosition + offset) % UART_BUFFER_SIZE);
+        uint16_t firstPartLength = UART_BUFFER_SIZE - writePosition;
+        if(firstPartLength > length)
+        {
+            firstPartLength = length;
+        }
+        memcpy(&buffer->txBuffer[writePosition], data, firstPartLength);
+        memcpy(buffer->txBuffer, &data[firstPartLength], length - firstPartLength);
+    }
+}
+
+//Reads back data written with UARTBufferWriteTxData that has not been committed yet.
+void UARTBufferReadTxData(UARTBuffer* buffer, uint16_t offset, uint8_t* dst, uint16_t length)
+{
+    if((buffer != (UARTBuffer*)0) &&
+       (dst != (uint8_t*)0))
     {
-        uint8_t bytesToCopy = length;
-        if((buffer->currentTxBufferPosition + bytesToCopy) >= UART_BUFFER_SIZE)
+        uint16_t readPosition = (uint16_t)((buffer->currentTxBufferPosition + offset) % UART_BUFFER_SIZE);
+        uint16_t firstPartLength = UART_BUFFER_SIZE - readPosition;
+        if(firstPartLength > length)
         {
-            bytesToCopy = UART_BUFFER_SIZE - buffer->currentTxBufferPosition;
+            firstPartLength = length;
         }
-        memcpy(&buffer->txBuffer[buffer->currentTxBufferPosition], data, bytesToCopy);
-        buffer->currentTxBufferPosition += bytesToCopy;
+        memcpy(dst, &buffer->txBuffer[readPosition], firstPartLength);
+        memcpy(&dst[firstPartLength], buffer->txBuffer, length - firstPartLength);
+    }
+}
+
+//Hands the written data to the transmitter.
+void UARTBufferCommitTxData(UARTBuffer* buffer, uint16_t length)
+{
+    if(buffer != (UARTBuffer*)0)
+    {
+        buffer->txBytesQueued += length;
+        //Publish before checking for a running transfer; either the completion interrupt
+        //sees the new position or the transfer has already ended and is started here.
+        __atomic_store_n(&buffer->currentTxBufferPosition, (uint16_t)((buffer->currentTxBufferPosition + length) % UART_BUFFER_SIZE), __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&buffer->txDmaBusy, __ATOMIC_SEQ_CST) == 0U)
+        {
+            StartTxTransfer(buffer);
+        }
+    }
+}
+
+//Only written by the main loop.
+uint32_t UARTBufferGetTxBytesQueued(UARTBuffer* buffer)
+{
+    uint32_t retVal = 0U;
+    if(buffer != (UARTBuffer*)0)
+    {
+        retVal = buffer->txBytesQueued;
+    }
+
+    return retVal;
+}
+
+//Counts up to UARTBufferGetTxBytesQueued as the transfers complete.
+uint32_t UARTBufferGetTxBytesSent(UARTBuffer* buffer)
+{
+    uint32_t retVal = 0U;
+    if(buffer != (UARTBuffer*)0)
+    {
+        retVal = __atomic_load_n(&buffer->txBytesSent, __ATOMIC_SEQ_CST);
     }
+
+    return retVal;
+}
+
+//Queues the data as a whole or not at all, so frames are never cut off. Returns 0 when the
+//ring has no room, the caller keeps the data and tries again later.
+uint8_t UARTBufferSendData(UARTBuffer* buffer, uint8_t* data, uint8_t length)
+{
+    uint8_t retVal = 0U;
+
+    if((buffer != (UARTBuffer*)0) &&
+       (data != (uint8_t*)0) &&
+       (length > 0U) &&
+       (UARTBufferGetTxFreeSpace(buffer) >= length))
+    {
+        UARTBufferWriteTxData(buffer, 0U, data, length);
+        UARTBufferCommitTxData(buffer, length);
+        retVal = 1U;
+    }
+
+    return retVal;
 }
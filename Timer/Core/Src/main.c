@@ -25,9 +25,12 @@
 /* USER CODE BEGIN Includes */
 #include "TimeMgmt.h"
 #include "Configuration.h"
-#include "RaceTiming.h"
 #include "Inputs.h"
 #include "UARTBuffer.h"
+#include "EventJournal.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "SensorTrace.h"
 #include <string.h>
 /* USER CODE END Includes */
 
@@ -63,7 +66,7 @@ static void MX_SPI2_Init(void);
 static void MX_SPI1_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
-
+static void InitSensorCapture(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -105,6 +108,20 @@ int main(void)
     SystemClock_Config();
 
     /* USER CODE BEGIN SysInit */
+    //The UARTs run on DMA1: USART1 TX/RX on channels 4/5, USART2 TX/RX on channels 7/6.
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    NVIC_SetPriority(DMA1_Channel4_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+    NVIC_SetPriority(DMA1_Channel5_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+    NVIC_SetPriority(DMA1_Channel6_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+    NVIC_SetPriority(DMA1_Channel7_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 3, 0));
+    NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+    //The 1ms SysTick wakes the scheduler from WFI, the debugger stays connected while it sleeps.
+    LL_SYSTICK_EnableIT();
+    LL_DBGMCU_EnableDBGSleepMode();
+    ProfilerInit();
 
     /* USER CODE END SysInit */
 
@@ -117,6 +134,7 @@ int main(void)
     MX_SPI1_Init();
     MX_USART2_UART_Init();
     /* USER CODE BEGIN 2 */
+    InitSensorCapture();
     LL_TIM_EnableIT_UPDATE(TIM2);
     LL_TIM_EnableCounter(TIM2);
     LL_I2C_Enable(I2C1);
@@ -124,7 +142,7 @@ int main(void)
     LL_GPIO_SetOutputPin(GPIOB, LL_GPIO_PIN_12);
     LL_SPI_Enable(SPI2);
     LL_SPI_Enable(SPI1);
-    LL_USART_DisableIT_RXNE(USART2);
+    EventJournalInit();
     InitInputs();
     //LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_11);
     //LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_8);
@@ -139,35 +157,7 @@ int main(void)
         /* USER CODE END WHILE */
 
         /* USER CODE BEGIN 3 */
-        UpdateAllInputs();
-        if(ppsTick == 1U)
-        {
-            LL_GPIO_TogglePin(GPIOC, LL_GPIO_PIN_13);
-            ppsTick = 0U;
-        }
-
-        if(enableDisplayLines != 0U)
-        {
-            LL_GPIO_SetOutputPin(DisplayLine1Ena_GPIO_Port, DisplayLine1Ena_Pin);
-            LL_GPIO_SetOutputPin(DisplayLine2Ena_GPIO_Port, DisplayLine2Ena_Pin);
-        }
-        else
-        {
-            LL_GPIO_ResetOutputPin(DisplayLine1Ena_GPIO_Port, DisplayLine1Ena_Pin);
-            LL_GPIO_ResetOutputPin(DisplayLine2Ena_GPIO_Port, DisplayLine2Ena_Pin);
-        }
-
-        if(autoConfigurationDone == 0U)
-        {
-            RunAutoConfiguration();
-        }
-        else
-        {
-            RunRaceTiming();
-
-            UARTBufferRunTxWork();
-
-        }
+        RunScheduler();
     }
     /* USER CODE END 3 */
 }
@@ -393,7 +383,7 @@ static void MX_TIM2_Init(void)
     /* USER CODE END TIM2_Init 1 */
     TIM_InitStruct.Prescaler = 31;
     TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
-    TIM_InitStruct.Autoreload = 99;
+    TIM_InitStruct.Autoreload = 49999;
     TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
     LL_TIM_Init(TIM2, &TIM_InitStruct);
     LL_TIM_EnableARRPreload(TIM2);
@@ -462,7 +452,8 @@ static void MX_USART1_UART_Init(void)
     if(buff != (UARTBuffer*)0)
     {
         buff->uartHandle = USART1;
-        LL_USART_EnableIT_RXNE(buff->uartHandle);
+        UARTBufferStartReception(buff, LL_DMA_CHANNEL_5);
+        UARTBufferStartTransmission(buff, LL_DMA_CHANNEL_4);
     }
     /* USER CODE END USART1_Init 2 */
 
@@ -524,7 +515,8 @@ static void MX_USART2_UART_Init(void)
     if(buff != (UARTBuffer*)0)
     {
         buff->uartHandle = USART2;
-        LL_USART_EnableIT_RXNE(buff->uartHandle);
+        UARTBufferStartTransmission(buff, LL_DMA_CHANNEL_7);
+        //Reception stays off, nothing reads USART2 input. Start it with UARTBufferStartReception(buff, LL_DMA_CHANNEL_6).
     }
 
     /* USER CODE END USART2_Init 2 */
@@ -648,9 +640,53 @@ static void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 4 */
 
-void ProcessUARTByte(uint8_t uartId, uint8_t uartByte)
+/**
+  * @brief Latches the TIM2 microsecond counter in hardware on the sensor and PPS edges.
+  *        With the full remap the PPS input (PB3) is TIM2 CH2 and the stop sensor (PB11)
+  *        is TIM2 CH4. The start/stop sensor (PA8) is TIM1 CH1, so TIM1 is reset by every
+  *        TIM2 update to count in phase with TIM2. The EXTI interrupts still fire and
+  *        read the captures.
+  * @param None
+  * @retval None
+  */
+static void InitSensorCapture(void)
+{
+    LL_TIM_InitTypeDef TIM_InitStruct = {0};
+    uint32_t captureConfig = LL_TIM_ACTIVEINPUT_DIRECTTI | LL_TIM_ICPSC_DIV1 | LL_TIM_IC_FILTER_FDIV1_N8 | LL_TIM_IC_POLARITY_RISING;
+
+    LL_GPIO_AF_EnableRemap_TIM2();
+    //SWJ_CFG is write only, make sure PB3 stays released from JTAG.
+    LL_GPIO_AF_Remap_SWJ_NOJTAG();
+
+    LL_TIM_SetTriggerOutput(TIM2, LL_TIM_TRGO_UPDATE);
+    LL_TIM_IC_Config(TIM2, LL_TIM_CHANNEL_CH2, captureConfig);
+    LL_TIM_IC_Config(TIM2, LL_TIM_CHANNEL_CH4, captureConfig);
+    LL_TIM_CC_EnableChannel(TIM2, LL_TIM_CHANNEL_CH2 | LL_TIM_CHANNEL_CH4);
+
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM1);
+
+    TIM_InitStruct.Prescaler = 31;
+    TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
+    TIM_InitStruct.Autoreload = 49999;
+    TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
+    TIM_InitStruct.RepetitionCounter = 0;
+    LL_TIM_Init(TIM1, &TIM_InitStruct);
+    LL_TIM_SetTriggerInput(TIM1, LL_TIM_TS_ITR1);
+    LL_TIM_SetSlaveMode(TIM1, LL_TIM_SLAVEMODE_RESET);
+    LL_TIM_IC_Config(TIM1, LL_TIM_CHANNEL_CH1, captureConfig);
+    LL_TIM_CC_EnableChannel(TIM1, LL_TIM_CHANNEL_CH1);
+    LL_TIM_EnableCounter(TIM1);
+}
+
+void ProcessUARTReception(uint8_t uartId)
+{
+    UARTBufferProcessReceivedData(UARTBufferGetUART(uartId));
+}
+
+void ProcessUARTTransmitComplete(uint8_t uartId)
 {
-    UARTBufferProcessReceivedByte(UARTBufferGetUART(uartId), uartByte);
+    UARTBufferProcessTransmitComplete(UARTBufferGetUART(uartId));
+    SensorTraceTransmitComplete(uartId);
 }
 
 /* USER CODE END 4 */
@@ -209,9 +209,7 @@ void EXTI3_IRQHandler(void)
     if(LL_EXTI_IsActiveFlag_0_31(LL_EXTI_LINE_3) != RESET)
     {
         /* USER CODE BEGIN LL_EXTI_LINE_3 */
-        systemTime.timeStampPps++;
-        systemTime.ppsOffset100us = 0U;
-        ppsTick = 1U;
+        HandlePpsPulse();
         LL_EXTI_ClearFlag_0_31(LL_EXTI_LINE_3);
         /* USER CODE END LL_EXTI_LINE_3 */
     }
@@ -231,11 +229,7 @@ void EXTI9_5_IRQHandler(void)
     if(LL_EXTI_IsActiveFlag_0_31(LL_EXTI_LINE_8) != RESET)
     {
         /* USER CODE BEGIN LL_EXTI_LINE_8 */
-        if((sensorStartStopTimeStamp.timeStamp100us + MIN_SENSOR_INTERRUPT_WAIT) <= systemTime.timeStamp100us)
-        {
-            sensorStartStopTimeStamp = systemTime;
-            sensorStartStopInterrupt = 1U;
-        }
+        HandleStartStopSensorTrigger();
         LL_EXTI_ClearFlag_0_31(LL_EXTI_LINE_8);
         /* USER CODE END LL_EXTI_LINE_8 */
     }
@@ -250,8 +244,7 @@ void EXTI9_5_IRQHandler(void)
 void TIM2_IRQHandler(void)
 {
     /* USER CODE BEGIN TIM2_IRQn 0 */
-    systemTime.timeStamp100us++;
-    systemTime.ppsOffset100us++;
+    HandleTimerOverflow();
     LL_TIM_ClearFlag_UPDATE(TIM2);
     /* USER CODE END TIM2_IRQn 0 */
     /* USER CODE BEGIN TIM2_IRQn 1 */
@@ -265,9 +258,10 @@ void TIM2_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
     /* USER CODE BEGIN USART1_IRQn 0 */
-    if((USART1->SR & USART_SR_RXNE) != 0U)
+    if(LL_USART_IsActiveFlag_IDLE(USART1) != 0U)
     {
-        ProcessUARTByte(0, (uint8_t)USART1->DR);
+        LL_USART_ClearFlag_IDLE(USART1);
+        ProcessUARTReception(0);
     }
 
     /* USER CODE END USART1_IRQn 0 */
@@ -282,9 +276,10 @@ void USART1_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
     /* USER CODE BEGIN USART2_IRQn 0 */
-    if((USART2->SR & USART_SR_RXNE) != 0U)
+    if(LL_USART_IsActiveFlag_IDLE(USART2) != 0U)
     {
-        ProcessUARTByte(1, (uint8_t)USART2->DR);
+        LL_USART_ClearFlag_IDLE(USART2);
+        ProcessUARTReception(1);
     }
 
     /* USER CODE END USART2_IRQn 0 */
@@ -304,11 +299,7 @@ void EXTI15_10_IRQHandler(void)
     if(LL_EXTI_IsActiveFlag_0_31(LL_EXTI_LINE_11) != RESET)
     {
         /* USER CODE BEGIN LL_EXTI_LINE_11 */
-        if((sensorStopTimeStamp.timeStamp100us + MIN_SENSOR_INTERRUPT_WAIT) <= systemTime.timeStamp100us)
-        {
-            sensorStopTimeStamp = systemTime;
-            sensorStopInterrupt = 1U;
-        }
+        HandleStopSensorTrigger();
         LL_EXTI_ClearFlag_0_31(LL_EXTI_LINE_11);
         /* USER CODE END LL_EXTI_LINE_11 */
     }
@@ -318,6 +309,61 @@ void EXTI15_10_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA1 channel4 (USART1_TX) interrupts.
+  */
+void DMA1_Channel4_IRQHandler(void)
+{
+    if(LL_DMA_IsActiveFlag_TC4(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_TC4(DMA1);
+        ProcessUARTTransmitComplete(0);
+    }
+}
+
+/**
+  * @brief This function handles DMA1 channel5 (USART1_RX) interrupts.
+  */
+void DMA1_Channel5_IRQHandler(void)
+{
+    if(LL_DMA_IsActiveFlag_HT5(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_HT5(DMA1);
+    }
+    if(LL_DMA_IsActiveFlag_TC5(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_TC5(DMA1);
+    }
+    ProcessUARTReception(0);
+}
+
+/**
+  * @brief This function handles DMA1 channel6 (USART2_RX) interrupts.
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+    if(LL_DMA_IsActiveFlag_HT6(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_HT6(DMA1);
+    }
+    if(LL_DMA_IsActiveFlag_TC6(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_TC6(DMA1);
+    }
+    ProcessUARTReception(1);
+}
+
+/**
+  * @brief This function handles DMA1 channel7 (USART2_TX) interrupts.
+  */
+void DMA1_Channel7_IRQHandler(void)
+{
+    if(LL_DMA_IsActiveFlag_TC7(DMA1) != 0U)
+    {
+        LL_DMA_ClearFlag_TC7(DMA1);
+        ProcessUARTTransmitComplete(1);
+    }
+}
 
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,37 @@
+/*
+ * HostFlash.h
+ *
+ * Simulated flash behind FlashPort.h for the host build. Keeps the rules of
+ * the STM32F1 flash: erased half words read 0xFFFF and only those can be
+ * programmed, except with 0x0000. Counts erases per page and the time the
+ * real flash would have been busy, and can cut the power halfway a write.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_HOSTFLASH_H_
+#define HOST_HOSTFLASH_H_
+
+#include <stdint.h>
+#include "FlashPort.h"
+
+//Typical STM32F103 datasheet timings.
+#define HOSTFLASH_PROGRAMTIME1US 52U
+#define HOSTFLASH_ERASETIME1US 20000U
+
+typedef struct
+{
+    uint32_t eraseCounts[FLASHPORTPAGECOUNT];
+    uint64_t programmedHalfWords;
+    uint32_t programErrors;
+    uint64_t busyTime1us;
+} HostFlashStats;
+
+//Erases everything and clears the statistics, like a factory fresh part.
+void HostFlashReset(void);
+//After this many more half words every erase and program is lost until the power is restored.
+void HostFlashCutPowerAfter(uint32_t halfWords);
+void HostFlashRestorePower(void);
+void HostFlashGetStats(HostFlashStats* stats);
+
+#endif /* HOST_HOSTFLASH_H_ */
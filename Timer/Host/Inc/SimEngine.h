@@ -0,0 +1,67 @@
+/*
+ * SimEngine.h
+ *
+ * Host simulation engine for the Timer firmware core. Drives the TIM2
+ * counter from a virtual clock, raises the sensor and PPS EXTI
+ * handlers on demand and moves UART bytes at the baud rate the firmware
+ * set, delivering received bytes through the DMA model. Bytes crossing a
+ * line whose ends run at different rates arrive garbled.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_SIMENGINE_H_
+#define HOST_SIMENGINE_H_
+
+#include <stdint.h>
+
+#define SIM_TICKS_PER_SECOND 10000U
+#define SIM_TICKS_PER_MS 10U
+#define SIM_UART_COUNT 2U
+#define SIM_DEFAULT_BAUDRATE 115200U
+
+typedef enum
+{
+    SimSensorStartStop = 0U,
+    SimSensorStop = 1U,
+    SimSensorCount = 2U
+} SimSensor;
+
+typedef struct
+{
+    uint64_t iterations;
+    uint64_t totalNs;
+    uint64_t maxNs;
+} SimLoopStats;
+
+typedef struct
+{
+    uint64_t timerInterrupts;
+    uint32_t triggers[SimSensorCount];
+    uint32_t maskedTriggers[SimSensorCount];
+    uint32_t rxOverruns[SIM_UART_COUNT];
+    uint64_t rxInterrupts[SIM_UART_COUNT];
+    uint64_t txInterrupts[SIM_UART_COUNT];
+    uint64_t txBytes[SIM_UART_COUNT];
+    uint64_t rxBytes[SIM_UART_COUNT];
+    uint64_t sleeps; //Main loop iterations that ended in WFI
+} SimCounters;
+
+//Called when the last bit of a byte has left the simulated USART.
+typedef void (*SimTxByteCallback)(uint8_t uart, uint8_t byte);
+
+void SimInit(uint32_t baudRate);
+void SimSetJumpers(uint8_t dualSensor, uint8_t opModeJumper);
+//Rate of the other end of the line, SimInit starts both ends at the same rate.
+void SimSetLineBaudRate(uint8_t uart, uint32_t baudRate);
+void SimSetTxCallback(SimTxByteCallback callback);
+void SimStep(uint32_t mainLoopIterations);
+void SimRunMainLoopIteration(void);
+//Raises a sensor edge the given number of microseconds into the current 100us step.
+void SimTriggerSensor(SimSensor sensor, uint8_t tickOffset1us);
+uint8_t SimUartInject(uint8_t uart, const uint8_t* data, uint16_t length);
+uint64_t SimGetTime100us(void);
+void SimGetLoopStats(SimLoopStats* stats);
+void SimGetCounters(SimCounters* counters);
+
+#endif /* HOST_SIMENGINE_H_ */
@@ -0,0 +1,140 @@
+/*
+ * stm32f1xx.h
+ *
+ * Host stand-in for the CMSIS device header. Only the peripherals and
+ * register bits that the Timer core touches are modelled; the register
+ * blocks are plain RAM that the simulation engine reads and writes.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_H_
+#define HOST_STM32F1XX_H_
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef struct
+{
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR3;
+} USART_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    uint32_t wordsSent;
+} SPI_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t SR1;
+    __IO uint32_t DR;
+    uint32_t bytesSent;
+} I2C_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CNT;
+    __IO uint32_t SR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR4;
+} TIM_TypeDef;
+
+//CMAR and CPAR hold full host pointers.
+typedef struct
+{
+    __IO uint32_t CCR;
+    __IO uint32_t CNDTR;
+    __IO uintptr_t CPAR;
+    __IO uintptr_t CMAR;
+    uint32_t dataLength; //Reload value for circular mode, internal on the hardware
+} DMA_Channel_TypeDef;
+
+//Indexed by the LL channel number, entry 0 is unused.
+typedef struct
+{
+    __IO uint32_t ISR;
+    DMA_Channel_TypeDef channel[8];
+} DMA_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t RTSR;
+    __IO uint32_t PR;
+} EXTI_TypeDef;
+
+extern GPIO_TypeDef HostGPIOA;
+extern GPIO_TypeDef HostGPIOB;
+extern GPIO_TypeDef HostGPIOC;
+extern USART_TypeDef HostUSART1;
+extern USART_TypeDef HostUSART2;
+extern SPI_TypeDef HostSPI1;
+extern SPI_TypeDef HostSPI2;
+extern I2C_TypeDef HostI2C1;
+extern TIM_TypeDef HostTIM1;
+extern TIM_TypeDef HostTIM2;
+extern EXTI_TypeDef HostEXTI;
+extern DMA_TypeDef HostDMA1;
+
+#define GPIOA (&HostGPIOA)
+#define GPIOB (&HostGPIOB)
+#define GPIOC (&HostGPIOC)
+#define USART1 (&HostUSART1)
+#define USART2 (&HostUSART2)
+#define SPI1 (&HostSPI1)
+#define SPI2 (&HostSPI2)
+#define I2C1 (&HostI2C1)
+#define TIM1 (&HostTIM1)
+#define TIM2 (&HostTIM2)
+#define EXTI (&HostEXTI)
+#define DMA1 (&HostDMA1)
+
+#define USART_SR_TXE (1U << 7)
+#define USART_SR_TC (1U << 6)
+#define USART_SR_RXNE (1U << 5)
+#define USART_SR_IDLE (1U << 4)
+#define USART_CR1_UE (1U << 13)
+#define USART_CR1_RXNEIE (1U << 5)
+#define USART_CR1_IDLEIE (1U << 4)
+#define USART_CR3_DMAR (1U << 6)
+#define USART_CR3_DMAT (1U << 7)
+
+#define DMA_CCR_EN (1U << 0)
+#define DMA_CCR_TCIE (1U << 1)
+#define DMA_CCR_HTIE (1U << 2)
+#define DMA_CCR_DIR (1U << 4)
+#define DMA_CCR_CIRC (1U << 5)
+#define DMA_CCR_MINC (1U << 7)
+#define DMA_CCR_PL_0 (1U << 12)
+
+#define TIM_SR_UIF (1U << 0)
+#define TIM_SR_CC1IF (1U << 1)
+#define TIM_SR_CC2IF (1U << 2)
+#define TIM_SR_CC4IF (1U << 4)
+
+#define SPI_SR_TXE (1U << 1)
+#define SPI_SR_BSY (1U << 7)
+
+#define RESET 0U
+#define SET 1U
+
+//Core intrinsics. There are no interrupts to mask, the engine runs them between main loop iterations.
+void HostWaitForInterrupt(void);
+#define __WFI() HostWaitForInterrupt()
+#define __disable_irq()
+#define __enable_irq()
+
+#endif /* HOST_STM32F1XX_H_ */
@@ -0,0 +1,101 @@
+/*
+ * stm32f1xx_ll_dma.h
+ *
+ * Host stand-in for the LL DMA driver. Addresses are host pointers; the
+ * simulation engine performs the transfers of enabled channels and raises
+ * the half and full transfer interrupts.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_DMA_H_
+#define HOST_STM32F1XX_LL_DMA_H_
+
+#include "stm32f1xx.h"
+
+#define LL_DMA_CHANNEL_1 0x00000001U
+#define LL_DMA_CHANNEL_2 0x00000002U
+#define LL_DMA_CHANNEL_3 0x00000003U
+#define LL_DMA_CHANNEL_4 0x00000004U
+#define LL_DMA_CHANNEL_5 0x00000005U
+#define LL_DMA_CHANNEL_6 0x00000006U
+#define LL_DMA_CHANNEL_7 0x00000007U
+
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY 0x00000000U
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH DMA_CCR_DIR
+#define LL_DMA_MODE_NORMAL 0x00000000U
+#define LL_DMA_MODE_CIRCULAR DMA_CCR_CIRC
+#define LL_DMA_PERIPH_NOINCREMENT 0x00000000U
+#define LL_DMA_MEMORY_INCREMENT DMA_CCR_MINC
+#define LL_DMA_PDATAALIGN_BYTE 0x00000000U
+#define LL_DMA_MDATAALIGN_BYTE 0x00000000U
+#define LL_DMA_PRIORITY_LOW 0x00000000U
+#define LL_DMA_PRIORITY_MEDIUM DMA_CCR_PL_0
+
+static inline void LL_DMA_ConfigTransfer(DMA_TypeDef* DMAx, uint32_t Channel, uint32_t Configuration)
+{
+    DMAx->channel[Channel].CCR = (DMAx->channel[Channel].CCR & (DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_HTIE)) | Configuration;
+}
+
+static inline void LL_DMA_ConfigAddresses(DMA_TypeDef* DMAx, uint32_t Channel, uintptr_t SrcAddress,
+                                          uintptr_t DstAddress, uint32_t Direction)
+{
+    if(Direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH)
+    {
+        DMAx->channel[Channel].CMAR = SrcAddress;
+        DMAx->channel[Channel].CPAR = DstAddress;
+    }
+    else
+    {
+        DMAx->channel[Channel].CPAR = SrcAddress;
+        DMAx->channel[Channel].CMAR = DstAddress;
+    }
+}
+
+static inline void LL_DMA_SetMemoryAddress(DMA_TypeDef* DMAx, uint32_t Channel, uintptr_t MemoryAddress)
+{
+    DMAx->channel[Channel].CMAR = MemoryAddress;
+}
+
+static inline void LL_DMA_SetPeriphAddress(DMA_TypeDef* DMAx, uint32_t Channel, uintptr_t PeriphAddress)
+{
+    DMAx->channel[Channel].CPAR = PeriphAddress;
+}
+
+static inline void LL_DMA_SetDataLength(DMA_TypeDef* DMAx, uint32_t Channel, uint32_t NbData)
+{
+    DMAx->channel[Channel].CNDTR = NbData;
+    DMAx->channel[Channel].dataLength = NbData;
+}
+
+static inline uint32_t LL_DMA_GetDataLength(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    return DMAx->channel[Channel].CNDTR;
+}
+
+static inline void LL_DMA_EnableChannel(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    DMAx->channel[Channel].CCR |= DMA_CCR_EN;
+}
+
+static inline void LL_DMA_DisableChannel(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    DMAx->channel[Channel].CCR &= ~DMA_CCR_EN;
+}
+
+static inline uint32_t LL_DMA_IsEnabledChannel(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    return ((DMAx->channel[Channel].CCR & DMA_CCR_EN) == DMA_CCR_EN) ? 1U : 0U;
+}
+
+static inline void LL_DMA_EnableIT_HT(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    DMAx->channel[Channel].CCR |= DMA_CCR_HTIE;
+}
+
+static inline void LL_DMA_EnableIT_TC(DMA_TypeDef* DMAx, uint32_t Channel)
+{
+    DMAx->channel[Channel].CCR |= DMA_CCR_TCIE;
+}
+
+#endif /* HOST_STM32F1XX_LL_DMA_H_ */
@@ -0,0 +1,45 @@
+/*
+ * stm32f1xx_ll_exti.h
+ *
+ * Host stand-in for the LL EXTI driver. The simulation engine only raises
+ * a sensor edge when the rising trigger of that line is enabled, just like
+ * the real EXTI block.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_EXTI_H_
+#define HOST_STM32F1XX_LL_EXTI_H_
+
+#include "stm32f1xx.h"
+
+#define LL_EXTI_LINE_3 (1U << 3)
+#define LL_EXTI_LINE_8 (1U << 8)
+#define LL_EXTI_LINE_11 (1U << 11)
+
+static inline void LL_EXTI_EnableRisingTrig_0_31(uint32_t ExtiLine)
+{
+    EXTI->RTSR |= ExtiLine;
+}
+
+static inline void LL_EXTI_DisableRisingTrig_0_31(uint32_t ExtiLine)
+{
+    EXTI->RTSR &= ~ExtiLine;
+}
+
+static inline uint32_t LL_EXTI_IsEnabledRisingTrig_0_31(uint32_t ExtiLine)
+{
+    return ((EXTI->RTSR & ExtiLine) == ExtiLine) ? 1U : 0U;
+}
+
+static inline uint32_t LL_EXTI_IsActiveFlag_0_31(uint32_t ExtiLine)
+{
+    return ((EXTI->PR & ExtiLine) == ExtiLine) ? 1U : 0U;
+}
+
+static inline void LL_EXTI_ClearFlag_0_31(uint32_t ExtiLine)
+{
+    EXTI->PR &= ~ExtiLine;
+}
+
+#endif /* HOST_STM32F1XX_LL_EXTI_H_ */
@@ -0,0 +1,52 @@
+/*
+ * stm32f1xx_ll_gpio.h
+ *
+ * Host stand-in for the LL GPIO driver. Pins are plain bit masks into the
+ * simulated IDR/ODR registers.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_GPIO_H_
+#define HOST_STM32F1XX_LL_GPIO_H_
+
+#include "stm32f1xx.h"
+
+#define LL_GPIO_PIN_0 (1U << 0)
+#define LL_GPIO_PIN_1 (1U << 1)
+#define LL_GPIO_PIN_2 (1U << 2)
+#define LL_GPIO_PIN_3 (1U << 3)
+#define LL_GPIO_PIN_4 (1U << 4)
+#define LL_GPIO_PIN_5 (1U << 5)
+#define LL_GPIO_PIN_6 (1U << 6)
+#define LL_GPIO_PIN_7 (1U << 7)
+#define LL_GPIO_PIN_8 (1U << 8)
+#define LL_GPIO_PIN_9 (1U << 9)
+#define LL_GPIO_PIN_10 (1U << 10)
+#define LL_GPIO_PIN_11 (1U << 11)
+#define LL_GPIO_PIN_12 (1U << 12)
+#define LL_GPIO_PIN_13 (1U << 13)
+#define LL_GPIO_PIN_14 (1U << 14)
+#define LL_GPIO_PIN_15 (1U << 15)
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef* GPIOx, uint32_t PinMask)
+{
+    return ((GPIOx->IDR & PinMask) == PinMask) ? 1U : 0U;
+}
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef* GPIOx, uint32_t PinMask)
+{
+    GPIOx->ODR |= PinMask;
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef* GPIOx, uint32_t PinMask)
+{
+    GPIOx->ODR &= ~PinMask;
+}
+
+static inline void LL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint32_t PinMask)
+{
+    GPIOx->ODR ^= PinMask;
+}
+
+#endif /* HOST_STM32F1XX_LL_GPIO_H_ */
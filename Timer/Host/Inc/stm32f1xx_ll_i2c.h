@@ -0,0 +1,90 @@
+/*
+ * stm32f1xx_ll_i2c.h
+ *
+ * Host stand-in for the LL I2C driver. The simulated bus acknowledges every
+ * step, so the DS3231 configuration in Configuration.c always succeeds.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_I2C_H_
+#define HOST_STM32F1XX_LL_I2C_H_
+
+#include "stm32f1xx.h"
+
+static inline uint32_t LL_I2C_IsActiveFlag_AF(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 0U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_BERR(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 0U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_ARLO(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 0U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_OVR(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 0U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_BUSY(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 0U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_SB(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 1U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_ADDR(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 1U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_TXE(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 1U;
+}
+
+static inline uint32_t LL_I2C_IsActiveFlag_BTF(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+    return 1U;
+}
+
+static inline void LL_I2C_ClearFlag_ADDR(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+}
+
+static inline void LL_I2C_GenerateStartCondition(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+}
+
+static inline void LL_I2C_GenerateStopCondition(I2C_TypeDef* I2Cx)
+{
+    (void)I2Cx;
+}
+
+static inline void LL_I2C_TransmitData8(I2C_TypeDef* I2Cx, uint8_t Data)
+{
+    I2Cx->DR = Data;
+    I2Cx->bytesSent++;
+}
+
+#endif /* HOST_STM32F1XX_LL_I2C_H_ */
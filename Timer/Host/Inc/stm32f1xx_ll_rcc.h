@@ -0,0 +1,33 @@
+/*
+ * stm32f1xx_ll_rcc.h
+ *
+ * Host stand-in for the LL RCC driver. Reports the clocks SystemClock_Config
+ * in main.c sets up: 32MHz from the PLL, both APB buses undivided.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_RCC_H_
+#define HOST_STM32F1XX_LL_RCC_H_
+
+#include "stm32f1xx.h"
+
+#define HOST_SYSCLK_FREQUENCY 32000000U
+
+typedef struct
+{
+    uint32_t SYSCLK_Frequency;
+    uint32_t HCLK_Frequency;
+    uint32_t PCLK1_Frequency;
+    uint32_t PCLK2_Frequency;
+} LL_RCC_ClocksTypeDef;
+
+static inline void LL_RCC_GetSystemClocksFreq(LL_RCC_ClocksTypeDef* RCC_Clocks)
+{
+    RCC_Clocks->SYSCLK_Frequency = HOST_SYSCLK_FREQUENCY;
+    RCC_Clocks->HCLK_Frequency = HOST_SYSCLK_FREQUENCY;
+    RCC_Clocks->PCLK1_Frequency = HOST_SYSCLK_FREQUENCY;
+    RCC_Clocks->PCLK2_Frequency = HOST_SYSCLK_FREQUENCY;
+}
+
+#endif /* HOST_STM32F1XX_LL_RCC_H_ */
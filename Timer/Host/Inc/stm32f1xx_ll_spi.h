@@ -0,0 +1,33 @@
+/*
+ * stm32f1xx_ll_spi.h
+ *
+ * Host stand-in for the LL SPI driver. Transfers complete instantly, the
+ * engine only counts the words sent to the displays.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_SPI_H_
+#define HOST_STM32F1XX_LL_SPI_H_
+
+#include "stm32f1xx.h"
+
+static inline uint32_t LL_SPI_IsActiveFlag_TXE(SPI_TypeDef* SPIx)
+{
+    (void)SPIx;
+    return 1U;
+}
+
+static inline uint32_t LL_SPI_IsActiveFlag_BSY(SPI_TypeDef* SPIx)
+{
+    (void)SPIx;
+    return 0U;
+}
+
+static inline void LL_SPI_TransmitData16(SPI_TypeDef* SPIx, uint16_t TxData)
+{
+    SPIx->DR = TxData;
+    SPIx->wordsSent++;
+}
+
+#endif /* HOST_STM32F1XX_LL_SPI_H_ */
@@ -0,0 +1,64 @@
+/*
+ * stm32f1xx_ll_tim.h
+ *
+ * Host stand-in for the LL TIM driver. The simulation engine sets the
+ * counter and latches the capture registers when it raises a sensor edge.
+ * As on the real timer, reading a capture register clears its flag.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_TIM_H_
+#define HOST_STM32F1XX_LL_TIM_H_
+
+#include "stm32f1xx.h"
+
+static inline uint32_t LL_TIM_GetCounter(TIM_TypeDef* TIMx)
+{
+    return TIMx->CNT;
+}
+
+static inline uint32_t LL_TIM_IsActiveFlag_UPDATE(TIM_TypeDef* TIMx)
+{
+    return ((TIMx->SR & TIM_SR_UIF) == TIM_SR_UIF) ? 1U : 0U;
+}
+
+static inline void LL_TIM_ClearFlag_UPDATE(TIM_TypeDef* TIMx)
+{
+    TIMx->SR &= ~TIM_SR_UIF;
+}
+
+static inline uint32_t LL_TIM_IsActiveFlag_CC1(TIM_TypeDef* TIMx)
+{
+    return ((TIMx->SR & TIM_SR_CC1IF) == TIM_SR_CC1IF) ? 1U : 0U;
+}
+
+static inline uint32_t LL_TIM_IsActiveFlag_CC2(TIM_TypeDef* TIMx)
+{
+    return ((TIMx->SR & TIM_SR_CC2IF) == TIM_SR_CC2IF) ? 1U : 0U;
+}
+
+static inline uint32_t LL_TIM_IsActiveFlag_CC4(TIM_TypeDef* TIMx)
+{
+    return ((TIMx->SR & TIM_SR_CC4IF) == TIM_SR_CC4IF) ? 1U : 0U;
+}
+
+static inline uint32_t LL_TIM_IC_GetCaptureCH1(TIM_TypeDef* TIMx)
+{
+    TIMx->SR &= ~TIM_SR_CC1IF;
+    return TIMx->CCR1;
+}
+
+static inline uint32_t LL_TIM_IC_GetCaptureCH2(TIM_TypeDef* TIMx)
+{
+    TIMx->SR &= ~TIM_SR_CC2IF;
+    return TIMx->CCR2;
+}
+
+static inline uint32_t LL_TIM_IC_GetCaptureCH4(TIM_TypeDef* TIMx)
+{
+    TIMx->SR &= ~TIM_SR_CC4IF;
+    return TIMx->CCR4;
+}
+
+#endif /* HOST_STM32F1XX_LL_TIM_H_ */
@@ -0,0 +1,125 @@
+/*
+ * stm32f1xx_ll_usart.h
+ *
+ * Host stand-in for the LL USART driver. A write to DR clears TXE; the
+ * simulation engine shifts the byte out at the rate set in BRR, sets TXE
+ * again and sets TC once no next byte is waiting. As on the hardware a DR
+ * write by the DMA leaves TC alone, it has to be cleared before a transfer.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef HOST_STM32F1XX_LL_USART_H_
+#define HOST_STM32F1XX_LL_USART_H_
+
+#include "stm32f1xx.h"
+
+static inline uint32_t LL_USART_IsActiveFlag_TXE(USART_TypeDef* USARTx)
+{
+    return ((USARTx->SR & USART_SR_TXE) == USART_SR_TXE) ? 1U : 0U;
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_TC(USART_TypeDef* USARTx)
+{
+    return ((USARTx->SR & USART_SR_TC) == USART_SR_TC) ? 1U : 0U;
+}
+
+static inline void LL_USART_ClearFlag_TC(USART_TypeDef* USARTx)
+{
+    USARTx->SR &= ~USART_SR_TC;
+}
+
+static inline void LL_USART_TransmitData8(USART_TypeDef* USARTx, uint8_t Value)
+{
+    USARTx->DR = Value;
+    USARTx->SR &= ~USART_SR_TXE;
+}
+
+static inline void LL_USART_Enable(USART_TypeDef* USARTx)
+{
+    USARTx->CR1 |= USART_CR1_UE;
+}
+
+static inline void LL_USART_Disable(USART_TypeDef* USARTx)
+{
+    USARTx->CR1 &= ~USART_CR1_UE;
+}
+
+//BRR holds the peripheral clock divided by the baud rate, 4 bits of it being the fraction.
+static inline void LL_USART_SetBaudRate(USART_TypeDef* USARTx, uint32_t PeriphClk, uint32_t BaudRate)
+{
+    USARTx->BRR = (PeriphClk + (BaudRate / 2U)) / BaudRate;
+}
+
+static inline uint32_t LL_USART_GetBaudRate(USART_TypeDef* USARTx, uint32_t PeriphClk)
+{
+    uint32_t retVal = 0U;
+    if(USARTx->BRR != 0U)
+    {
+        retVal = PeriphClk / USARTx->BRR;
+    }
+    return retVal;
+}
+
+static inline void LL_USART_EnableIT_RXNE(USART_TypeDef* USARTx)
+{
+    USARTx->CR1 |= USART_CR1_RXNEIE;
+}
+
+static inline void LL_USART_DisableIT_RXNE(USART_TypeDef* USARTx)
+{
+    USARTx->CR1 &= ~USART_CR1_RXNEIE;
+}
+
+static inline uint32_t LL_USART_IsEnabledIT_RXNE(USART_TypeDef* USARTx)
+{
+    return ((USARTx->CR1 & USART_CR1_RXNEIE) == USART_CR1_RXNEIE) ? 1U : 0U;
+}
+
+static inline void LL_USART_EnableIT_IDLE(USART_TypeDef* USARTx)
+{
+    USARTx->CR1 |= USART_CR1_IDLEIE;
+}
+
+static inline uint32_t LL_USART_IsEnabledIT_IDLE(USART_TypeDef* USARTx)
+{
+    return ((USARTx->CR1 & USART_CR1_IDLEIE) == USART_CR1_IDLEIE) ? 1U : 0U;
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_IDLE(USART_TypeDef* USARTx)
+{
+    return ((USARTx->SR & USART_SR_IDLE) == USART_SR_IDLE) ? 1U : 0U;
+}
+
+//The hardware clears IDLE with a read of SR followed by a read of DR.
+static inline void LL_USART_ClearFlag_IDLE(USART_TypeDef* USARTx)
+{
+    USARTx->SR &= ~USART_SR_IDLE;
+}
+
+static inline void LL_USART_EnableDMAReq_RX(USART_TypeDef* USARTx)
+{
+    USARTx->CR3 |= USART_CR3_DMAR;
+}
+
+static inline uint32_t LL_USART_IsEnabledDMAReq_RX(USART_TypeDef* USARTx)
+{
+    return ((USARTx->CR3 & USART_CR3_DMAR) == USART_CR3_DMAR) ? 1U : 0U;
+}
+
+static inline void LL_USART_EnableDMAReq_TX(USART_TypeDef* USARTx)
+{
+    USARTx->CR3 |= USART_CR3_DMAT;
+}
+
+static inline uint32_t LL_USART_IsEnabledDMAReq_TX(USART_TypeDef* USARTx)
+{
+    return ((USARTx->CR3 & USART_CR3_DMAT) == USART_CR3_DMAT) ? 1U : 0U;
+}
+
+static inline uintptr_t LL_USART_DMA_GetRegAddr(USART_TypeDef* USARTx)
+{
+    return (uintptr_t)&USARTx->DR;
+}
+
+#endif /* HOST_STM32F1XX_LL_USART_H_ */
@@ -0,0 +1,123 @@
+/*
+ * HostFlash.c
+ *
+ * Simulated flash for the event journal, see HostFlash.h.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include <string.h>
+
+#include "HostFlash.h"
+
+static uint8_t flash[FLASHPORTSIZE];
+static uint8_t initialised = 0U;
+static HostFlashStats stats;
+static uint8_t powerCutArmed = 0U;
+static uint32_t halfWordsUntilPowerCut = 0U;
+
+static void EnsureInitialised(void)
+{
+    if(initialised == 0U)
+    {
+        HostFlashReset();
+    }
+}
+
+static uint8_t HasPower(void)
+{
+    uint8_t retVal = 1U;
+    if((powerCutArmed == 1U) && (halfWordsUntilPowerCut == 0U))
+    {
+        retVal = 0U;
+    }
+    return retVal;
+}
+
+void HostFlashReset(void)
+{
+    memset(flash, 0xFF, sizeof(flash));
+    memset(&stats, 0, sizeof(stats));
+    powerCutArmed = 0U;
+    initialised = 1U;
+}
+
+void HostFlashCutPowerAfter(uint32_t halfWords)
+{
+    EnsureInitialised();
+    powerCutArmed = 1U;
+    halfWordsUntilPowerCut = halfWords;
+}
+
+void HostFlashRestorePower(void)
+{
+    powerCutArmed = 0U;
+}
+
+void HostFlashGetStats(HostFlashStats* copy)
+{
+    EnsureInitialised();
+    (*copy) = stats;
+}
+
+uint8_t FlashPortErasePage(uint8_t page)
+{
+    uint8_t retVal = 0U;
+
+    EnsureInitialised();
+    if((page < FLASHPORTPAGECOUNT) && (HasPower() == 1U))
+    {
+        memset(&flash[(uint32_t)page * FLASHPORTPAGESIZE], 0xFF, FLASHPORTPAGESIZE);
+        stats.eraseCounts[page]++;
+        stats.busyTime1us += HOSTFLASH_ERASETIME1US;
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+uint8_t FlashPortProgram(uint32_t offset, const uint16_t* data, uint16_t halfWords)
+{
+    uint8_t retVal = 0U;
+    uint16_t index;
+
+    EnsureInitialised();
+    if(((offset & 1U) == 0U) && ((offset + ((uint32_t)halfWords * 2U)) <= FLASHPORTSIZE))
+    {
+        retVal = 1U;
+        for(index = 0U; (index < halfWords) && (retVal == 1U); index++)
+        {
+            uint8_t* destination = &flash[offset + ((uint32_t)index * 2U)];
+            uint16_t current = (uint16_t)(destination[0] | (destination[1] << 8));
+
+            if(HasPower() == 0U)
+            {
+                retVal = 0U;
+            }
+            else if((current != 0xFFFFU) && (data[index] != 0x0000U))
+            {
+                stats.programErrors++;
+                retVal = 0U;
+            }
+            else
+            {
+                destination[0] = (uint8_t)(data[index] & 0xFFU);
+                destination[1] = (uint8_t)(data[index] >> 8);
+                stats.programmedHalfWords++;
+                stats.busyTime1us += HOSTFLASH_PROGRAMTIME1US;
+                if(powerCutArmed == 1U)
+                {
+                    halfWordsUntilPowerCut--;
+                }
+            }
+        }
+    }
+
+    return retVal;
+}
+
+const uint8_t* FlashPortGetData(uint32_t offset)
+{
+    EnsureInitialised();
+    return &flash[offset];
+}
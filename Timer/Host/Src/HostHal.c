@@ -0,0 +1,22 @@
+/*
+ * HostHal.c
+ *
+ * Register blocks for the host stand-in of the STM32F1 LL drivers.
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "stm32f1xx.h"
+
+GPIO_TypeDef HostGPIOA = {0};
+GPIO_TypeDef HostGPIOB = {0};
+GPIO_TypeDef HostGPIOC = {0};
+USART_TypeDef HostUSART1 = {USART_SR_TXE | USART_SR_TC, 0U, 0U, 0U, 0U};
+USART_TypeDef HostUSART2 = {USART_SR_TXE | USART_SR_TC, 0U, 0U, 0U, 0U};
+SPI_TypeDef HostSPI1 = {0};
+SPI_TypeDef HostSPI2 = {0};
+I2C_TypeDef HostI2C1 = {0};
+TIM_TypeDef HostTIM1 = {0};
+TIM_TypeDef HostTIM2 = {0};
+EXTI_TypeDef HostEXTI = {0};
+DMA_TypeDef HostDMA1 = {0};
@@ -0,0 +1,496 @@
+/*
+ * SimEngine.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Every SimStep advances the virtual clock by 100us. The free-running TIM2
+ * counter follows the clock and its overflow interrupt runs whenever it wraps.
+ * Within a step the engine first runs the interrupt work that is due
+ * (overflow, PPS, UART byte completion) and then a configurable number of
+ * main loop iterations, which mirror the while(1) body of main.c. Received
+ * bytes are moved by the DMA model; only the idle-line and half/full
+ * transfer interrupts reach the firmware.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "SimEngine.h"
+#include "stm32f1xx.h"
+#include "stm32f1xx_ll_dma.h"
+#include "stm32f1xx_ll_exti.h"
+#include "stm32f1xx_ll_gpio.h"
+#include "stm32f1xx_ll_rcc.h"
+#include "stm32f1xx_ll_tim.h"
+#include "stm32f1xx_ll_usart.h"
+#include "TimeMgmt.h"
+#include "Configuration.h"
+#include "Inputs.h"
+#include "UARTBuffer.h"
+#include "EventJournal.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "SensorTrace.h"
+
+//A UART frame is 10 bits (start, 8 data, stop). Baud credit is added every
+//tick, so a byte is done once 10 bits worth of ticks have been accumulated.
+#define UART_BYTE_CREDIT (10U * SIM_TICKS_PER_SECOND)
+#define SIM_RX_QUEUE_SIZE 4096U
+#define SIM_EXTI_LATENCY_1US 2U
+#define SIM_TICK_LENGTH_1US 100U
+//Both ends of a line have to be within this many percent of each other to understand each other.
+#define SIM_BAUDRATE_TOLERANCE_PERCENT 3U
+
+typedef struct
+{
+    USART_TypeDef* usart;
+    uint32_t rxDmaChannel;
+    uint32_t txDmaChannel;
+    uint32_t txCredit;
+    uint8_t txShiftRegister;
+    uint8_t txShifting;
+    uint32_t rxCredit;
+    uint8_t rxQueue[SIM_RX_QUEUE_SIZE];
+    uint16_t rxHead;
+    uint16_t rxTail;
+    uint32_t rxIdleCredit;
+    uint8_t rxIdlePending;
+    uint32_t lineBaudRate; //Rate the other end of the line sends and listens at
+} SimUart;
+
+static SimUart simUarts[SIM_UART_COUNT];
+static uint64_t simTime100us = 0U;
+static SimTxByteCallback txCallback = (SimTxByteCallback)0;
+static SimLoopStats loopStats = {0};
+static SimCounters counters = {0};
+static uint8_t sensorHandlerPending[SimSensorCount] = {0};
+static uint32_t sensorHandlerCounter1us[SimSensorCount] = {0};
+
+static uint64_t GetHostTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+}
+
+void SimInit(uint32_t baudRate)
+{
+    memset(simUarts, 0, sizeof(simUarts));
+    memset(&loopStats, 0, sizeof(loopStats));
+    memset(&counters, 0, sizeof(counters));
+    memset(sensorHandlerPending, 0, sizeof(sensorHandlerPending));
+    simTime100us = 0U;
+
+    simUarts[0].usart = USART1;
+    simUarts[0].rxDmaChannel = LL_DMA_CHANNEL_5;
+    simUarts[0].txDmaChannel = LL_DMA_CHANNEL_4;
+    simUarts[1].usart = USART2;
+    simUarts[1].rxDmaChannel = LL_DMA_CHANNEL_6;
+    simUarts[1].txDmaChannel = LL_DMA_CHANNEL_7;
+    simUarts[0].lineBaudRate = baudRate;
+    simUarts[1].lineBaudRate = baudRate;
+
+    //Mirrors the peripheral setup done by main.c
+    LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_3);
+    LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_8);
+    LL_EXTI_EnableRisingTrig_0_31(LL_EXTI_LINE_11);
+
+    UARTBufferGetUART(0)->uartHandle = USART1;
+    UARTBufferSetBaudRate(UARTBufferGetUART(0), baudRate);
+    UARTBufferStartReception(UARTBufferGetUART(0), LL_DMA_CHANNEL_5);
+    UARTBufferStartTransmission(UARTBufferGetUART(0), LL_DMA_CHANNEL_4);
+    UARTBufferGetUART(1)->uartHandle = USART2;
+    UARTBufferSetBaudRate(UARTBufferGetUART(1), baudRate);
+    UARTBufferStartTransmission(UARTBufferGetUART(1), LL_DMA_CHANNEL_7);
+
+    EventJournalInit();
+    InitInputs();
+    ProfilerInit();
+}
+
+void SimSetJumpers(uint8_t dualSensor, uint8_t opModeJumper)
+{
+    if(dualSensor != 0U)
+    {
+        GPIOB->IDR |= LL_GPIO_PIN_9;
+    }
+    else
+    {
+        GPIOB->IDR &= ~LL_GPIO_PIN_9;
+    }
+
+    if(opModeJumper != 0U)
+    {
+        GPIOB->IDR |= LL_GPIO_PIN_8;
+    }
+    else
+    {
+        GPIOB->IDR &= ~LL_GPIO_PIN_8;
+    }
+}
+
+void SimSetTxCallback(SimTxByteCallback callback)
+{
+    txCallback = callback;
+}
+
+void SimSetLineBaudRate(uint8_t uart, uint32_t baudRate)
+{
+    if(uart < SIM_UART_COUNT)
+    {
+        simUarts[uart].lineBaudRate = baudRate;
+    }
+}
+
+//A free data register raises a DMA request, the channel moves the next byte into it.
+static void RunTxDma(uint8_t index)
+{
+    SimUart* uart = &simUarts[index];
+    DMA_Channel_TypeDef* channel = &DMA1->channel[uart->txDmaChannel];
+
+    if((LL_USART_IsActiveFlag_TXE(uart->usart) == 1U) &&
+       (LL_USART_IsEnabledDMAReq_TX(uart->usart) == 1U) &&
+       (LL_DMA_IsEnabledChannel(DMA1, uart->txDmaChannel) == 1U) &&
+       (channel->CNDTR > 0U))
+    {
+        LL_USART_TransmitData8(uart->usart, ((uint8_t*)channel->CMAR)[channel->dataLength - channel->CNDTR]);
+        channel->CNDTR--;
+        if((channel->CNDTR == 0U) && ((channel->CCR & DMA_CCR_TCIE) != 0U))
+        {
+            //DMA1_ChannelX_IRQHandler -> ProcessUARTTransmitComplete
+            counters.txInterrupts[index]++;
+            UARTBufferProcessTransmitComplete(UARTBufferGetUART(index));
+            SensorTraceTransmitComplete(index);
+        }
+    }
+}
+
+//Rate the firmware programmed into BRR.
+static uint32_t GetUartBaudRate(const SimUart* uart)
+{
+    LL_RCC_ClocksTypeDef clocks;
+    uint32_t periphClk;
+
+    LL_RCC_GetSystemClocksFreq(&clocks);
+    periphClk = clocks.PCLK1_Frequency;
+    if(uart->usart == USART1)
+    {
+        periphClk = clocks.PCLK2_Frequency;
+    }
+    return LL_USART_GetBaudRate(uart->usart, periphClk);
+}
+
+//A byte sent at a rate the receiver does not expect has its bits sampled at the wrong moments.
+static uint8_t CrossLine(const SimUart* uart, uint8_t byte)
+{
+    uint32_t uartBaudRate = GetUartBaudRate(uart);
+    uint32_t difference = (uartBaudRate > uart->lineBaudRate) ?
+                          (uartBaudRate - uart->lineBaudRate) : (uart->lineBaudRate - uartBaudRate);
+    uint8_t retVal = byte;
+
+    if((difference * 100U) > (uart->lineBaudRate * SIM_BAUDRATE_TOLERANCE_PERCENT))
+    {
+        retVal = (uint8_t)((byte >> 1) | 0x80U);
+    }
+
+    return retVal;
+}
+
+//Above 100000 baud more than one byte fits in a step.
+static void RunUartTx(uint8_t index)
+{
+    SimUart* uart = &simUarts[index];
+    uint8_t byteDone = 1U;
+
+    if(uart->txShifting != 0U)
+    {
+        uart->txCredit += GetUartBaudRate(uart);
+    }
+
+    while(byteDone == 1U)
+    {
+        byteDone = 0U;
+        if((uart->txShifting != 0U) && (uart->txCredit >= UART_BYTE_CREDIT))
+        {
+            uart->txCredit -= UART_BYTE_CREDIT;
+            uart->txShifting = 0U;
+            byteDone = 1U;
+            counters.txBytes[index]++;
+            if(txCallback != (SimTxByteCallback)0)
+            {
+                txCallback(index, CrossLine(uart, uart->txShiftRegister));
+            }
+        }
+
+        if((uart->txShifting == 0U) && (LL_USART_IsActiveFlag_TXE(uart->usart) == 0U))
+        {
+            uart->txShiftRegister = (uint8_t)uart->usart->DR;
+            uart->txShifting = 1U;
+            uart->usart->SR |= USART_SR_TXE;
+        }
+        else if(uart->txShifting == 0U)
+        {
+            uart->txCredit = 0U;
+            //TC is set as the last byte leaves, the firmware clears it before the next transfer.
+            if(byteDone == 1U)
+            {
+                uart->usart->SR |= USART_SR_TC;
+            }
+        }
+
+        RunTxDma(index);
+    }
+}
+
+//USARTx_IRQHandler and DMA1_ChannelX_IRQHandler -> ProcessUARTReception
+static void RunRxInterrupt(uint8_t index)
+{
+    counters.rxInterrupts[index]++;
+    UARTBufferProcessReceivedData(UARTBufferGetUART(index));
+}
+
+static void RunRxDma(uint8_t index, uint8_t byte)
+{
+    SimUart* uart = &simUarts[index];
+    DMA_Channel_TypeDef* channel = &DMA1->channel[uart->rxDmaChannel];
+
+    if((LL_USART_IsEnabledDMAReq_RX(uart->usart) == 1U) &&
+       (LL_DMA_IsEnabledChannel(DMA1, uart->rxDmaChannel) == 1U) &&
+       (channel->CNDTR > 0U))
+    {
+        uint32_t length = channel->dataLength;
+        ((uint8_t*)channel->CMAR)[length - channel->CNDTR] = byte;
+        channel->CNDTR--;
+        counters.rxBytes[index]++;
+
+        if((channel->CNDTR == (length / 2U)) && ((channel->CCR & DMA_CCR_HTIE) != 0U))
+        {
+            RunRxInterrupt(index);
+        }
+        if(channel->CNDTR == 0U)
+        {
+            if((channel->CCR & DMA_CCR_CIRC) != 0U)
+            {
+                channel->CNDTR = length;
+            }
+            if((channel->CCR & DMA_CCR_TCIE) != 0U)
+            {
+                RunRxInterrupt(index);
+            }
+        }
+    }
+    else
+    {
+        //Nothing picks the byte up.
+        counters.rxOverruns[index]++;
+    }
+}
+
+static void RunUartRx(uint8_t index)
+{
+    SimUart* uart = &simUarts[index];
+
+    if(uart->rxHead != uart->rxTail)
+    {
+        uart->rxCredit += uart->lineBaudRate;
+        while((uart->rxCredit >= UART_BYTE_CREDIT) && (uart->rxHead != uart->rxTail))
+        {
+            uart->rxCredit -= UART_BYTE_CREDIT;
+            RunRxDma(index, CrossLine(uart, uart->rxQueue[uart->rxTail]));
+            uart->rxTail = (uint16_t)((uart->rxTail + 1U) % SIM_RX_QUEUE_SIZE);
+            uart->rxIdlePending = 1U;
+            uart->rxIdleCredit = 0U;
+        }
+    }
+    else
+    {
+        uart->rxCredit = 0U;
+
+        //The line counts as idle once a whole frame time passed without a start bit.
+        if(uart->rxIdlePending != 0U)
+        {
+            uart->rxIdleCredit += GetUartBaudRate(uart);
+            if(uart->rxIdleCredit >= UART_BYTE_CREDIT)
+            {
+                uart->rxIdlePending = 0U;
+                uart->usart->SR |= USART_SR_IDLE;
+                if(LL_USART_IsEnabledIT_IDLE(uart->usart) == 1U)
+                {
+                    LL_USART_ClearFlag_IDLE(uart->usart);
+                    RunRxInterrupt(index);
+                }
+            }
+        }
+    }
+}
+
+uint8_t SimUartInject(uint8_t uart, const uint8_t* data, uint16_t length)
+{
+    uint8_t retVal = 0U;
+    if(uart < SIM_UART_COUNT)
+    {
+        SimUart* simUart = &simUarts[uart];
+        uint16_t index;
+        retVal = 1U;
+        for(index = 0U; index < length; index++)
+        {
+            uint16_t nextHead = (uint16_t)((simUart->rxHead + 1U) % SIM_RX_QUEUE_SIZE);
+            if(nextHead == simUart->rxTail)
+            {
+                retVal = 0U;
+                break;
+            }
+            simUart->rxQueue[simUart->rxHead] = data[index];
+            simUart->rxHead = nextHead;
+        }
+    }
+    return retVal;
+}
+
+static uint32_t GetCounter1us(void)
+{
+    return (uint32_t)((simTime100us * SIM_TICK_LENGTH_1US) % TIMERPERIOD1US);
+}
+
+static void RunSensorHandler(SimSensor sensor, uint32_t counter1us)
+{
+    uint32_t line = (sensor == SimSensorStartStop) ? LL_EXTI_LINE_8 : LL_EXTI_LINE_11;
+
+    TIM1->CNT = counter1us;
+    TIM2->CNT = counter1us;
+    if(sensor == SimSensorStartStop)
+    {
+        HandleStartStopSensorTrigger();
+    }
+    else
+    {
+        HandleStopSensorTrigger();
+    }
+    LL_EXTI_ClearFlag_0_31(line);
+}
+
+void SimTriggerSensor(SimSensor sensor, uint8_t tickOffset1us)
+{
+    uint32_t line = (sensor == SimSensorStartStop) ? LL_EXTI_LINE_8 : LL_EXTI_LINE_11;
+
+    if((sensor < SimSensorCount) && (tickOffset1us < SIM_TICK_LENGTH_1US))
+    {
+        uint32_t edge1us = GetCounter1us() + tickOffset1us;
+        counters.triggers[sensor]++;
+
+        //The capture unit latches the edge, the EXTI handler runs a little later.
+        if(sensor == SimSensorStartStop)
+        {
+            TIM1->CCR1 = edge1us;
+            TIM1->SR |= TIM_SR_CC1IF;
+        }
+        else
+        {
+            TIM2->CCR4 = edge1us;
+            TIM2->SR |= TIM_SR_CC4IF;
+        }
+
+        //An edge on a line with the rising trigger disabled is never latched.
+        if(LL_EXTI_IsEnabledRisingTrig_0_31(line) == 1U)
+        {
+            uint32_t counter1us = edge1us + SIM_EXTI_LATENCY_1US;
+            EXTI->PR |= line;
+            if(counter1us < TIMERPERIOD1US)
+            {
+                RunSensorHandler(sensor, counter1us);
+            }
+            else
+            {
+                //TIM2 has the higher priority, the handler runs after the overflow.
+                sensorHandlerPending[sensor] = 1U;
+                sensorHandlerCounter1us[sensor] = counter1us - TIMERPERIOD1US;
+            }
+        }
+        else
+        {
+            counters.maskedTriggers[sensor]++;
+        }
+    }
+}
+
+void SimRunMainLoopIteration(void)
+{
+    RunScheduler();
+}
+
+//WFI returns right away, the engine runs the next iteration or step.
+void HostWaitForInterrupt(void)
+{
+    counters.sleeps++;
+}
+
+void SimStep(uint32_t mainLoopIterations)
+{
+    uint8_t index;
+    uint32_t iteration;
+    uint32_t counter1us;
+
+    simTime100us++;
+    counter1us = GetCounter1us();
+    TIM1->CNT = counter1us;
+    TIM2->CNT = counter1us;
+    if(counter1us == 0U)
+    {
+        counters.timerInterrupts++;
+        HandleTimerOverflow();
+    }
+
+    //The DS3231 delivers its 1Hz square wave once it has been configured.
+    if(((simTime100us % SIM_TICKS_PER_SECOND) == 0U) &&
+       (RTCInitSuccesful() == 1U) &&
+       (LL_EXTI_IsEnabledRisingTrig_0_31(LL_EXTI_LINE_3) == 1U))
+    {
+        TIM2->CCR2 = counter1us;
+        TIM2->SR |= TIM_SR_CC2IF;
+        HandlePpsPulse();
+    }
+
+    for(index = 0U; index < (uint8_t)SimSensorCount; index++)
+    {
+        if(sensorHandlerPending[index] != 0U)
+        {
+            sensorHandlerPending[index] = 0U;
+            RunSensorHandler((SimSensor)index, sensorHandlerCounter1us[index]);
+        }
+    }
+
+    for(index = 0U; index < SIM_UART_COUNT; index++)
+    {
+        RunUartTx(index);
+        RunUartRx(index);
+    }
+
+    for(iteration = 0U; iteration < mainLoopIterations; iteration++)
+    {
+        uint64_t start = GetHostTimeNs();
+        SimRunMainLoopIteration();
+        uint64_t duration = GetHostTimeNs() - start;
+
+        loopStats.iterations++;
+        loopStats.totalNs += duration;
+        if(duration > loopStats.maxNs)
+        {
+            loopStats.maxNs = duration;
+        }
+    }
+}
+
+uint64_t SimGetTime100us(void)
+{
+    return simTime100us;
+}
+
+void SimGetLoopStats(SimLoopStats* stats)
+{
+    (*stats) = loopStats;
+}
+
+void SimGetCounters(SimCounters* simCounters)
+{
+    (*simCounters) = counters;
+}
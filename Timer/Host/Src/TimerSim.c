@@ -0,0 +1,575 @@
+/*
+ * TimerSim.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ * Command line front end for the host simulation engine. Generates race
+ * traffic for one of the operation modes, plays the central unit on USART1
+ * and reports main loop cost and sensor-to-UART latency.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SimEngine.h"
+#include "Configuration.h"
+#include "CommunicationManager.h"
+#include "MGBTCommProto.h"
+#include "SensorEventQueue.h"
+#include "Scheduler.h"
+
+#define MAXSIMRIDERS 16U
+#define FRAMEHEADERLENGTH 8U
+#define WARMUPTIME (3U * SIM_TICKS_PER_SECOND)
+#define RESPONSETIMEOUT (750U * SIM_TICKS_PER_MS)
+
+typedef enum
+{
+    SimModeLaptimer = 0U,
+    SimModeSingleRun = 1U,
+    SimModeMultiRun = 2U,
+    SimModeConnected = 3U
+} SimMode;
+
+typedef struct
+{
+    SimMode mode;
+    uint64_t durationTicks;
+    uint32_t lapTicks;
+    uint32_t intervalTicks;
+    uint32_t jitterTicks;
+    uint32_t loopsPerTick;
+    uint32_t baudRate;
+    uint32_t seed;
+    uint32_t minSamples;
+    uint32_t maxErrorUs;
+} SimScenario;
+
+typedef struct
+{
+    uint64_t pendingTrigger[SimSensorCount];
+    uint64_t pendingTrigger1us[SimSensorCount];
+    uint8_t triggerPending[SimSensorCount];
+    uint32_t unreported[SimSensorCount];
+    uint32_t samples;
+    uint64_t totalLatency;
+    uint64_t minLatency;
+    uint64_t maxLatency;
+    uint32_t frames;
+    uint32_t timeFrames;
+    uint8_t referenceSet;
+    uint64_t referenceOffset1us;
+    uint32_t maxError1us;
+} LatencyStats;
+
+static SimScenario scenario =
+{
+    SimModeMultiRun,
+    3600U * SIM_TICKS_PER_SECOND,
+    35U * SIM_TICKS_PER_SECOND,
+    15U * SIM_TICKS_PER_SECOND,
+    3U * SIM_TICKS_PER_SECOND,
+    4U,
+    SIM_DEFAULT_BAUDRATE,
+    1U,
+    0U,
+    0xFFFFFFFFU
+};
+
+static LatencyStats latency = {0};
+static uint8_t frameBuffer[FRAMEHEADERLENGTH + COMMANDDATAMAXSIZE];
+static uint16_t framePosition = 0U;
+static uint32_t randomState = 1U;
+static uint8_t modeCommandAcknowledged = 0U;
+
+static uint32_t NextRandom(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static uint32_t Jitter(uint32_t value)
+{
+    uint32_t retVal = value;
+    if(scenario.jitterTicks > 0U)
+    {
+        retVal = (value - scenario.jitterTicks) + (NextRandom() % ((2U * scenario.jitterTicks) + 1U));
+    }
+    return retVal;
+}
+
+//Same ThingMagic-style CRC the central unit uses in CommandData.cs
+static uint16_t CentralUnitCRC(const uint8_t* data, uint16_t length)
+{
+    static const uint16_t table[16] =
+    {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+        0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+    };
+    uint16_t crc = 0xFFFFU;
+    uint16_t index;
+
+    for(index = 0U; index < length; index++)
+    {
+        crc = (uint16_t)(((crc << 4) | (data[index] >> 4)) ^ table[crc >> 12]);
+        crc = (uint16_t)(((crc << 4) | (data[index] & 0x0FU)) ^ table[crc >> 12]);
+    }
+
+    return crc;
+}
+
+static void SendCentralUnitCommand(uint16_t cmdType, const uint8_t* data, uint8_t length)
+{
+    uint8_t frame[FRAMEHEADERLENGTH + 1U + COMMANDDATAMAXSIZE] = {0};
+    uint16_t crc;
+
+    frame[0] = 0xFFU;
+    frame[1] = length;
+    frame[2] = 0U;
+    frame[7] = (uint8_t)(cmdType & 0xFFU);
+    frame[8] = (uint8_t)(cmdType >> 8);
+    memcpy(&frame[9], data, length);
+    crc = CentralUnitCRC(&frame[5], (uint16_t)(length + 4U));
+    frame[3] = (uint8_t)(crc & 0xFFU);
+    frame[4] = (uint8_t)(crc >> 8);
+
+    SimUartInject(0U, frame, (uint16_t)(FRAMEHEADERLENGTH + 1U + length));
+}
+
+static SimSensor GetReportingSensor(CommTimeType type)
+{
+    SimSensor retVal = SimSensorStop;
+    if((type == StartSensorTimeStamp) ||
+       ((type == LastLapTime) && (scenario.mode == SimModeLaptimer)))
+    {
+        retVal = SimSensorStartStop;
+    }
+    return retVal;
+}
+
+//In the local timer modes only the trigger that finishes a lap is reported.
+static uint8_t IsReportingSensor(SimSensor sensor)
+{
+    uint8_t retVal = 1U;
+    if(scenario.mode == SimModeLaptimer)
+    {
+        retVal = (sensor == SimSensorStartStop) ? 1U : 0U;
+    }
+    else if(scenario.mode != SimModeConnected)
+    {
+        retVal = (sensor == SimSensorStop) ? 1U : 0U;
+    }
+    return retVal;
+}
+
+static void RecordTrigger(SimSensor sensor)
+{
+    uint8_t tickOffset1us = (uint8_t)(NextRandom() % 100U);
+
+    if(IsReportingSensor(sensor) == 1U)
+    {
+        if(latency.triggerPending[sensor] != 0U)
+        {
+            latency.unreported[sensor]++;
+        }
+        latency.pendingTrigger[sensor] = SimGetTime100us();
+        latency.pendingTrigger1us[sensor] = (SimGetTime100us() * 100U) + tickOffset1us;
+        latency.triggerPending[sensor] = 1U;
+    }
+    SimTriggerSensor(sensor, tickOffset1us);
+}
+
+//The connected mode reports microseconds since the first PPS pulse, so every reported time
+//should be the same fixed distance from the simulated trigger time.
+static void RecordTimestampError(uint64_t reported1us, uint64_t trigger1us)
+{
+    uint64_t offset1us = reported1us - trigger1us;
+    uint64_t error1us;
+
+    if(latency.referenceSet == 0U)
+    {
+        latency.referenceSet = 1U;
+        latency.referenceOffset1us = offset1us;
+    }
+
+    error1us = offset1us - latency.referenceOffset1us;
+    if((int64_t)error1us < 0)
+    {
+        error1us = (uint64_t)(-(int64_t)error1us);
+    }
+    if(error1us > latency.maxError1us)
+    {
+        latency.maxError1us = (error1us > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)error1us;
+    }
+}
+
+static void ProcessFirmwareFrame(void)
+{
+    uint16_t cmdType = (uint16_t)(frameBuffer[6] | (frameBuffer[7] << 8));
+    uint16_t dataLength = (uint16_t)(frameBuffer[0] | (frameBuffer[1] << 8));
+
+    latency.frames++;
+    if(cmdType == UpdateOpMode)
+    {
+        modeCommandAcknowledged = 1U;
+    }
+    else if((cmdType == GetLatestTimeStamp) && (dataLength >= 5U))
+    {
+        SimSensor sensor = GetReportingSensor((CommTimeType)frameBuffer[FRAMEHEADERLENGTH + 4U]);
+        latency.timeFrames++;
+        if(latency.triggerPending[sensor] != 0U)
+        {
+            uint64_t delay = SimGetTime100us() - latency.pendingTrigger[sensor];
+            latency.triggerPending[sensor] = 0U;
+            if(scenario.mode == SimModeConnected)
+            {
+                uint64_t reported1us = 0U;
+                uint8_t index;
+                //Prefer the full 64 bit value that follows the type byte, fall back to the wrapping 32 bit one.
+                if(dataLength >= 13U)
+                {
+                    for(index = 0U; index < 8U; index++)
+                    {
+                        reported1us |= (uint64_t)frameBuffer[FRAMEHEADERLENGTH + 5U + index] << (8U * index);
+                    }
+                }
+                else
+                {
+                    for(index = 0U; index < 4U; index++)
+                    {
+                        reported1us |= (uint64_t)frameBuffer[FRAMEHEADERLENGTH + index] << (8U * index);
+                    }
+                }
+                RecordTimestampError(reported1us, latency.pendingTrigger1us[sensor]);
+            }
+            latency.samples++;
+            latency.totalLatency += delay;
+            if((latency.samples == 1U) || (delay < latency.minLatency))
+            {
+                latency.minLatency = delay;
+            }
+            if(delay > latency.maxLatency)
+            {
+                latency.maxLatency = delay;
+            }
+        }
+    }
+}
+
+static void OnTxByte(uint8_t uart, uint8_t byte)
+{
+    if(uart == 0U)
+    {
+        if(framePosition < sizeof(frameBuffer))
+        {
+            frameBuffer[framePosition] = byte;
+        }
+        framePosition++;
+
+        if(framePosition >= FRAMEHEADERLENGTH)
+        {
+            uint16_t dataLength = (uint16_t)(frameBuffer[0] | (frameBuffer[1] << 8));
+            if(framePosition >= (FRAMEHEADERLENGTH + dataLength))
+            {
+                ProcessFirmwareFrame();
+                framePosition = 0U;
+            }
+        }
+    }
+}
+
+static void ConfigureJumpers(void)
+{
+    switch(scenario.mode)
+    {
+        case SimModeLaptimer:
+        {
+            SimSetJumpers(0U, 0U);
+            break;
+        }
+        case SimModeSingleRun:
+        {
+            SimSetJumpers(1U, 1U);
+            break;
+        }
+        default:
+        {
+            SimSetJumpers(1U, 0U);
+            break;
+        }
+    }
+}
+
+static void RunScenario(void)
+{
+    uint64_t finishTimes[MAXSIMRIDERS] = {0};
+    uint64_t nextStart = WARMUPTIME;
+    uint64_t modeCommandSent = 0U;
+
+    while(SimGetTime100us() < scenario.durationTicks)
+    {
+        uint64_t now = SimGetTime100us();
+        uint8_t rider;
+
+        //Like the central unit, retry the command when no response arrives in time.
+        if((scenario.mode == SimModeConnected) && (modeCommandAcknowledged == 0U) &&
+           (autoConfigurationDone == 1U) && ((modeCommandSent == 0U) || ((now - modeCommandSent) > RESPONSETIMEOUT)))
+        {
+            uint8_t newMode = (uint8_t)ConnectedTimestampCollector;
+            SendCentralUnitCommand(UpdateOpMode, &newMode, 1U);
+            modeCommandSent = now;
+        }
+
+        if(now == nextStart)
+        {
+            RecordTrigger(SimSensorStartStop);
+            switch(scenario.mode)
+            {
+                case SimModeLaptimer:
+                {
+                    nextStart = now + Jitter(scenario.lapTicks);
+                    break;
+                }
+                case SimModeSingleRun:
+                {
+                    finishTimes[0] = now + Jitter(scenario.lapTicks);
+                    nextStart = finishTimes[0] + scenario.intervalTicks;
+                    break;
+                }
+                default:
+                {
+                    for(rider = 0U; rider < MAXSIMRIDERS; rider++)
+                    {
+                        if(finishTimes[rider] == 0U)
+                        {
+                            finishTimes[rider] = now + Jitter(scenario.lapTicks);
+                            break;
+                        }
+                    }
+                    nextStart = now + scenario.intervalTicks;
+                    break;
+                }
+            }
+        }
+
+        for(rider = 0U; rider < MAXSIMRIDERS; rider++)
+        {
+            if((finishTimes[rider] != 0U) && (finishTimes[rider] == now))
+            {
+                finishTimes[rider] = 0U;
+                RecordTrigger(SimSensorStop);
+            }
+        }
+
+        SimStep(scenario.loopsPerTick);
+    }
+}
+
+static void PrintReport(double wallSeconds)
+{
+    static const char* const taskNames[NbOfSchedulerTasks] =
+    {
+        "Inputs", "EventJournal", "StatusOutputs", "RaceTiming", "Communication", "Display"
+    };
+    SimLoopStats loops;
+    SimCounters counters;
+    uint8_t task;
+    double simSeconds = (double)scenario.durationTicks / SIM_TICKS_PER_SECOND;
+
+    SimGetLoopStats(&loops);
+    SimGetCounters(&counters);
+
+    printf("Simulated %.0f s in %.2f s wall time (%.0fx)\n", simSeconds, wallSeconds,
+           (wallSeconds > 0.0) ? (simSeconds / wallSeconds) : 0.0);
+    printf("Main loop: %llu iterations, avg %.1f ns, max %llu ns\n",
+           (unsigned long long)loops.iterations,
+           (loops.iterations > 0U) ? ((double)loops.totalNs / (double)loops.iterations) : 0.0,
+           (unsigned long long)loops.maxNs);
+    printf("Scheduler: %llu of the iterations slept, idle %u%%\n",
+           (unsigned long long)counters.sleeps, SchedulerGetIdlePercent());
+    for(task = 0U; task < NbOfSchedulerTasks; task++)
+    {
+        SchedulerTaskStats stats;
+        SchedulerGetTaskStats((SchedulerTask)task, &stats);
+        printf("  %-14s %u runs, max lateness %.1f ms, %u deadline misses\n", taskNames[task],
+               stats.runCount, (double)stats.maxLateness1us / 1000.0, stats.deadlineMisses);
+    }
+    printf("Timer interrupts: %llu (%.1f per second)\n", (unsigned long long)counters.timerInterrupts,
+           (double)counters.timerInterrupts / simSeconds);
+    printf("Sensor triggers: start/stop %u (masked %u), stop %u (masked %u)\n",
+           counters.triggers[SimSensorStartStop], counters.maskedTriggers[SimSensorStartStop],
+           counters.triggers[SimSensorStop], counters.maskedTriggers[SimSensorStop]);
+    printf("UART1: %llu bytes out (%llu tx interrupts), %llu bytes in (%llu rx interrupts), %u overruns; %u frames, %u time frames\n",
+           (unsigned long long)counters.txBytes[0], (unsigned long long)counters.txInterrupts[0],
+           (unsigned long long)counters.rxBytes[0], (unsigned long long)counters.rxInterrupts[0],
+           counters.rxOverruns[0], latency.frames, latency.timeFrames);
+    printf("Unreported triggers: start/stop %u, stop %u\n",
+           latency.unreported[SimSensorStartStop], latency.unreported[SimSensorStop]);
+    printf("Sensor queue overflows: start/stop %u, stop %u\n",
+           SensorEventQueueGetOverflowCount(SensorInputStartStop), SensorEventQueueGetOverflowCount(SensorInputStop));
+    if(latency.samples > 0U)
+    {
+        printf("Sensor-to-UART latency: %u samples, min %.1f ms, avg %.1f ms, max %.1f ms\n",
+               latency.samples,
+               (double)latency.minLatency / SIM_TICKS_PER_MS,
+               ((double)latency.totalLatency / latency.samples) / SIM_TICKS_PER_MS,
+               (double)latency.maxLatency / SIM_TICKS_PER_MS);
+    }
+    if(latency.referenceSet != 0U)
+    {
+        printf("Reported timestamp error: max %u us\n", latency.maxError1us);
+    }
+}
+
+static uint8_t ParseMode(const char* name)
+{
+    uint8_t retVal = 1U;
+    if(strcmp(name, "laptimer") == 0)
+    {
+        scenario.mode = SimModeLaptimer;
+    }
+    else if(strcmp(name, "singlerun") == 0)
+    {
+        scenario.mode = SimModeSingleRun;
+    }
+    else if(strcmp(name, "multirun") == 0)
+    {
+        scenario.mode = SimModeMultiRun;
+    }
+    else if(strcmp(name, "connected") == 0)
+    {
+        scenario.mode = SimModeConnected;
+    }
+    else
+    {
+        retVal = 0U;
+    }
+    return retVal;
+}
+
+static void PrintUsage(const char* name)
+{
+    printf("Usage: %s [options]\n", name);
+    printf("  --mode laptimer|singlerun|multirun|connected  (default multirun)\n");
+    printf("  --minutes N        simulated duration (default 60)\n");
+    printf("  --lap-ms N         nominal run or lap duration (default 35000)\n");
+    printf("  --interval-ms N    start interval or gap between runs (default 15000)\n");
+    printf("  --jitter-ms N      random variation on lap durations (default 3000)\n");
+    printf("  --loops-per-tick N main loop iterations per 100us tick (default 4)\n");
+    printf("  --baud N           UART baud rate (default 115200)\n");
+    printf("  --seed N           random seed (default 1)\n");
+    printf("  --min-samples N    exit with an error when fewer latency samples were taken\n");
+    printf("  --max-error-us N   exit with an error when a reported time is off by more than N us\n");
+}
+
+static uint8_t ParseArguments(int argc, char** argv)
+{
+    uint8_t retVal = 1U;
+    int index;
+
+    for(index = 1; (index < argc) && (retVal == 1U); index++)
+    {
+        const char* option = argv[index];
+        const char* value = (index + 1 < argc) ? argv[index + 1] : (const char*)0;
+        uint32_t number = (value != (const char*)0) ? (uint32_t)strtoul(value, (char**)0, 10) : 0U;
+
+        if(value == (const char*)0)
+        {
+            retVal = 0U;
+        }
+        else if(strcmp(option, "--mode") == 0)
+        {
+            retVal = ParseMode(value);
+        }
+        else if(strcmp(option, "--minutes") == 0)
+        {
+            scenario.durationTicks = (uint64_t)number * 60U * SIM_TICKS_PER_SECOND;
+        }
+        else if(strcmp(option, "--lap-ms") == 0)
+        {
+            scenario.lapTicks = number * SIM_TICKS_PER_MS;
+        }
+        else if(strcmp(option, "--interval-ms") == 0)
+        {
+            scenario.intervalTicks = number * SIM_TICKS_PER_MS;
+        }
+        else if(strcmp(option, "--jitter-ms") == 0)
+        {
+            scenario.jitterTicks = number * SIM_TICKS_PER_MS;
+        }
+        else if(strcmp(option, "--loops-per-tick") == 0)
+        {
+            scenario.loopsPerTick = number;
+        }
+        else if(strcmp(option, "--baud") == 0)
+        {
+            scenario.baudRate = number;
+        }
+        else if(strcmp(option, "--seed") == 0)
+        {
+            scenario.seed = number;
+        }
+        else if(strcmp(option, "--min-samples") == 0)
+        {
+            scenario.minSamples = number;
+        }
+        else if(strcmp(option, "--max-error-us") == 0)
+        {
+            scenario.maxErrorUs = number;
+        }
+        else
+        {
+            retVal = 0U;
+        }
+        index++;
+    }
+
+    if((scenario.jitterTicks >= scenario.lapTicks) || (scenario.seed == 0U) || (scenario.baudRate == 0U))
+    {
+        retVal = 0U;
+    }
+
+    return retVal;
+}
+
+int main(int argc, char** argv)
+{
+    struct timespec start;
+    struct timespec end;
+    int retVal = 0;
+
+    if(ParseArguments(argc, argv) == 0U)
+    {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    randomState = scenario.seed;
+    SimInit(scenario.baudRate);
+    SimSetTxCallback(OnTxByte);
+    ConfigureJumpers();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    RunScenario();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    PrintReport((double)(end.tv_sec - start.tv_sec) + ((double)(end.tv_nsec - start.tv_nsec) / 1e9));
+
+    if(latency.samples < scenario.minSamples)
+    {
+        printf("Expected at least %u latency samples\n", scenario.minSamples);
+        retVal = 1;
+    }
+
+    if(latency.maxError1us > scenario.maxErrorUs)
+    {
+        printf("Expected reported times within %u us\n", scenario.maxErrorUs);
+        retVal = 1;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,117 @@
+/*
+ * EventBusTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Publishes events for several subscribers. Checks that each one reads
+ *  them in order through its own cursor, only gets the types it subscribed
+ *  to and that only the events it wanted count as dropped when it falls
+ *  behind a full bus.
+ */
+
+#include <stdint.h>
+
+#include "TestHelpers.h"
+#include "EventBus.h"
+
+static void DrainAll(void)
+{
+    BusEvent event;
+    uint8_t subscriber;
+
+    for(subscriber = 0U; subscriber < NbOfEventSubscribers; subscriber++)
+    {
+        while(EventBusGet((EventSubscriber)subscriber, &event) == 1U)
+        {
+        }
+    }
+}
+
+static void TestOrderAndCursors(void)
+{
+    BusEvent event;
+
+    EventBusPublish(EventLapFinished, 3U);
+    EventBusPublish(EventPpsTick, 1U);
+    EventBusPublish(EventRunStarted, 4U);
+
+    //Reading as one subscriber leaves the events for the others.
+    CHECK_EQUAL(1U, EventBusGet(SubscriberRaceTiming, &event));
+    CHECK_EQUAL(EventLapFinished, event.type);
+    CHECK_EQUAL(3U, event.value);
+    CHECK_EQUAL(1U, EventBusGet(SubscriberRaceTiming, &event));
+    CHECK_EQUAL(EventRunStarted, event.type);
+    CHECK_EQUAL(4U, event.value);
+    CHECK_EQUAL(0U, EventBusGet(SubscriberRaceTiming, &event));
+
+    CHECK_EQUAL(1U, EventBusGet(SubscriberCommunication, &event));
+    CHECK_EQUAL(EventLapFinished, event.type);
+    CHECK_EQUAL(3U, event.value);
+    CHECK_EQUAL(0U, EventBusGet(SubscriberCommunication, &event));
+
+    CHECK_EQUAL(1U, EventBusGet(SubscriberStatusLed, &event));
+    CHECK_EQUAL(EventPpsTick, event.type);
+    CHECK_EQUAL(0U, EventBusGet(SubscriberStatusLed, &event));
+
+    //New events after the cursor caught up.
+    EventBusPublish(EventNewConfig, 2U);
+    CHECK_EQUAL(1U, EventBusGet(SubscriberRaceTiming, &event));
+    CHECK_EQUAL(EventNewConfig, event.type);
+    CHECK_EQUAL(2U, event.value);
+    CHECK_EQUAL(0U, EventBusGet(SubscriberCommunication, &event));
+}
+
+static void TestOverflow(void)
+{
+    BusEvent event;
+    uint32_t index;
+
+    DrainAll();
+    //The status LED falls behind on PPS ticks while the others keep up with the laps.
+    for(index = 0U; index < (2U * EVENTBUSLENGTH); index++)
+    {
+        EventBusPublish(EventPpsTick, index);
+        EventBusPublish(EventLapFinished, index);
+        while(EventBusGet(SubscriberRaceTiming, &event) == 1U)
+        {
+            CHECK_EQUAL(EventLapFinished, event.type);
+            CHECK_EQUAL(index, event.value);
+        }
+        while(EventBusGet(SubscriberCommunication, &event) == 1U)
+        {
+            CHECK_EQUAL(index, event.value);
+        }
+    }
+    CHECK_EQUAL(0U, EventBusGetDropCount(SubscriberRaceTiming));
+    CHECK_EQUAL(0U, EventBusGetDropCount(SubscriberCommunication));
+
+    //Only the newest half of the ticks is left, the rest counts as dropped.
+    CHECK_EQUAL(EVENTBUSLENGTH + (EVENTBUSLENGTH / 2U), EventBusGetDropCount(SubscriberStatusLed));
+    for(index = EVENTBUSLENGTH + (EVENTBUSLENGTH / 2U); index < (2U * EVENTBUSLENGTH); index++)
+    {
+        CHECK_EQUAL(1U, EventBusGet(SubscriberStatusLed, &event));
+        CHECK_EQUAL(EventPpsTick, event.type);
+        CHECK_EQUAL(index, event.value);
+    }
+    CHECK_EQUAL(0U, EventBusGet(SubscriberStatusLed, &event));
+
+    //Unread events of other types are passed over without counting.
+    for(index = 0U; index < (2U * EVENTBUSLENGTH); index++)
+    {
+        EventBusPublish(EventDisplayTime, index);
+    }
+    CHECK_EQUAL(EVENTBUSLENGTH + (EVENTBUSLENGTH / 2U), EventBusGetDropCount(SubscriberStatusLed));
+    CHECK_EQUAL(0U, EventBusGetDropCount(SubscriberCommunication));
+    CHECK_EQUAL(EVENTBUSLENGTH, EventBusGetDropCount(SubscriberRaceTiming));
+    CHECK_EQUAL(0U, EventBusGet(SubscriberStatusLed, &event));
+    CHECK_EQUAL(1U, EventBusGet(SubscriberRaceTiming, &event));
+    CHECK_EQUAL(EVENTBUSLENGTH, event.value);
+}
+
+int main(void)
+{
+    TestOrderAndCursors();
+    TestOverflow();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,209 @@
+/*
+ * EventJournalTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Runs the event journal on the simulated flash. Fills it many times over
+ *  and checks that the erases are spread evenly over the pages and what the
+ *  flash time per event is. Restarts it after resets, also ones that cut
+ *  the power halfway a record or a page erase, and checks that no written
+ *  event is lost and the numbering carries on.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "TestHelpers.h"
+#include "HostFlash.h"
+#include "EventJournal.h"
+
+#define JOURNALCAPACITY (EVENTJOURNALRECORDSPERPAGE * FLASHPORTPAGECOUNT)
+#define WEARROUNDS 10U
+//Journal writes must fit easily between two sensor triggers.
+#define MAXFLASHTIMEPEREVENT1US 1000U
+
+static Timestamp1us EventTime(uint32_t sequence)
+{
+    return ((Timestamp1us)sequence * 2500000U) + 123U;
+}
+
+static void AppendEvents(uint32_t count)
+{
+    uint32_t index;
+    for(index = 0U; index < count; index++)
+    {
+        uint32_t sequence = EventJournalGetLastSequence() + 1U;
+        CHECK_EQUAL(1U, EventJournalAppend((uint8_t)(sequence % NbOfSensorInputs), EventTime(sequence)));
+    }
+}
+
+//Walks the journal from the oldest event and checks that it runs without gaps up to the newest.
+static uint32_t CheckContiguous(uint32_t expectedOldest)
+{
+    JournalEvent event;
+    uint32_t sequence = 0U;
+    uint32_t count = 0U;
+
+    if(EventJournalFind(0U, &event) == 1U)
+    {
+        CHECK_EQUAL(expectedOldest, event.sequence);
+        sequence = event.sequence;
+        while(EventJournalFind(sequence, &event) == 1U)
+        {
+            CHECK_EQUAL(sequence, event.sequence);
+            CHECK_EQUAL(EventTime(sequence), event.time);
+            CHECK_EQUAL(sequence % NbOfSensorInputs, event.sensor);
+            sequence++;
+            count++;
+        }
+    }
+    CHECK_EQUAL(EventJournalGetLastSequence() + 1U, sequence);
+
+    return count;
+}
+
+static void TestAppendAndFind(void)
+{
+    JournalEvent event;
+
+    HostFlashReset();
+    EventJournalInit();
+    CHECK_EQUAL(0U, EventJournalGetLastSequence());
+    CHECK_EQUAL(0U, EventJournalFind(0U, &event));
+
+    AppendEvents(10U);
+    CHECK_EQUAL(10U, EventJournalGetLastSequence());
+    CHECK_EQUAL(10U, CheckContiguous(1U));
+    CHECK_EQUAL(1U, EventJournalFind(7U, &event));
+    CHECK_EQUAL(7U, event.sequence);
+    CHECK_EQUAL(0U, EventJournalFind(11U, &event));
+}
+
+static void TestWearAndThroughput(void)
+{
+    HostFlashStats stats;
+    uint32_t events = WEARROUNDS * JOURNALCAPACITY;
+    uint32_t erases = (events + EVENTJOURNALRECORDSPERPAGE - 1U) / EVENTJOURNALRECORDSPERPAGE;
+    uint32_t minErases = 0xFFFFFFFFU;
+    uint32_t maxErases = 0U;
+    uint32_t totalErases = 0U;
+    uint32_t retained;
+    uint8_t page;
+
+    HostFlashReset();
+    EventJournalInit();
+    AppendEvents(events);
+    HostFlashGetStats(&stats);
+
+    for(page = 0U; page < FLASHPORTPAGECOUNT; page++)
+    {
+        totalErases += stats.eraseCounts[page];
+        if(stats.eraseCounts[page] < minErases)
+        {
+            minErases = stats.eraseCounts[page];
+        }
+        if(stats.eraseCounts[page] > maxErases)
+        {
+            maxErases = stats.eraseCounts[page];
+        }
+    }
+    CHECK_EQUAL(erases, totalErases);
+    CHECK(maxErases - minErases <= 1U);
+    CHECK_EQUAL(((uint64_t)events * (EVENTJOURNALRECORDLENGTH / 2U)) + ((uint64_t)erases * 2U), stats.programmedHalfWords);
+    CHECK_EQUAL(0U, stats.programErrors);
+    CHECK(stats.busyTime1us <= ((uint64_t)events * MAXFLASHTIMEPEREVENT1US));
+    printf("%u events, %u erases per page, %llu us flash time per event\n",
+           events, maxErases, (unsigned long long)(stats.busyTime1us / events));
+
+    //Everything but the page given up last is still there.
+    retained = CheckContiguous(events - (JOURNALCAPACITY - EVENTJOURNALRECORDSPERPAGE) - ((events - 1U) % EVENTJOURNALRECORDSPERPAGE));
+    CHECK(retained > (JOURNALCAPACITY - EVENTJOURNALRECORDSPERPAGE));
+    CHECK(retained <= JOURNALCAPACITY);
+}
+
+static void TestRestart(void)
+{
+    JournalEvent event;
+
+    HostFlashReset();
+    EventJournalInit();
+    AppendEvents(JOURNALCAPACITY + 20U);
+    EventJournalInit();
+    CHECK_EQUAL(JOURNALCAPACITY + 20U, EventJournalGetLastSequence());
+    AppendEvents(5U);
+    CHECK_EQUAL(JOURNALCAPACITY + 25U, EventJournalGetLastSequence());
+    CHECK_EQUAL(1U, EventJournalFind(JOURNALCAPACITY + 21U, &event));
+    CHECK_EQUAL(JOURNALCAPACITY + 21U, event.sequence);
+    (void)CheckContiguous(EVENTJOURNALRECORDSPERPAGE + 1U);
+}
+
+static void TestPowerCutInRecord(void)
+{
+    HostFlashStats stats;
+
+    HostFlashReset();
+    EventJournalInit();
+    AppendEvents(30U);
+    HostFlashCutPowerAfter(3U);
+    CHECK_EQUAL(0U, EventJournalAppend(0U, EventTime(31U)));
+    HostFlashRestorePower();
+
+    EventJournalInit();
+    CHECK_EQUAL(30U, EventJournalGetLastSequence());
+    AppendEvents(40U);
+    CHECK_EQUAL(70U, CheckContiguous(1U));
+    HostFlashGetStats(&stats);
+    CHECK_EQUAL(0U, stats.programErrors);
+}
+
+static void TestPowerCutInErase(void)
+{
+    HostFlashReset();
+    EventJournalInit();
+    AppendEvents(EVENTJOURNALRECORDSPERPAGE);
+    //The next event needs a fresh page, the power fails after the erase while its header is written.
+    HostFlashCutPowerAfter(1U);
+    CHECK_EQUAL(0U, EventJournalAppend(0U, EventTime(EVENTJOURNALRECORDSPERPAGE + 1U)));
+    HostFlashRestorePower();
+
+    EventJournalInit();
+    CHECK_EQUAL(EVENTJOURNALRECORDSPERPAGE, EventJournalGetLastSequence());
+    AppendEvents(EVENTJOURNALRECORDSPERPAGE);
+    CHECK_EQUAL(2U * EVENTJOURNALRECORDSPERPAGE, CheckContiguous(1U));
+}
+
+static void TestPendingEvents(void)
+{
+    SensorTimestamp timeStamp = {0};
+    JournalEvent event;
+    uint8_t index;
+
+    HostFlashReset();
+    EventJournalInit();
+    for(index = 0U; index <= EVENTJOURNALPENDINGLENGTH; index++)
+    {
+        timeStamp.timeStampPps = index;
+        timeStamp.ppsTime1us = 1000U;
+        timeStamp.time1us = 1250U;
+        EventJournalRecord(SensorInputStop, &timeStamp);
+    }
+    CHECK_EQUAL(0U, EventJournalGetLastSequence());
+    RunEventJournal();
+    CHECK_EQUAL(EVENTJOURNALPENDINGLENGTH, EventJournalGetLastSequence());
+    CHECK_EQUAL(1U, EventJournalGetLostCount());
+    CHECK_EQUAL(1U, EventJournalFind(3U, &event));
+    CHECK_EQUAL(SensorInputStop, event.sensor);
+    CHECK_EQUAL(2000250U, event.time);
+}
+
+int main(void)
+{
+    TestAppendAndFind();
+    TestWearAndThroughput();
+    TestRestart();
+    TestPowerCutInRecord();
+    TestPowerCutInErase();
+    TestPendingEvents();
+
+    return TEST_RESULT();
+}
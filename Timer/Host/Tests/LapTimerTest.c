@@ -0,0 +1,159 @@
+/*
+ * LapTimerTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Feeds sensor triggers to the multi run timer. Keeps riders on the track
+ *  while the lap buffer wraps many times and checks that every lap keeps its
+ *  own times, that riders finish in start order and that starts beyond the
+ *  rider limit are refused instead of overwriting a running lap. The
+ *  finished laps still in the buffer are found in sequence order.
+ */
+
+#include <stdint.h>
+
+#include "TestHelpers.h"
+#include "Configuration.h"
+#include "LapTimer.h"
+#include "SensorEventQueue.h"
+
+#define WRAPLAPS (5U * MAXLAPCOUNT)
+#define RIDERSONTRACK MAXSIMULTANEOUSRIDERS
+
+static Timestamp1us StartTime(uint32_t lap)
+{
+    return ((Timestamp1us)lap * 10000000U) + 1000U;
+}
+
+static Timestamp1us LapDuration(uint32_t lap)
+{
+    return 30000000U + ((Timestamp1us)lap * 1000U);
+}
+
+static void Trigger(SensorInput input, Timestamp1us time)
+{
+    SensorTimestamp timeStamp = {0};
+    timeStamp.timeStampPps = (uint32_t)(time / 1000000U);
+    timeStamp.time1us = (uint32_t)(time % 1000000U);
+    CHECK_EQUAL(1U, SensorEventQueuePush(input, &timeStamp));
+    RunStandAloneTimer();
+}
+
+//A lap prepared by the single run timer holds no rider once the mode changes.
+static void TestSingleRunThenMultiRun(void)
+{
+    operationMode = SingleRunTimerOperation;
+    sensorMode = DualSensor;
+    RunStandAloneTimer();
+    CHECK_EQUAL(0U, GetLapIndex(GetCurrentLap()));
+    Trigger(SensorInputStartStop, StartTime(0U));
+    Trigger(SensorInputStop, StartTime(0U) + LapDuration(0U));
+    CHECK_EQUAL(1U, GetLastLapSequence());
+    CHECK_EQUAL(LapDuration(0U) / 1000U, GetLapDurationMs(GetPreviousLap()));
+    CHECK_EQUAL(1U, GetLapIndex(GetCurrentLap()));
+
+    operationMode = MultiRunTimerOperation;
+    Trigger(SensorInputStartStop, StartTime(1U));
+    CHECK_EQUAL(2U, GetLapIndex(GetLastStartedLap()));
+    CHECK_EQUAL(2U, GetLapIndex(GetCurrentLap()));
+    Trigger(SensorInputStop, StartTime(1U) + LapDuration(1U));
+    CHECK_EQUAL(2U, GetLastLapSequence());
+    CHECK(GetPreviousLap() == &laps[2]);
+    CHECK_EQUAL(0U, GetRejectedStartCount());
+}
+
+static void TestRiderLimit(void)
+{
+    uint32_t first = GetLastLapSequence();
+    uint32_t rider;
+
+    for(rider = 0U; rider <= MAXSIMULTANEOUSRIDERS; rider++)
+    {
+        Trigger(SensorInputStartStop, StartTime(first + rider));
+    }
+    CHECK_EQUAL(1U, GetRejectedStartCount());
+
+    //The refused start did not take a slot, the riders finish in the order they started.
+    for(rider = 0U; rider < MAXSIMULTANEOUSRIDERS; rider++)
+    {
+        Lap* expected = GetCurrentLap();
+        Trigger(SensorInputStop, StartTime(first + rider) + LapDuration(first + rider));
+        CHECK(GetPreviousLap() == expected);
+        CHECK_EQUAL(LapDuration(first + rider) / 1000U, GetLapDurationMs(expected));
+    }
+    CHECK_EQUAL(first + MAXSIMULTANEOUSRIDERS, GetLastLapSequence());
+
+    //A stop without riders on the track finishes nothing.
+    Trigger(SensorInputStop, StartTime(first + MAXSIMULTANEOUSRIDERS));
+    CHECK_EQUAL(first + MAXSIMULTANEOUSRIDERS, GetLastLapSequence());
+}
+
+//Keeps the most riders allowed on the track while the buffer wraps, every finished lap must still hold its own times.
+static void TestWrapWithRidersOnTrack(void)
+{
+    uint32_t first = GetLastLapSequence();
+    uint32_t started = 0U;
+    uint32_t finished = 0U;
+    uint8_t slot = (uint8_t)((GetLapIndex(GetLastStartedLap()) + 1U) % MAXLAPCOUNT);
+
+    while(finished < WRAPLAPS)
+    {
+        if((started < WRAPLAPS) && ((started - finished) < RIDERSONTRACK))
+        {
+            Trigger(SensorInputStartStop, StartTime(first + started));
+            CHECK_EQUAL(slot, GetLapIndex(GetLastStartedLap()));
+            slot = (uint8_t)((slot + 1U) % MAXLAPCOUNT);
+            started++;
+        }
+        else
+        {
+            Lap* lap;
+            Trigger(SensorInputStop, StartTime(first + finished) + LapDuration(first + finished));
+            finished++;
+            lap = GetPreviousLap();
+            CHECK_EQUAL(first + finished, lap->sequence);
+            CHECK_EQUAL(StartTime(first + finished - 1U), lap->startTimeStamp);
+            CHECK_EQUAL(LapDuration(first + finished - 1U) / 1000U, GetLapDurationMs(lap));
+        }
+    }
+
+    CHECK_EQUAL(first + WRAPLAPS, GetLastLapSequence());
+    CHECK_EQUAL(1U, GetRejectedStartCount());
+    //The buffer holds the newest laps, the older ones have been reused.
+    CHECK_EQUAL(first + WRAPLAPS - MAXLAPCOUNT + 1U, GetFinishedLapAfter(0U)->sequence);
+}
+
+//Reads the finished laps in order the way GetLapsSince pages through them. A lap whose slot a new
+//rider took or that was invalidated is skipped.
+static void TestFinishedLapsInOrder(void)
+{
+    uint32_t last = GetLastLapSequence();
+    uint32_t expected = last - MAXLAPCOUNT + 1U;
+    Lap* lap = GetFinishedLapAfter(0U);
+
+    while(lap != (Lap*)0U)
+    {
+        CHECK_EQUAL(expected, lap->sequence);
+        expected++;
+        lap = GetFinishedLapAfter(lap->sequence);
+    }
+    CHECK_EQUAL(last + 1U, expected);
+    CHECK(GetFinishedLapAfter(last) == (Lap*)0U);
+
+    Trigger(SensorInputStartStop, StartTime(last));
+    CHECK_EQUAL(last - MAXLAPCOUNT + 2U, GetFinishedLapAfter(0U)->sequence);
+    InvalidateLapIndex(GetLapIndex(GetFinishedLapAfter(last - 2U)));
+    CHECK_EQUAL(last, GetFinishedLapAfter(last - 2U)->sequence);
+    Trigger(SensorInputStop, StartTime(last) + LapDuration(last));
+    CHECK_EQUAL(last + 1U, GetFinishedLapAfter(last)->sequence);
+}
+
+int main(void)
+{
+    TestSingleRunThenMultiRun();
+    TestRiderLimit();
+    TestWrapWithRidersOnTrack();
+    TestFinishedLapsInOrder();
+
+    return TEST_RESULT();
+}
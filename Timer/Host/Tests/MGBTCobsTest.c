@@ -0,0 +1,236 @@
+/*
+ * MGBTCobsTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Encodes data block by block the way the protocol does and checks the
+ *  result against a textbook COBS encoder, including the edge cases around
+ *  runs of 254 non-zero bytes and trailing zeros. Decodes it again in one
+ *  go, in arbitrary pieces and in place, and checks that frames cut off in
+ *  the middle of a block are reported as incomplete.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TestHelpers.h"
+#include "MGBTCobs.h"
+
+#define MAXDATALENGTH 1100U
+#define MAXENCODEDLENGTH (MAXDATALENGTH + MGBTCOBS_MAXOVERHEAD(MAXDATALENGTH) + 1U)
+#define RANDOMROUNDS 300U
+
+//Textbook encoder, a block of 254 non-zero bytes that ends the data is not followed by an empty block.
+static uint16_t ReferenceEncode(const uint8_t* data, uint16_t length, uint8_t* dst)
+{
+    uint16_t codePosition = 0U;
+    uint16_t position = 1U;
+    uint8_t code = 1U;
+    uint16_t index;
+
+    for(index = 0U; index < length; index++)
+    {
+        if(data[index] == 0U)
+        {
+            dst[codePosition] = code;
+            codePosition = position;
+            position++;
+            code = 1U;
+        }
+        else
+        {
+            dst[position] = data[index];
+            position++;
+            code++;
+            if((code == 0xFFU) && (index < (length - 1U)))
+            {
+                dst[codePosition] = code;
+                codePosition = position;
+                position++;
+                code = 1U;
+            }
+        }
+    }
+    dst[codePosition] = code;
+
+    return position;
+}
+
+static uint16_t Encode(const uint8_t* data, uint16_t length, uint8_t* dst)
+{
+    uint16_t encodedLength = 0U;
+    uint16_t position = 0U;
+
+    while(position <= length)
+    {
+        uint16_t consumed;
+        uint8_t code = MGBTCobsEncodeBlock(&data[position], length - position, &consumed);
+        dst[encodedLength] = code;
+        memcpy(&dst[encodedLength + 1U], &data[position], code - 1U);
+        encodedLength += code;
+        position += consumed;
+    }
+
+    return encodedLength;
+}
+
+static void CheckNoDelimiters(const uint8_t* encoded, uint16_t length)
+{
+    uint16_t index;
+    uint16_t delimiters = 0U;
+
+    for(index = 0U; index < length; index++)
+    {
+        if(encoded[index] == MGBTCOBS_DELIMITER)
+        {
+            delimiters++;
+        }
+    }
+    CHECK_EQUAL(0U, delimiters);
+}
+
+//Data that ends with a full block gets an extra empty block from the block encoder, both decode the same.
+static void CheckRoundTrip(const uint8_t* data, uint16_t length)
+{
+    static uint8_t encoded[MAXENCODEDLENGTH];
+    static uint8_t reference[MAXENCODEDLENGTH];
+    static uint8_t decoded[MAXENCODEDLENGTH];
+    MGBTCobsDecoder decoder;
+    uint16_t encodedLength = Encode(data, length, encoded);
+    uint16_t referenceLength = ReferenceEncode(data, length, reference);
+    uint16_t decodedLength;
+
+    CHECK(encodedLength <= (length + MGBTCOBS_MAXOVERHEAD(length)));
+    CHECK_EQUAL(0, memcmp(reference, encoded, referenceLength));
+    if(encodedLength != referenceLength)
+    {
+        CHECK_EQUAL(referenceLength + 1U, encodedLength);
+        CHECK_EQUAL(0xFFU, encoded[referenceLength - MGBTCOBS_BLOCKLENGTH - 1U]);
+        CHECK_EQUAL(1U, encoded[referenceLength]);
+    }
+    CheckNoDelimiters(encoded, encodedLength);
+
+    MGBTCobsDecodeInit(&decoder);
+    decodedLength = MGBTCobsDecode(&decoder, encoded, encodedLength, decoded);
+    CHECK_EQUAL(1U, MGBTCobsDecodeComplete(&decoder));
+    CHECK_EQUAL(length, decodedLength);
+    CHECK_EQUAL(0, memcmp(data, decoded, length));
+
+    MGBTCobsDecodeInit(&decoder);
+    decodedLength = MGBTCobsDecode(&decoder, reference, referenceLength, decoded);
+    CHECK_EQUAL(1U, MGBTCobsDecodeComplete(&decoder));
+    CHECK_EQUAL(length, decodedLength);
+    CHECK_EQUAL(0, memcmp(data, decoded, length));
+}
+
+static void TestEdgeCases(void)
+{
+    static uint8_t data[MAXDATALENGTH];
+    const uint16_t runLengths[8] = {0U, 1U, 253U, 254U, 255U, 508U, 509U, 1000U};
+    uint8_t run;
+
+    CheckRoundTrip(data, 0U);
+
+    memset(data, 0U, sizeof(data));
+    CheckRoundTrip(data, 1U);
+    CheckRoundTrip(data, 5U);
+
+    for(run = 0U; run < 8U; run++)
+    {
+        memset(data, 0x5AU, sizeof(data));
+        CheckRoundTrip(data, runLengths[run]);
+        data[runLengths[run]] = 0U;
+        CheckRoundTrip(data, (uint16_t)(runLengths[run] + 1U));
+        CheckRoundTrip(&data[1], runLengths[run]);
+    }
+}
+
+static void TestRandomRoundTrip(void)
+{
+    static uint8_t data[MAXDATALENGTH];
+    uint16_t round;
+    uint16_t index;
+
+    srand(4321U);
+    for(round = 0U; round < RANDOMROUNDS; round++)
+    {
+        uint16_t length = (uint16_t)(rand() % MAXDATALENGTH);
+        //Few zeros so long blocks occur as well as short ones.
+        uint8_t zeroChance = (uint8_t)(rand() % 4);
+        for(index = 0U; index < length; index++)
+        {
+            data[index] = (uint8_t)rand();
+            if((zeroChance == 0U) && (data[index] == 0U))
+            {
+                data[index] = 1U;
+            }
+        }
+        CheckRoundTrip(data, length);
+    }
+}
+
+//Decodes in pieces, writing each decoded piece right behind the previous one in the same buffer,
+//the way the protocol decodes a frame in its receive buffer.
+static void TestInPlacePieces(void)
+{
+    static uint8_t data[MAXDATALENGTH];
+    static uint8_t buffer[MAXENCODEDLENGTH];
+    uint16_t round;
+    uint16_t index;
+
+    srand(8765U);
+    for(round = 0U; round < RANDOMROUNDS; round++)
+    {
+        MGBTCobsDecoder decoder;
+        uint16_t length = (uint16_t)(rand() % MAXDATALENGTH);
+        uint16_t encodedLength;
+        uint16_t position = 0U;
+        uint16_t decodedLength = 0U;
+
+        for(index = 0U; index < length; index++)
+        {
+            data[index] = (uint8_t)(rand() % 8);
+        }
+        encodedLength = Encode(data, length, buffer);
+
+        MGBTCobsDecodeInit(&decoder);
+        while(position < encodedLength)
+        {
+            uint16_t piece = (uint16_t)(1 + (rand() % 40));
+            if(piece > (encodedLength - position))
+            {
+                piece = encodedLength - position;
+            }
+            decodedLength += MGBTCobsDecode(&decoder, &buffer[position], piece, &buffer[decodedLength]);
+            position += piece;
+        }
+        CHECK_EQUAL(1U, MGBTCobsDecodeComplete(&decoder));
+        CHECK_EQUAL(length, decodedLength);
+        CHECK_EQUAL(0, memcmp(data, buffer, length));
+    }
+}
+
+static void TestIncomplete(void)
+{
+    const uint8_t data[6] = {1U, 2U, 0U, 3U, 4U, 5U};
+    uint8_t encoded[8];
+    uint8_t decoded[8];
+    MGBTCobsDecoder decoder;
+    uint16_t encodedLength = Encode(data, sizeof(data), encoded);
+
+    MGBTCobsDecodeInit(&decoder);
+    CHECK_EQUAL(0U, MGBTCobsDecodeComplete(&decoder));
+    (void)MGBTCobsDecode(&decoder, encoded, (uint16_t)(encodedLength - 1U), decoded);
+    CHECK_EQUAL(0U, MGBTCobsDecodeComplete(&decoder));
+}
+
+int main(void)
+{
+    TestEdgeCases();
+    TestRandomRoundTrip();
+    TestInPlacePieces();
+    TestIncomplete();
+
+    return TEST_RESULT();
+}
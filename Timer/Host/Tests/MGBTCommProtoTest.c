@@ -0,0 +1,1165 @@
+/*
+ * MGBTCommProtoTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Sends commands of changing length through the simulated USART1 so the
+ *  frames start all over the receive ring and regularly run across its end.
+ *  Checks that every command is answered with a well formed response whose
+ *  data is echoed intact, and that frames with a bad CRC are ignored
+ *  without holding up the frames behind them.
+ *  Commands tagged with sequence numbers are sent back to back and their
+ *  responses are matched by tag. Commands in the COBS delimited v2 framing
+ *  carry payloads beyond the v1 limit, are answered in v2 framing, and a
+ *  corrupt v2 frame does not hold up the one behind it. The link speed is
+ *  raised and confirmed, an unconfirmed switch is undone and a central
+ *  that went back to the default rate is understood again. Laps are read
+ *  back page by page from a cursor, in either framing. Sensor times pushed
+ *  in connected mode are sent again until the central acknowledges them,
+ *  and a central that asks for batches gets those that arrive within the
+ *  window in one frame. Every sensor trigger is traced, the times sent
+ *  in connected mode reach every stage up to the UART in order.
+ *  The sensor journal is replayed in a stream of frames, also after the
+ *  journal has been started again as after a reset. The current time is
+ *  pushed every second until a central subscribes, then at the period it
+ *  asked for, and not at all once it unsubscribes. Execution time
+ *  histograms are read point by point and start over once they are read,
+ *  as do the scheduler stats of all tasks. Lap times that finish while the
+ *  time event queue is full wait until it has room, and are sent in
+ *  microseconds like the sensor times.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "TestHelpers.h"
+#include "SimEngine.h"
+#include "Configuration.h"
+#include "TimeMgmt.h"
+#include "CommunicationManager.h"
+#include "EventJournal.h"
+#include "Profiler.h"
+#include "SensorTrace.h"
+#include "Scheduler.h"
+#include "MGBTCommProto.h"
+#include "MGBTCrc.h"
+#include "MGBTCobs.h"
+
+#define RXHEADERLENGTH 9U
+#define TXHEADERLENGTH 8U
+#define ROUNDS 60U
+#define MAXRESPONSESTEPS 2000U
+//Lets the receive timeout of the protocol pass.
+#define SETTLESTEPS 300U
+//Well below the 200ms receive timeout, in steps of 100us.
+#define RESYNCMAXSTEPS 1000U
+#define SEQUENCESHIFT 8U
+#define IDENTIFICATIONLENGTH 9U
+#define LINKSPEED MGBTMAXLINKSPEED
+#define UNCONFIRMEDLINKSPEED 460800U
+//Longer than the 500ms the device waits for a switch to be confirmed.
+#define LINKCONFIRMSTEPS 6000U
+//The central gives the device time to switch before it sends at the new rate, the Timer runs its protocol every 10ms.
+#define LINKSWITCHSTEPS 250U
+//The device sends frames back to back, a quiet line ends whatever frame was being collected.
+#define COLLECTGAPSTEPS 10U
+#define LAPCOUNT 12U
+//Sensor triggers closer than 2s together are ignored.
+#define LAPSTEPS 25000U
+#define LAPDURATION1US 2500000U
+#define LAPPAGEHEADERLENGTH 5U
+#define LAPRECORDLENGTH 21U
+//Longer than the 500ms after which unacknowledged times are sent again.
+#define RETRANSMITSTEPS 6000U
+#define TIMEEVENTCOUNT 2U
+#define TIMEEVENTQUEUELENGTH 16U
+#define HELDBACKLAPS 2U
+//Type byte and 64 bit time behind the 32 bit time, then the event sequence number.
+#define TIMEEVENTTYPEOFFSET 4U
+#define TIMEEVENTSEQUENCEOFFSET 13U
+//50ms, in steps.
+#define BATCHWINDOW 50U
+#define BATCHWINDOWSTEPS (BATCHWINDOW * SIM_TICKS_PER_MS)
+#define BATCHRECORDLENGTH 13U
+#define JOURNALPAGEHEADERLENGTH 5U
+//Current time pushes are counted over this many steps, 2s.
+#define TOPICSTEPS (2U * SIM_TICKS_PER_SECOND)
+#define TOPICPERIOD 500U
+#define UNKNOWNTOPIC 42U
+#define JOURNALRECORDLENGTH 13U
+#define JOURNALV1RECORDS ((COMMANDDATAMAXSIZE - JOURNALPAGEHEADERLENGTH) / JOURNALRECORDLENGTH)
+//Point, point count, bucket count, cycles per microsecond, samples, longest.
+#define PERFSTATSHEADERLENGTH 12U
+#define SCHEDULERSTATSHEADERLENGTH 6U
+#define SCHEDULERSTATSRECORDLENGTH 20U
+#define TRACEPAGEHEADERLENGTH 5U
+//Trace ID, sensor, PPS time, stage offsets.
+#define TRACERECORDLENGTH (13U + (4U * NbOfTraceStages))
+#define TRACEV1RECORDS ((COMMANDDATAMAXSIZE - TRACEPAGEHEADERLENGTH) / TRACERECORDLENGTH)
+
+static uint8_t collectFrame[TXHEADERLENGTH + MGBTV2DATAMAXSIZE];
+static uint16_t framePosition = 0U;
+//v2 frames are collected encoded and decoded into collectFrame once their closing delimiter is in.
+static uint8_t encodedFrame[MGBTV2FRAMEMAXLENGTH];
+static uint16_t encodedPosition = 0U;
+static uint8_t collectingV2 = 0U;
+static uint64_t lastByteTime = 0U;
+static uint8_t responseFrames[MGBTCOMMANDQUEUELENGTH][TXHEADERLENGTH + MGBTV2DATAMAXSIZE];
+static uint8_t responseFramings[MGBTCOMMANDQUEUELENGTH];
+static uint8_t responseCount = 0U;
+static uint8_t expectedResponses = 1U;
+static uint8_t* responseFrame = responseFrames[0];
+static uint16_t lastWaitSteps = 0U;
+
+//Keeps frames of the requested type, the periodic time updates are skipped.
+//Pipelined responses are recognised by their sequence number instead.
+static uint16_t expectedCmdType = NoOperation;
+static uint8_t collectTagged = 0U;
+
+static uint16_t GetFrameWord(const uint8_t* frame, uint16_t offset)
+{
+    return (uint16_t)(frame[offset] | (frame[offset + 1U] << 8));
+}
+
+static void CompleteFrame(uint8_t framing)
+{
+    uint16_t cmdType = GetFrameWord(collectFrame, 6U);
+    if((responseCount < expectedResponses) &&
+       ((cmdType == expectedCmdType) ||
+        ((collectTagged != 0U) && ((cmdType >> SEQUENCESHIFT) != 0U))))
+    {
+        memcpy(responseFrames[responseCount], collectFrame, sizeof(collectFrame));
+        responseFramings[responseCount] = framing;
+        responseCount++;
+    }
+    framePosition = 0U;
+}
+
+//A v2 frame that does not decode to a complete frame is kept with a length that fails the checks.
+static void CompleteV2Frame(void)
+{
+    MGBTCobsDecoder decoder;
+    uint16_t decodedLength;
+
+    memset(collectFrame, 0xEEU, sizeof(collectFrame));
+    MGBTCobsDecodeInit(&decoder);
+    decodedLength = MGBTCobsDecode(&decoder, encodedFrame, encodedPosition, collectFrame);
+    if((MGBTCobsDecodeComplete(&decoder) == 0U) ||
+       (decodedLength != (TXHEADERLENGTH + GetFrameWord(collectFrame, 0U))))
+    {
+        collectFrame[0] = 0xEEU;
+        collectFrame[1] = 0xEEU;
+    }
+    CompleteFrame(MGBTFramingV2);
+}
+
+static void CollectTxByte(uint8_t uart, uint8_t byte)
+{
+    if(uart == 0U)
+    {
+        //Frames garbled by a rate mismatch do not keep the collector out of step.
+        if((SimGetTime100us() - lastByteTime) > COLLECTGAPSTEPS)
+        {
+            framePosition = 0U;
+            collectingV2 = 0U;
+        }
+        lastByteTime = SimGetTime100us();
+
+        if(collectingV2 == 1U)
+        {
+            if(byte == MGBTCOBS_DELIMITER)
+            {
+                CompleteV2Frame();
+                collectingV2 = 0U;
+            }
+            else if(encodedPosition < sizeof(encodedFrame))
+            {
+                encodedFrame[encodedPosition] = byte;
+                encodedPosition++;
+            }
+        }
+        else if((framePosition == 0U) && (byte == MGBTCOBS_DELIMITER))
+        {
+            collectingV2 = 1U;
+            encodedPosition = 0U;
+        }
+        else
+        {
+            if(framePosition < sizeof(collectFrame))
+            {
+                collectFrame[framePosition] = byte;
+            }
+            framePosition++;
+
+            if((framePosition >= TXHEADERLENGTH) &&
+               (framePosition >= (TXHEADERLENGTH + GetFrameWord(collectFrame, 0U))))
+            {
+                CompleteFrame(MGBTFramingV1);
+            }
+        }
+    }
+}
+
+static void ExpectResponses(uint16_t cmdType, uint8_t count, uint8_t tagged)
+{
+    expectedCmdType = cmdType;
+    expectedResponses = count;
+    collectTagged = tagged;
+    responseCount = 0U;
+}
+
+static void InjectCommand(uint16_t cmdType, const uint8_t* data, uint8_t length, uint8_t corrupt)
+{
+    uint8_t frame[RXHEADERLENGTH + COMMANDDATAMAXSIZE] = {0};
+    uint16_t crc;
+
+    frame[0] = 0xFFU;
+    frame[1] = length;
+    frame[7] = (uint8_t)(cmdType & 0xFFU);
+    frame[8] = (uint8_t)(cmdType >> 8);
+    memcpy(&frame[RXHEADERLENGTH], data, length);
+    crc = MGBTCrcCalculate(&frame[5], (uint16_t)(length + 4U));
+    if(corrupt != 0U)
+    {
+        crc ^= 0x0100U;
+    }
+    frame[3] = (uint8_t)(crc & 0xFFU);
+    frame[4] = (uint8_t)(crc >> 8);
+
+    CHECK_EQUAL(1U, SimUartInject(0U, frame, (uint16_t)(RXHEADERLENGTH + length)));
+}
+
+//Builds the v1 layout without its header byte, COBS encodes it and puts it between delimiters.
+//Returns the length of the encoded frame.
+static uint16_t BuildV2Frame(uint16_t cmdType, const uint8_t* data, uint16_t length, uint8_t* encoded)
+{
+    static uint8_t frame[TXHEADERLENGTH + MGBTV2DATAMAXSIZE];
+    uint16_t frameLength = (uint16_t)(TXHEADERLENGTH + length);
+    uint16_t encodedLength = 1U;
+    uint16_t position = 0U;
+    uint16_t crc;
+
+    frame[0] = (uint8_t)(length & 0xFFU);
+    frame[1] = (uint8_t)(length >> 8);
+    frame[4] = 0U;
+    frame[5] = 0U;
+    frame[6] = (uint8_t)(cmdType & 0xFFU);
+    frame[7] = (uint8_t)(cmdType >> 8);
+    memcpy(&frame[TXHEADERLENGTH], data, length);
+    crc = MGBTCrcCalculate(&frame[4], (uint16_t)(length + 4U));
+    frame[2] = (uint8_t)(crc & 0xFFU);
+    frame[3] = (uint8_t)(crc >> 8);
+
+    encoded[0] = MGBTCOBS_DELIMITER;
+    while(position <= frameLength)
+    {
+        uint16_t consumed;
+        uint8_t code = MGBTCobsEncodeBlock(&frame[position], frameLength - position, &consumed);
+        encoded[encodedLength] = code;
+        memcpy(&encoded[encodedLength + 1U], &frame[position], code - 1U);
+        encodedLength += code;
+        position += consumed;
+    }
+    encoded[encodedLength] = MGBTCOBS_DELIMITER;
+
+    return encodedLength + 1U;
+}
+
+static void SendV2Command(uint16_t cmdType, const uint8_t* data, uint16_t length)
+{
+    static uint8_t encoded[MGBTV2FRAMEMAXLENGTH];
+    uint16_t encodedLength = BuildV2Frame(cmdType, data, length, encoded);
+
+    ExpectResponses(cmdType, 1U, 0U);
+    CHECK_EQUAL(1U, SimUartInject(0U, encoded, encodedLength));
+}
+
+//The response parser stays in step with the periodic frames, it is not reset here.
+static void SendCommand(uint16_t cmdType, const uint8_t* data, uint8_t length, uint8_t corrupt)
+{
+    ExpectResponses(cmdType, 1U, 0U);
+    InjectCommand(cmdType, data, length, corrupt);
+}
+
+static void StepFor(uint16_t steps)
+{
+    uint16_t step;
+
+    for(step = 0U; step < steps; step++)
+    {
+        SimStep(1U);
+    }
+}
+
+//Returns 1 once all expected responses are in, the next command is sent right away.
+static uint8_t WaitForResponse(void)
+{
+    uint8_t retVal = 0U;
+    uint16_t step;
+
+    for(step = 0U; (step < MAXRESPONSESTEPS) && (responseCount < expectedResponses); step++)
+    {
+        SimStep(1U);
+    }
+    lastWaitSteps = step;
+    if(responseCount == expectedResponses)
+    {
+        retVal = 1U;
+    }
+
+    return retVal;
+}
+
+static void CheckFrameCrc(const uint8_t* response)
+{
+    uint16_t dataLength = GetFrameWord(response, 0U);
+    CHECK_EQUAL(GetFrameWord(response, 2U), MGBTCrcCalculate(&response[4], (uint16_t)(dataLength + 4U)));
+}
+
+static void CheckResponseCrc(void)
+{
+    CheckFrameCrc(responseFrame);
+}
+
+//The displayed time command echoes its data; a value of 0 leaves the display alone.
+static void TestEchoAcrossRing(void)
+{
+    uint8_t data[COMMANDDATAMAXSIZE];
+    uint8_t round;
+
+    for(round = 0U; round < ROUNDS; round++)
+    {
+        uint8_t length = (uint8_t)(4U + ((round * 7U) % 60U));
+        uint8_t index;
+
+        memset(data, 0U, sizeof(data));
+        for(index = 4U; index < length; index++)
+        {
+            data[index] = (uint8_t)(round + index);
+        }
+
+        SendCommand(UpdateDisplayedTime, data, length, 0U);
+        CHECK_EQUAL(1U, WaitForResponse());
+        CheckResponseCrc();
+        CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+        CHECK_EQUAL(length, GetFrameWord(responseFrame, 0U));
+        CHECK_EQUAL(0, memcmp(data, &responseFrame[TXHEADERLENGTH], length));
+    }
+}
+
+static void CheckIdentification(void)
+{
+    CheckResponseCrc();
+    CHECK_EQUAL(IDENTIFICATIONLENGTH, GetFrameWord(responseFrame, 0U));
+    CHECK_EQUAL(DeviceTypeTimer | DeviceTypeDisplay, responseFrame[TXHEADERLENGTH]);
+    CHECK_EQUAL(MGBTCOMMANDQUEUELENGTH, responseFrame[TXHEADERLENGTH + 5U]);
+    CHECK_EQUAL(MGBTPROTOCOLVERSION, responseFrame[TXHEADERLENGTH + 6U]);
+    CHECK_EQUAL(MGBTV2DATAMAXSIZE, GetFrameWord(responseFrame, TXHEADERLENGTH + 7U));
+}
+
+static void TestIdentification(void)
+{
+    SendCommand(GetIdentification, (const uint8_t*)0, 0U, 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(MGBTFramingV1, responseFramings[0]);
+    CheckIdentification();
+}
+
+//A frame with a bad CRC is not answered. It is dropped as soon as it is in, the frame right
+//behind it is answered without waiting for the receive timeout.
+static void TestBadCrc(void)
+{
+    const uint8_t data[4] = {0xFFU, 0x02U, 0x00U, 0xFFU};
+    //The length says one data byte, three follow. Skipping by the length would leave the zero byte
+    //to open a v2 frame that takes the next frame along.
+    const uint8_t shortened[12] = {0xFFU, 0x01U, 0x00U, 0x11U, 0x22U, 0x00U, 0x00U, 0x33U, 0x00U, 0x44U, 0x55U, 0x00U};
+
+    SendCommand(GetIdentification, (const uint8_t*)0, 0U, 1U);
+    CHECK_EQUAL(0U, WaitForResponse());
+    StepFor(SETTLESTEPS);
+    TestIdentification();
+
+    //Header bytes in the data of the bad frame are not taken as frames.
+    InjectCommand(GetIdentification, data, sizeof(data), 1U);
+    TestIdentification();
+    CHECK(lastWaitSteps < RESYNCMAXSTEPS);
+
+    CHECK_EQUAL(1U, SimUartInject(0U, shortened, sizeof(shortened)));
+    TestIdentification();
+    CHECK(lastWaitSteps < RESYNCMAXSTEPS);
+}
+
+//A full queue of tagged commands arrives in one burst, every response carries the tag of its command.
+static void TestPipelined(void)
+{
+    uint8_t data[MGBTCOMMANDQUEUELENGTH][8];
+    uint8_t round;
+
+    for(round = 0U; round < ROUNDS; round++)
+    {
+        uint8_t index;
+
+        ExpectResponses(NoOperation, MGBTCOMMANDQUEUELENGTH, 1U);
+        for(index = 0U; index < MGBTCOMMANDQUEUELENGTH; index++)
+        {
+            uint8_t sequence = (uint8_t)(1U + (((round * MGBTCOMMANDQUEUELENGTH) + index) % 255U));
+            memset(data[index], 0U, sizeof(data[index]));
+            data[index][4] = sequence;
+            data[index][5] = round;
+            InjectCommand((uint16_t)(UpdateDisplayedTime | (sequence << SEQUENCESHIFT)), data[index], (uint8_t)(5U + (index % 4U)), 0U);
+        }
+
+        CHECK_EQUAL(1U, WaitForResponse());
+        for(index = 0U; index < MGBTCOMMANDQUEUELENGTH; index++)
+        {
+            const uint8_t* response = responseFrames[index];
+            uint8_t length = (uint8_t)(5U + (index % 4U));
+
+            CheckFrameCrc(response);
+            CHECK_EQUAL(UpdateDisplayedTime | (data[index][4] << SEQUENCESHIFT), GetFrameWord(response, 6U));
+            CHECK_EQUAL(0U, GetFrameWord(response, 4U));
+            CHECK_EQUAL(length, GetFrameWord(response, 0U));
+            CHECK_EQUAL(0, memcmp(data[index], &response[TXHEADERLENGTH], length));
+        }
+    }
+}
+
+static void TestV2Identification(void)
+{
+    SendV2Command(GetIdentification, (const uint8_t*)0, 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(MGBTFramingV2, responseFramings[0]);
+    CheckIdentification();
+}
+
+//Payloads beyond the v1 limit, with zeros and long runs without them, echoed intact.
+static void TestV2LargeEcho(void)
+{
+    static uint8_t data[MGBTV2DATAMAXSIZE];
+    const uint16_t lengths[4] = {COMMANDDATAMAXSIZE + 1U, 300U, 511U, MGBTV2DATAMAXSIZE};
+    uint8_t round;
+
+    for(round = 0U; round < 4U; round++)
+    {
+        uint16_t index;
+
+        memset(data, 0U, sizeof(data));
+        for(index = 4U; index < lengths[round]; index++)
+        {
+            if((index % 300U) < 260U)
+            {
+                data[index] = (uint8_t)(1U + ((index + round) % 255U));
+            }
+        }
+
+        SendV2Command(UpdateDisplayedTime, data, lengths[round]);
+        CHECK_EQUAL(1U, WaitForResponse());
+        CHECK_EQUAL(MGBTFramingV2, responseFramings[0]);
+        CheckResponseCrc();
+        CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+        CHECK_EQUAL(lengths[round], GetFrameWord(responseFrame, 0U));
+        CHECK_EQUAL(0, memcmp(data, &responseFrame[TXHEADERLENGTH], lengths[round]));
+    }
+}
+
+//Junk, a frame with a bad CRC and a frame that is cut off are all followed directly by a good frame,
+//which is answered without waiting for the receive timeout.
+static void TestV2Resync(void)
+{
+    static uint8_t stream[3U * MGBTV2FRAMEMAXLENGTH];
+    const uint8_t junk[5] = {0x12U, 0xFFU, 0x34U, 0x56U, 0x78U};
+    uint8_t data[8] = {0U, 0U, 0U, 0U, 1U, 2U, 3U, 4U};
+    uint8_t round;
+
+    for(round = 0U; round < 3U; round++)
+    {
+        uint16_t length = 0U;
+
+        if(round == 0U)
+        {
+            memcpy(stream, junk, sizeof(junk));
+            length = sizeof(junk);
+        }
+        else
+        {
+            length = BuildV2Frame(UpdateDisplayedTime, data, sizeof(data), stream);
+            if(round == 1U)
+            {
+                stream[length - 3U] ^= 0x01U;
+            }
+            else
+            {
+                length = (uint16_t)(length / 2U);
+            }
+        }
+        data[4] = (uint8_t)(round + 10U);
+        length += BuildV2Frame(UpdateDisplayedTime, data, sizeof(data), &stream[length]);
+
+        ExpectResponses(UpdateDisplayedTime, 1U, 0U);
+        CHECK_EQUAL(1U, SimUartInject(0U, stream, length));
+        CHECK_EQUAL(1U, WaitForResponse());
+        CHECK(lastWaitSteps < RESYNCMAXSTEPS);
+        CheckResponseCrc();
+        CHECK_EQUAL(sizeof(data), GetFrameWord(responseFrame, 0U));
+        CHECK_EQUAL(0, memcmp(data, &responseFrame[TXHEADERLENGTH], sizeof(data)));
+    }
+}
+
+static void SendLinkSpeed(uint32_t speed)
+{
+    uint8_t data[sizeof(speed)];
+    memcpy(data, &speed, sizeof(speed));
+    SendCommand(SetLinkSpeed, data, sizeof(data), 0U);
+}
+
+static uint32_t GetResponseLinkSpeed(void)
+{
+    uint32_t speed = 0U;
+    CHECK_EQUAL(sizeof(speed), GetFrameWord(responseFrame, 0U));
+    memcpy(&speed, &responseFrame[TXHEADERLENGTH], sizeof(speed));
+    return speed;
+}
+
+static uint16_t TimeLargeEcho(void)
+{
+    static uint8_t data[MGBTV2DATAMAXSIZE];
+
+    memset(data, 0x5AU, sizeof(data));
+    SendV2Command(UpdateDisplayedTime, data, MGBTV2DATAMAXSIZE);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(MGBTV2DATAMAXSIZE, GetFrameWord(responseFrame, 0U));
+    CHECK_EQUAL(0, memcmp(data, &responseFrame[TXHEADERLENGTH], MGBTV2DATAMAXSIZE));
+
+    return lastWaitSteps;
+}
+
+//The switch is answered at the old rate and confirmed by the first command at the new one.
+static void TestLinkSpeed(void)
+{
+    uint8_t noisyFrame[RXHEADERLENGTH + 40U];
+    uint16_t defaultSteps;
+    uint8_t attempt;
+    uint8_t answered = 0U;
+
+    //A frame with 40 data bytes and bit 8 of its length flipped, none of its bytes is zero.
+    memset(noisyFrame, 0x5AU, sizeof(noisyFrame));
+    noisyFrame[0] = 0xFFU;
+    noisyFrame[1] = 40U;
+    noisyFrame[2] = 0x01U;
+
+    SendLinkSpeed(100000U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0xFFFFU, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(MGBTMAXLINKSPEED, GetResponseLinkSpeed());
+
+    defaultSteps = TimeLargeEcho();
+    SendLinkSpeed(LINKSPEED);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(LINKSPEED, GetResponseLinkSpeed());
+    StepFor(LINKSWITCHSTEPS);
+    SimSetLineBaudRate(0U, LINKSPEED);
+    TestIdentification();
+    StepFor(LINKCONFIRMSTEPS);
+    CHECK((TimeLargeEcho() * 3U) < defaultSteps);
+
+    //A frame with a flipped bit in its length is one receive error, not one per byte.
+    CHECK_EQUAL(1U, SimUartInject(0U, noisyFrame, sizeof(noisyFrame)));
+    StepFor(SETTLESTEPS);
+    TestIdentification();
+
+    //The central never switches, the device goes back once the confirmation is overdue.
+    SendLinkSpeed(UNCONFIRMEDLINKSPEED);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    StepFor(LINKCONFIRMSTEPS);
+    TestIdentification();
+
+    //The central starts over at the default rate. Its first commands arrive garbled,
+    //the burst of receive errors brings the device back to the default rate as well.
+    SimSetLineBaudRate(0U, MGBTDEFAULTLINKSPEED);
+    for(attempt = 0U; (attempt < 4U) && (answered == 0U); attempt++)
+    {
+        SendCommand(GetIdentification, (const uint8_t*)0, 0U, 0U);
+        answered = WaitForResponse();
+        if(answered == 0U)
+        {
+            StepFor(SETTLESTEPS);
+        }
+    }
+    CHECK_EQUAL(1U, answered);
+    CHECK(attempt > 1U);
+    CheckIdentification();
+}
+
+static void SendLapsSince(uint32_t cursor, uint8_t framing)
+{
+    uint8_t data[sizeof(cursor)];
+    memcpy(data, &cursor, sizeof(cursor));
+    if(framing == MGBTFramingV2)
+    {
+        SendV2Command(GetLapsSince, data, sizeof(data));
+    }
+    else
+    {
+        SendCommand(GetLapsSince, data, sizeof(data), 0U);
+    }
+    CHECK_EQUAL(1U, WaitForResponse());
+    CheckResponseCrc();
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+}
+
+static uint32_t GetPageLastSequence(void)
+{
+    uint32_t sequence;
+    memcpy(&sequence, &responseFrame[TXHEADERLENGTH], sizeof(sequence));
+    return sequence;
+}
+
+static uint8_t GetPageCount(void)
+{
+    uint8_t count = responseFrame[TXHEADERLENGTH + 4U];
+    CHECK_EQUAL(LAPPAGEHEADERLENGTH + (count * LAPRECORDLENGTH), GetFrameWord(responseFrame, 0U));
+    return count;
+}
+
+//Pages through the laps after cursor. The laptimer starts each lap where the previous one ended.
+//Returns the number of pages it took.
+static uint8_t ReadLaps(uint32_t cursor, uint32_t lastSequence, uint8_t framing)
+{
+    uint8_t pages = 0U;
+    uint8_t count = 1U;
+    Timestamp1us previousEnd = 0U;
+
+    while((count > 0U) && (pages <= LAPCOUNT))
+    {
+        uint8_t index;
+
+        SendLapsSince(cursor, framing);
+        CHECK_EQUAL(lastSequence, GetPageLastSequence());
+        count = GetPageCount();
+        for(index = 0U; index < count; index++)
+        {
+            const uint8_t* record = &responseFrame[TXHEADERLENGTH + LAPPAGEHEADERLENGTH + (index * LAPRECORDLENGTH)];
+            uint32_t sequence;
+            Timestamp1us start;
+            Timestamp1us end;
+
+            memcpy(&sequence, &record[0], sizeof(sequence));
+            memcpy(&start, &record[4], sizeof(start));
+            memcpy(&end, &record[12], sizeof(end));
+            CHECK_EQUAL(cursor + 1U, sequence);
+            CHECK(((end - start) > (LAPDURATION1US - 1000U)) && ((end - start) < (LAPDURATION1US + 1000U)));
+            CHECK((previousEnd == 0U) || (previousEnd == start));
+            CHECK_EQUAL(SingleSensor, record[20]);
+            previousEnd = end;
+            cursor = sequence;
+        }
+        if(count > 0U)
+        {
+            pages++;
+        }
+    }
+    CHECK_EQUAL(lastSequence, cursor);
+
+    return pages;
+}
+
+//A central that is up to date gets an empty page, one that missed laps only gets those.
+static void TestLapsSince(void)
+{
+    uint32_t firstSequence;
+    uint8_t lap;
+
+    SendLapsSince(0U, MGBTFramingV1);
+    firstSequence = GetPageLastSequence();
+    for(lap = 0U; lap <= LAPCOUNT; lap++)
+    {
+        SimTriggerSensor(SimSensorStartStop, 0U);
+        StepFor(LAPSTEPS);
+    }
+
+    CHECK_EQUAL((LAPCOUNT + 4U) / 5U, ReadLaps(firstSequence, firstSequence + LAPCOUNT, MGBTFramingV1));
+    CHECK_EQUAL(1U, ReadLaps(firstSequence, firstSequence + LAPCOUNT, MGBTFramingV2));
+    CHECK_EQUAL(1U, ReadLaps(firstSequence + LAPCOUNT - 2U, firstSequence + LAPCOUNT, MGBTFramingV1));
+    CHECK_EQUAL(0U, ReadLaps(firstSequence + LAPCOUNT, firstSequence + LAPCOUNT, MGBTFramingV1));
+}
+
+static void SendAckTimestamps(uint32_t eventSequence, uint8_t expectedQueued)
+{
+    uint8_t data[sizeof(eventSequence)];
+    memcpy(data, &eventSequence, sizeof(eventSequence));
+    SendCommand(AckTimestamps, data, sizeof(data), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(expectedQueued, responseFrame[TXHEADERLENGTH]);
+}
+
+static uint32_t GetTimeEventSequence(const uint8_t* response)
+{
+    uint32_t eventSequence;
+    memcpy(&eventSequence, &response[TXHEADERLENGTH + TIMEEVENTSEQUENCEOFFSET], sizeof(eventSequence));
+    return eventSequence;
+}
+
+//Collects pushed times for a while. Returns how many came in.
+static uint8_t CollectTimeEvents(uint8_t count, uint16_t steps)
+{
+    ExpectResponses(GetLatestTimeStamp, count, 0U);
+    StepFor(steps);
+    return responseCount;
+}
+
+//Starts and finishes arrive back to back. Every time is pushed in order and pushed again
+//until it is acknowledged, acknowledged times are not sent again.
+static void TestTimestampAcks(void)
+{
+    const uint8_t mode = ConnectedTimestampCollector;
+    uint32_t firstSequence;
+    uint8_t index;
+
+    SendCommand(UpdateOpMode, &mode, sizeof(mode), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    SendAckTimestamps(0U, 0U);
+
+    ExpectResponses(GetLatestTimeStamp, TIMEEVENTCOUNT, 0U);
+    SimTriggerSensor(SimSensorStartStop, 0U);
+    SimTriggerSensor(SimSensorStop, 50U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    firstSequence = GetTimeEventSequence(responseFrames[0]);
+    for(index = 0U; index < TIMEEVENTCOUNT; index++)
+    {
+        CheckFrameCrc(responseFrames[index]);
+        CHECK_EQUAL(firstSequence + index, GetTimeEventSequence(responseFrames[index]));
+        CHECK_EQUAL(((index % 2U) == 0U) ? StartSensorTimeStamp : FinishSensorTimeStamp,
+                    responseFrames[index][TXHEADERLENGTH + TIMEEVENTTYPEOFFSET]);
+    }
+
+    //Nothing acknowledged, all of them come again.
+    CHECK_EQUAL(TIMEEVENTCOUNT, CollectTimeEvents(TIMEEVENTCOUNT, RETRANSMITSTEPS));
+    for(index = 0U; index < TIMEEVENTCOUNT; index++)
+    {
+        CHECK_EQUAL(firstSequence + index, GetTimeEventSequence(responseFrames[index]));
+    }
+
+    SendAckTimestamps(firstSequence, TIMEEVENTCOUNT - 1U);
+    CHECK_EQUAL(1U, CollectTimeEvents(TIMEEVENTCOUNT, RETRANSMITSTEPS));
+    CHECK_EQUAL(firstSequence + 1U, GetTimeEventSequence(responseFrames[0]));
+
+    SendAckTimestamps(firstSequence + TIMEEVENTCOUNT - 1U, 0U);
+    CHECK_EQUAL(0U, CollectTimeEvents(1U, RETRANSMITSTEPS));
+}
+
+//A central that stops acknowledging fills the time event queue. The lap times that finish then
+//are held back until it has room again, not dropped.
+static void TestLapTimesHeldBack(void)
+{
+    const uint8_t mode = LaptimerOperation;
+    const uint8_t* record;
+    uint64_t lapTime1us;
+    uint8_t lap;
+
+    SendCommand(UpdateOpMode, &mode, sizeof(mode), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    SendAckTimestamps(0xFFFFFFFFU, 0U);
+
+    //A lap from the earlier tests still runs, every trigger finishes one.
+    for(lap = 0U; lap < (TIMEEVENTQUEUELENGTH + HELDBACKLAPS); lap++)
+    {
+        SimTriggerSensor(SimSensorStartStop, 0U);
+        StepFor(LAPSTEPS);
+    }
+    //Batched since the batch test. The first lap started in an earlier test, the second one ran
+    //for exactly LAPSTEPS and its time is in microseconds like the sensor times.
+    ExpectResponses(TimeEventBatch, 1U, 0U);
+    StepFor(RETRANSMITSTEPS);
+    CHECK_EQUAL(1U, responseCount);
+    record = &responseFrame[TXHEADERLENGTH + 1U + BATCHRECORDLENGTH];
+    memcpy(&lapTime1us, &record[5], sizeof(lapTime1us));
+    CHECK_EQUAL(LastLapTime, record[4]);
+    CHECK_EQUAL((uint64_t)LAPSTEPS * (1000U / SIM_TICKS_PER_MS), lapTime1us);
+    SendAckTimestamps(0U, TIMEEVENTQUEUELENGTH);
+    SendAckTimestamps(0xFFFFFFFFU, 0U);
+    StepFor(SETTLESTEPS);
+    SendAckTimestamps(0U, HELDBACKLAPS);
+    SendAckTimestamps(0xFFFFFFFFU, 0U);
+}
+
+static void SendSensorTraces(uint32_t cursor, uint8_t framing)
+{
+    uint8_t data[sizeof(cursor)];
+    memcpy(data, &cursor, sizeof(cursor));
+    if(framing == MGBTFramingV2)
+    {
+        SendV2Command(GetSensorTraces, data, sizeof(data));
+    }
+    else
+    {
+        SendCommand(GetSensorTraces, data, sizeof(data), 0U);
+    }
+    CHECK_EQUAL(1U, WaitForResponse());
+    CheckResponseCrc();
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(TRACEPAGEHEADERLENGTH + (responseFrame[TXHEADERLENGTH + 4U] * TRACERECORDLENGTH), GetFrameWord(responseFrame, 0U));
+}
+
+static uint32_t GetTraceStage(const uint8_t* record, uint8_t stage)
+{
+    uint32_t offset1us;
+    memcpy(&offset1us, &record[13U + (4U * stage)], sizeof(offset1us));
+    return offset1us;
+}
+
+//The times of the start and finish that were acknowledged last passed every stage in order.
+//Older triggers are read page by page, a v1 frame holds only a few.
+static void TestSensorTraces(void)
+{
+    uint32_t lastId;
+    uint8_t index;
+
+    SendSensorTraces(0U, MGBTFramingV2);
+    memcpy(&lastId, &responseFrame[TXHEADERLENGTH], sizeof(lastId));
+    CHECK(lastId >= TIMEEVENTCOUNT);
+    CHECK(responseFrame[TXHEADERLENGTH + 4U] >= TIMEEVENTCOUNT);
+
+    SendSensorTraces(lastId - TIMEEVENTCOUNT, MGBTFramingV2);
+    CHECK_EQUAL(TIMEEVENTCOUNT, responseFrame[TXHEADERLENGTH + 4U]);
+    for(index = 0U; index < TIMEEVENTCOUNT; index++)
+    {
+        const uint8_t* record = &responseFrame[TXHEADERLENGTH + TRACEPAGEHEADERLENGTH + (index * TRACERECORDLENGTH)];
+        uint32_t traceId;
+        uint8_t stage;
+
+        memcpy(&traceId, record, sizeof(traceId));
+        CHECK_EQUAL(lastId - TIMEEVENTCOUNT + 1U + index, traceId);
+        CHECK_EQUAL(((index % 2U) == 0U) ? SensorInputStartStop : SensorInputStop, record[4]);
+        for(stage = 1U; stage < NbOfTraceStages; stage++)
+        {
+            CHECK(GetTraceStage(record, stage) != SENSORTRACENOTREACHED);
+            CHECK(GetTraceStage(record, stage) >= GetTraceStage(record, stage - 1U));
+        }
+    }
+
+    SendSensorTraces(0U, MGBTFramingV1);
+    CHECK_EQUAL(TRACEV1RECORDS, responseFrame[TXHEADERLENGTH + 4U]);
+    SendSensorTraces(lastId, MGBTFramingV1);
+    CHECK_EQUAL(0U, responseFrame[TXHEADERLENGTH + 4U]);
+}
+
+//Two times that arrive within the window go out together once it has passed. Unacknowledged
+//they are sent again together, acknowledged they are not.
+static void TestTimeEventBatches(void)
+{
+    const uint8_t window[2] = {(uint8_t)BATCHWINDOW, 0U};
+    uint64_t triggerTime;
+    uint32_t firstSequence;
+    uint8_t index;
+
+    SendCommand(TimeEventBatch, window, sizeof(window), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(BATCHWINDOW, GetFrameWord(responseFrame, TXHEADERLENGTH));
+    //Past the minimum time between two triggers of a sensor.
+    StepFor(LAPSTEPS);
+
+    ExpectResponses(TimeEventBatch, 1U, 0U);
+    triggerTime = SimGetTime100us();
+    SimTriggerSensor(SimSensorStartStop, 0U);
+    StepFor(SIM_TICKS_PER_MS);
+    SimTriggerSensor(SimSensorStop, 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK((SimGetTime100us() - triggerTime) >= BATCHWINDOWSTEPS);
+    CheckResponseCrc();
+    CHECK_EQUAL(1U + (TIMEEVENTCOUNT * BATCHRECORDLENGTH), GetFrameWord(responseFrame, 0U));
+    CHECK_EQUAL(TIMEEVENTCOUNT, responseFrame[TXHEADERLENGTH]);
+    memcpy(&firstSequence, &responseFrame[TXHEADERLENGTH + 1U], sizeof(firstSequence));
+    for(index = 0U; index < TIMEEVENTCOUNT; index++)
+    {
+        const uint8_t* record = &responseFrame[TXHEADERLENGTH + 1U + (index * BATCHRECORDLENGTH)];
+        uint32_t sequence;
+        memcpy(&sequence, record, sizeof(sequence));
+        CHECK_EQUAL(firstSequence + index, sequence);
+        CHECK_EQUAL(((index % 2U) == 0U) ? StartSensorTimeStamp : FinishSensorTimeStamp, record[4]);
+    }
+
+    ExpectResponses(TimeEventBatch, 2U, 0U);
+    StepFor(RETRANSMITSTEPS);
+    CHECK_EQUAL(1U, responseCount);
+    CHECK_EQUAL(TIMEEVENTCOUNT, responseFrames[0][TXHEADERLENGTH]);
+
+    SendAckTimestamps(firstSequence + TIMEEVENTCOUNT - 1U, 0U);
+    ExpectResponses(TimeEventBatch, 1U, 0U);
+    StepFor(RETRANSMITSTEPS);
+    CHECK_EQUAL(0U, responseCount);
+}
+
+static void SendReplayJournal(uint32_t fromSequence, uint8_t framing, uint8_t frames)
+{
+    uint8_t data[sizeof(fromSequence)];
+    memcpy(data, &fromSequence, sizeof(fromSequence));
+    if(framing == MGBTFramingV2)
+    {
+        SendV2Command(ReplayJournal, data, sizeof(data));
+    }
+    else
+    {
+        SendCommand(ReplayJournal, data, sizeof(data), 0U);
+    }
+    ExpectResponses(ReplayJournal, frames, 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+}
+
+//Replays from fromSequence in the given number of frames and checks that the records run on
+//without gaps up to the newest event. Returns the number of records.
+static uint32_t ReplayJournalFrom(uint32_t fromSequence, uint8_t framing, uint8_t frames)
+{
+    uint32_t lastSequence = EventJournalGetLastSequence();
+    //Sequence numbers start at 1.
+    uint32_t expected = (fromSequence == 0U) ? 1U : fromSequence;
+    uint32_t records = 0U;
+    Timestamp1us previousTime = 0U;
+    uint8_t frame;
+
+    SendReplayJournal(fromSequence, framing, frames);
+    for(frame = 0U; frame < frames; frame++)
+    {
+        const uint8_t* response = responseFrames[frame];
+        uint32_t pageLastSequence;
+        uint8_t count = response[TXHEADERLENGTH + 4U];
+        uint8_t index;
+
+        CheckFrameCrc(response);
+        CHECK_EQUAL(framing, responseFramings[frame]);
+        CHECK_EQUAL(0U, GetFrameWord(response, 4U));
+        CHECK_EQUAL(JOURNALPAGEHEADERLENGTH + (count * JOURNALRECORDLENGTH), GetFrameWord(response, 0U));
+        memcpy(&pageLastSequence, &response[TXHEADERLENGTH], sizeof(pageLastSequence));
+        CHECK_EQUAL(lastSequence, pageLastSequence);
+        for(index = 0U; index < count; index++)
+        {
+            const uint8_t* record = &response[TXHEADERLENGTH + JOURNALPAGEHEADERLENGTH + (index * JOURNALRECORDLENGTH)];
+            uint32_t sequence;
+            Timestamp1us time;
+
+            memcpy(&sequence, &record[0], sizeof(sequence));
+            memcpy(&time, &record[4], sizeof(time));
+            CHECK_EQUAL(expected, sequence);
+            CHECK(time > previousTime);
+            CHECK(record[12] < NbOfSensorInputs);
+            previousTime = time;
+            expected++;
+            records++;
+        }
+    }
+    CHECK_EQUAL(lastSequence + 1U, expected);
+
+    return records;
+}
+
+//Every sensor trigger of the earlier tests is in the journal, a central that catches up only gets
+//what it missed and one that is up to date gets an empty frame.
+static void TestReplayJournal(void)
+{
+    uint32_t events = EventJournalGetLastSequence();
+    uint8_t v1Frames = (uint8_t)((events + JOURNALV1RECORDS - 1U) / JOURNALV1RECORDS);
+    const uint8_t shortData[2] = {1U, 0U};
+
+    CHECK(v1Frames > 1U);
+    CHECK(v1Frames <= MGBTCOMMANDQUEUELENGTH);
+    CHECK_EQUAL(events, ReplayJournalFrom(1U, MGBTFramingV1, v1Frames));
+    CHECK_EQUAL(events, ReplayJournalFrom(1U, MGBTFramingV2, 1U));
+    CHECK_EQUAL(3U, ReplayJournalFrom(events - 2U, MGBTFramingV1, 1U));
+    CHECK_EQUAL(0U, ReplayJournalFrom(events + 1U, MGBTFramingV1, 1U));
+
+    //The journal is found again after a reset.
+    EventJournalInit();
+    CHECK_EQUAL(events, EventJournalGetLastSequence());
+    CHECK_EQUAL(events, ReplayJournalFrom(0U, MGBTFramingV2, 1U));
+
+    SendCommand(ReplayJournal, shortData, sizeof(shortData), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0xFFFFU, GetFrameWord(responseFrame, 4U));
+}
+
+//Returns the period the device uses.
+static uint16_t SendSubscribe(uint8_t topic, uint16_t period, uint16_t expectedStatus)
+{
+    uint8_t data[3] = {topic, (uint8_t)(period & 0xFFU), (uint8_t)(period >> 8)};
+    SendCommand(Subscribe, data, sizeof(data), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CheckResponseCrc();
+    CHECK_EQUAL(expectedStatus, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(topic, responseFrame[TXHEADERLENGTH]);
+    return GetFrameWord(responseFrame, TXHEADERLENGTH + 1U);
+}
+
+static uint8_t CountCurrentTimePushes(void)
+{
+    ExpectResponses(GetCurrentTime, MGBTCOMMANDQUEUELENGTH, 0U);
+    StepFor(TOPICSTEPS);
+    return responseCount;
+}
+
+//Milliseconds in the 32 bit value as older centrals expect them, microseconds in the full one.
+static void CheckCurrentTime(const uint8_t* response)
+{
+    uint32_t shortTime;
+    uint64_t fullTime;
+
+    CheckFrameCrc(response);
+    CHECK_EQUAL(TIMEEVENTSEQUENCEOFFSET, GetFrameWord(response, 0U));
+    memcpy(&shortTime, &response[TXHEADERLENGTH], sizeof(shortTime));
+    memcpy(&fullTime, &response[TXHEADERLENGTH + TIMEEVENTTYPEOFFSET + 1U], sizeof(fullTime));
+    CHECK_EQUAL(NoTimeType, response[TXHEADERLENGTH + TIMEEVENTTYPEOFFSET]);
+    CHECK(fullTime > 0U);
+    CHECK_EQUAL((uint32_t)(fullTime / 1000U), shortTime);
+}
+
+static void TestSubscriptions(void)
+{
+    uint8_t pushes = CountCurrentTimePushes();
+    CHECK((pushes >= 1U) && (pushes <= 3U));
+    CheckCurrentTime(responseFrames[0]);
+
+    CHECK_EQUAL(TOPICPERIOD, SendSubscribe(GetCurrentTime, TOPICPERIOD, 0U));
+    CHECK_EQUAL(MGBTCOMMANDQUEUELENGTH, CountCurrentTimePushes());
+    CHECK_EQUAL(TIMEUPDATEMINPERIOD, SendSubscribe(GetCurrentTime, 1U, 0U));
+    CHECK_EQUAL(0U, SendSubscribe(GetCurrentTime, 0U, 0U));
+    CHECK_EQUAL(0U, CountCurrentTimePushes());
+    (void)SendSubscribe(UNKNOWNTOPIC, TOPICPERIOD, 0xFFFFU);
+    CHECK_EQUAL(0U, CountCurrentTimePushes());
+}
+
+static uint32_t GetResponseLong(uint16_t offset)
+{
+    uint32_t value;
+    memcpy(&value, &responseFrame[TXHEADERLENGTH + offset], sizeof(value));
+    return value;
+}
+
+//Returns the number of samples, the buckets have to add up to it and the longest one has to fall in the last bucket used.
+static uint32_t ReadPerfStats(uint8_t point)
+{
+    uint32_t samples;
+    uint32_t bucketTotal = 0U;
+    uint8_t lastBucket = 0U;
+    uint8_t bucket;
+
+    SendCommand(GetPerfStats, &point, sizeof(point), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CheckResponseCrc();
+    CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(PERFSTATSHEADERLENGTH + (2U * PROFILERBUCKETCOUNT), GetFrameWord(responseFrame, 0U));
+    CHECK_EQUAL(point, responseFrame[TXHEADERLENGTH]);
+    CHECK_EQUAL(NbOfProfilePoints, responseFrame[TXHEADERLENGTH + 1U]);
+    CHECK_EQUAL(PROFILERBUCKETCOUNT, responseFrame[TXHEADERLENGTH + 2U]);
+    CHECK_EQUAL(PROFILERCYCLESPER1US, responseFrame[TXHEADERLENGTH + 3U]);
+
+    samples = GetResponseLong(4U);
+    for(bucket = 0U; bucket < PROFILERBUCKETCOUNT; bucket++)
+    {
+        uint16_t count = GetFrameWord(responseFrame, (uint16_t)(TXHEADERLENGTH + PERFSTATSHEADERLENGTH + (2U * bucket)));
+        bucketTotal += count;
+        if(count > 0U)
+        {
+            lastBucket = bucket;
+        }
+    }
+    CHECK_EQUAL(samples, bucketTotal);
+    if((samples > 0U) && (lastBucket > 0U) && (lastBucket < (PROFILERBUCKETCOUNT - 1U)))
+    {
+        CHECK(GetResponseLong(8U) >= (1U << lastBucket));
+        CHECK(GetResponseLong(8U) < (2U << lastBucket));
+    }
+
+    return samples;
+}
+
+static void TestPerfStats(void)
+{
+    uint8_t point = NbOfProfilePoints;
+    uint32_t samples;
+
+    //The protocol runs every 10ms, the display task every ms.
+    samples = ReadPerfStats(ProfileTaskCommunication);
+    CHECK(samples > 100U);
+    CHECK(ReadPerfStats(ProfileTaskCommunication) < 5U);
+    CHECK(ReadPerfStats(ProfileTaskDisplay) > 0U);
+    CHECK(ReadPerfStats(ProfileTimerOverflow) > 0U);
+    //The tests before triggered the sensors.
+    CHECK(ReadPerfStats(ProfileStartStopSensor) > 0U);
+    CHECK(ReadPerfStats(ProfileSensorEntryLatency) > 0U);
+    CHECK_EQUAL(0U, ReadPerfStats(ProfileSensorEntryLatency));
+
+    SendCommand(GetPerfStats, &point, sizeof(point), 0U);
+    CHECK_EQUAL(1U, WaitForResponse());
+    CHECK_EQUAL(0xFFFFU, GetFrameWord(responseFrame, 4U));
+    CHECK_EQUAL(NbOfProfilePoints, responseFrame[TXHEADERLENGTH + 1U]);
+}
+
+//The first read covers the time since power up, the second one only the time since the first.
+static void TestSchedulerStats(void)
+{
+    uint8_t pass;
+
+    for(pass = 0U; pass < 2U; pass++)
+    {
+        uint16_t record = SCHEDULERSTATSHEADERLENGTH + (TaskDisplay * SCHEDULERSTATSRECORDLENGTH);
+        uint32_t period;
+
+        SendCommand(GetSchedulerStats, (const uint8_t*)0, 0U, 0U);
+        CHECK_EQUAL(1U, WaitForResponse());
+        CheckResponseCrc();
+        CHECK_EQUAL(0U, GetFrameWord(responseFrame, 4U));
+        CHECK_EQUAL(SCHEDULERSTATSHEADERLENGTH + (NbOfSchedulerTasks * SCHEDULERSTATSRECORDLENGTH),
+                    GetFrameWord(responseFrame, 0U));
+        CHECK_EQUAL(NbOfSchedulerTasks, responseFrame[TXHEADERLENGTH]);
+        CHECK(responseFrame[TXHEADERLENGTH + 1U] <= 100U);
+        period = GetResponseLong(2U);
+        //The display task runs every ms.
+        if(pass == 0U)
+        {
+            CHECK(period > 1000U);
+            CHECK(GetResponseLong(record) > 1000U);
+        }
+        else
+        {
+            CHECK(period < 100U);
+            CHECK(GetResponseLong(record) <= (period + 1U));
+        }
+        CHECK(GetResponseLong(record + 8U) >= GetResponseLong(record + 4U));
+    }
+}
+
+int main(void)
+{
+    SimInit(SIM_DEFAULT_BAUDRATE);
+    SimSetTxCallback(CollectTxByte);
+    //Commands are only handled once the jumpers have been read.
+    while(autoConfigurationDone == 0U)
+    {
+        SimStep(1U);
+    }
+    StepFor(SETTLESTEPS);
+
+    TestEchoAcrossRing();
+    TestIdentification();
+    TestBadCrc();
+    TestPipelined();
+    TestV2Identification();
+    TestV2LargeEcho();
+    TestV2Resync();
+    TestLinkSpeed();
+    TestLapsSince();
+    TestTimestampAcks();
+    TestSensorTraces();
+    TestTimeEventBatches();
+    TestReplayJournal();
+    TestSubscriptions();
+    TestPerfStats();
+    TestSchedulerStats();
+    TestLapTimesHeldBack();
+    //A v1 command switches the link back.
+    TestIdentification();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,121 @@
+/*
+ * MGBTCrcTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Checks that every CRC engine is bit-exact with the original nibble
+ *  implementation from MGBTCommProto.c, both over whole buffers and when
+ *  the data is fed in arbitrary pieces the way ReceiveData does.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "TestHelpers.h"
+#include "MGBTCrc.h"
+
+#define RANDOMBUFFERLENGTH 300U
+#define RANDOMROUNDS 200U
+
+//Verbatim copy of the calculateCRC the protocol used before the engines were split out.
+static uint16_t ReferenceCRC(const uint8_t* u8Buf, uint8_t len)
+{
+    static const uint16_t crctable[] =
+    {
+        0x0000, 0x1021, 0x2042, 0x3063,
+        0x4084, 0x50a5, 0x60c6, 0x70e7,
+        0x8108, 0x9129, 0xa14a, 0xb16b,
+        0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    };
+    uint16_t crc;
+    int i;
+
+    crc = 0xffff;
+
+    for (i = 0; i < len ; i++)
+    {
+        crc = ((crc << 4) | (u8Buf[i] >> 4)) ^ crctable[crc >> 12];
+        crc = ((crc << 4) | (u8Buf[i] & 0xf)) ^ crctable[crc >> 12];
+    }
+
+    return crc;
+}
+
+static void TestKnownVector(MGBTCrcEngine engine)
+{
+    const uint8_t digits[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+    MGBTCrcSetEngine(engine);
+    CHECK_EQUAL(engine, MGBTCrcGetEngine());
+    CHECK_EQUAL(0xA69DU, MGBTCrcCalculate(digits, sizeof(digits)));
+    CHECK_EQUAL(MGBTCRC_SEED, MGBTCrcCalculate(digits, 0U));
+}
+
+//The reference takes an 8 bit length, which is all the old protocol frames needed.
+static void TestAgainstReference(MGBTCrcEngine engine)
+{
+    uint8_t buffer[255];
+    uint16_t round;
+    uint16_t index;
+
+    MGBTCrcSetEngine(engine);
+    srand(1234U);
+
+    for(round = 0U; round < RANDOMROUNDS; round++)
+    {
+        uint8_t length = (uint8_t)(rand() % sizeof(buffer));
+        for(index = 0U; index < length; index++)
+        {
+            buffer[index] = (uint8_t)rand();
+        }
+        CHECK_EQUAL(ReferenceCRC(buffer, length), MGBTCrcCalculate(buffer, length));
+    }
+}
+
+static void TestIncremental(MGBTCrcEngine engine)
+{
+    uint8_t buffer[RANDOMBUFFERLENGTH];
+    uint16_t round;
+    uint16_t index;
+
+    MGBTCrcSetEngine(engine);
+    srand(5678U);
+
+    for(index = 0U; index < RANDOMBUFFERLENGTH; index++)
+    {
+        buffer[index] = (uint8_t)rand();
+    }
+
+    for(round = 0U; round < RANDOMROUNDS; round++)
+    {
+        uint16_t crc = MGBTCRC_SEED;
+        uint16_t position = 0U;
+
+        while(position < RANDOMBUFFERLENGTH)
+        {
+            uint16_t piece = (uint16_t)(rand() % 17);
+            if(piece > (RANDOMBUFFERLENGTH - position))
+            {
+                piece = RANDOMBUFFERLENGTH - position;
+            }
+            crc = MGBTCrcUpdate(crc, &buffer[position], piece);
+            position += piece;
+        }
+        CHECK_EQUAL(MGBTCrcCalculate(buffer, RANDOMBUFFERLENGTH), crc);
+    }
+}
+
+int main(void)
+{
+    const MGBTCrcEngine engines[2] = {MGBTCrcNibbleTable, MGBTCrcByteTable};
+    uint8_t index;
+
+    for(index = 0U; index < 2U; index++)
+    {
+        TestKnownVector(engines[index]);
+        TestAgainstReference(engines[index]);
+        TestIncremental(engines[index]);
+    }
+
+    return TEST_RESULT();
+}
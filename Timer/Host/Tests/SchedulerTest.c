@@ -0,0 +1,125 @@
+/*
+ * SchedulerTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Runs the scheduler on the simulated clock. Checks that every task runs
+ *  at its period without missing a deadline and that the core sleeps in
+ *  between, that a wake request runs a task early without moving its
+ *  period, that a main loop held up for longer than a deadline is counted
+ *  and that a reset starts the stats over.
+ */
+
+#include <stdint.h>
+
+#include "TestHelpers.h"
+#include "SimEngine.h"
+#include "Configuration.h"
+#include "Scheduler.h"
+
+#define STEPSPER1MS 10U
+#define RUNLENGTH1MS 1000U
+#define HOLDUPSTEPS 300U
+
+//Matches the task table in Scheduler.c
+static const uint32_t periods1ms[NbOfSchedulerTasks] = {10U, 100U, 100U, 1U, 10U, 1U};
+
+static void StepFor(uint32_t steps, uint32_t mainLoopIterations)
+{
+    uint32_t step;
+
+    for(step = 0U; step < steps; step++)
+    {
+        SimStep(mainLoopIterations);
+    }
+}
+
+static void TestPeriods(void)
+{
+    uint8_t task;
+
+    SchedulerResetStats();
+    StepFor(RUNLENGTH1MS * STEPSPER1MS, 1U);
+
+    CHECK_EQUAL(RUNLENGTH1MS, SchedulerGetStatsPeriod1ms());
+    //Tasks take no simulated time, only the interrupts keep the core awake.
+    CHECK(SchedulerGetIdlePercent() > 90U);
+    for(task = 0U; task < NbOfSchedulerTasks; task++)
+    {
+        SchedulerTaskStats stats;
+        uint32_t expectedRuns = RUNLENGTH1MS / periods1ms[task];
+
+        SchedulerGetTaskStats((SchedulerTask)task, &stats);
+        //The PPS wakes the status outputs once a second.
+        CHECK(stats.runCount >= expectedRuns);
+        CHECK(stats.runCount <= (expectedRuns + 1U));
+        CHECK_EQUAL(0U, stats.deadlineMisses);
+        CHECK(stats.maxLateness1us < 1000U);
+    }
+}
+
+static void TestWake(void)
+{
+    SchedulerTaskStats before;
+    SchedulerTaskStats after;
+
+    SchedulerResetStats();
+    SimStep(1U);
+    SchedulerGetTaskStats(TaskEventJournal, &before);
+
+    SchedulerWake(TaskEventJournal);
+    SimStep(1U);
+    SchedulerGetTaskStats(TaskEventJournal, &after);
+    CHECK_EQUAL(before.runCount + 1U, after.runCount);
+
+    //The periodic runs go on as before.
+    StepFor(periods1ms[TaskEventJournal] * STEPSPER1MS, 1U);
+    SchedulerGetTaskStats(TaskEventJournal, &after);
+    CHECK_EQUAL(before.runCount + 2U, after.runCount);
+    CHECK_EQUAL(0U, after.deadlineMisses);
+}
+
+//Steps without a main loop iteration stand in for a task that blocks the loop.
+static void TestHoldUp(void)
+{
+    SchedulerTaskStats stats;
+
+    SchedulerResetStats();
+    StepFor(HOLDUPSTEPS, 0U);
+    SimStep(1U);
+
+    //Due every ms with 2ms to spare, the runs missed in between are not made up.
+    SchedulerGetTaskStats(TaskRaceTiming, &stats);
+    CHECK_EQUAL(1U, stats.runCount);
+    CHECK_EQUAL(1U, stats.deadlineMisses);
+    CHECK(stats.maxLateness1us >= ((HOLDUPSTEPS / STEPSPER1MS) - 1U) * 1000U);
+    //Due every 10ms without spare time.
+    SchedulerGetTaskStats(TaskCommunication, &stats);
+    CHECK_EQUAL(1U, stats.deadlineMisses);
+    //Due every 100ms, the hold-up is well within its deadline.
+    SchedulerGetTaskStats(TaskEventJournal, &stats);
+    CHECK_EQUAL(0U, stats.deadlineMisses);
+
+    SchedulerResetStats();
+    SchedulerGetTaskStats(TaskRaceTiming, &stats);
+    CHECK_EQUAL(0U, stats.runCount);
+    CHECK_EQUAL(0U, stats.deadlineMisses);
+    CHECK_EQUAL(0U, stats.maxLateness1us);
+    CHECK_EQUAL(0U, SchedulerGetStatsPeriod1ms());
+}
+
+int main(void)
+{
+    SimInit(SIM_DEFAULT_BAUDRATE);
+    //Two tasks are held back until the jumpers have been read.
+    while(autoConfigurationDone == 0U)
+    {
+        SimStep(1U);
+    }
+
+    TestPeriods();
+    TestWake();
+    TestHoldUp();
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,115 @@
+/*
+ * SensorEventQueueTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Checks ordering and overflow accounting of the sensor event queue, then
+ *  lets a thread play the EXTI handler against a consuming main loop.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#include "TestHelpers.h"
+#include "SensorEventQueue.h"
+
+#define STRESSEVENTCOUNT 200000U
+
+static void TestOrderAndOverflow(void)
+{
+    SensorTimestamp event = {0};
+    uint32_t index;
+
+    for(index = 0U; index < (SENSOREVENTQUEUELENGTH + 3U); index++)
+    {
+        event.time1us = index;
+        SensorEventQueuePush(SensorInputStop, &event);
+    }
+
+    CHECK_EQUAL(SENSOREVENTQUEUELENGTH, SensorEventQueueGetCount(SensorInputStop));
+    CHECK_EQUAL(3U, SensorEventQueueGetOverflowCount(SensorInputStop));
+    CHECK_EQUAL(0U, SensorEventQueueGetCount(SensorInputStartStop));
+
+    for(index = 0U; index < SENSOREVENTQUEUELENGTH; index++)
+    {
+        CHECK_EQUAL(1U, SensorEventQueuePop(SensorInputStop, &event));
+        CHECK_EQUAL(index, event.time1us);
+    }
+
+    CHECK_EQUAL(0U, SensorEventQueuePop(SensorInputStop, &event));
+    CHECK_EQUAL(0U, SensorEventQueuePush(NbOfSensorInputs, &event));
+}
+
+static void* Producer(void* argument)
+{
+    volatile SensorTimestamp event = {0};
+    uint32_t sequence = 1U;
+    (void)argument;
+
+    while(sequence <= STRESSEVENTCOUNT)
+    {
+        event.timeStampPps = sequence;
+        event.ppsTime1us = (Timestamp1us)sequence * 3U;
+        event.time1us = (Timestamp1us)sequence * 7U;
+        if(SensorEventQueuePush(SensorInputStartStop, &event) == 1U)
+        {
+            sequence++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return (void*)0;
+}
+
+static void TestConcurrentProducer(void)
+{
+    pthread_t producer;
+    SensorTimestamp event;
+    uint32_t expected = 1U;
+    uint32_t inconsistent = 0U;
+    uint32_t outOfOrder = 0U;
+    uint32_t overflowBefore = SensorEventQueueGetOverflowCount(SensorInputStartStop);
+
+    pthread_create(&producer, (const pthread_attr_t*)0, Producer, (void*)0);
+
+    while(expected <= STRESSEVENTCOUNT)
+    {
+        if(SensorEventQueuePop(SensorInputStartStop, &event) == 1U)
+        {
+            if((event.ppsTime1us != ((Timestamp1us)event.timeStampPps * 3U)) ||
+               (event.time1us != ((Timestamp1us)event.timeStampPps * 7U)))
+            {
+                inconsistent++;
+            }
+            if(event.timeStampPps != expected)
+            {
+                outOfOrder++;
+            }
+            expected = event.timeStampPps + 1U;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    pthread_join(producer, (void**)0);
+
+    CHECK_EQUAL(0U, inconsistent);
+    CHECK_EQUAL(0U, outOfOrder);
+    CHECK_EQUAL(0U, SensorEventQueueGetCount(SensorInputStartStop));
+    //The producer retries on a full queue, every retry is counted.
+    CHECK(SensorEventQueueGetOverflowCount(SensorInputStartStop) >= overflowBefore);
+}
+
+int main(void)
+{
+    TestOrderAndOverflow();
+    TestConcurrentProducer();
+
+    return TEST_RESULT();
+}
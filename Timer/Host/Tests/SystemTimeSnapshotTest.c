@@ -0,0 +1,182 @@
+/*
+ * SystemTimeSnapshotTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  A thread runs the TIM2 counter with its overflow interrupt and the PPS
+ *  interrupt at full speed while the main thread takes snapshots and fires
+ *  the sensor handlers. PPS edges arrive on whole seconds, so every snapshot
+ *  has to satisfy ppsTime1us == timeStampPps * 1000000 and lie at most a
+ *  second after ppsTime1us, which holds between any two interrupts but not
+ *  for a torn copy. A full second is seen between the overflow and the PPS
+ *  interrupt of the same tick.
+ */
+
+#include <pthread.h>
+
+#include "TestHelpers.h"
+#include "stm32f1xx.h"
+#include "TimeMgmt.h"
+#include "SensorEventQueue.h"
+
+#define TICKSPERPPS 10000U
+#define TICKLENGTH1US 100U
+#define PPSPERIOD1US 1000000U
+#define STRESSTICKCOUNT 20000000U
+
+static uint8_t writerDone = 0U;
+static uint32_t currentTick = 0U;
+
+static uint8_t IsConsistent(SensorTimestamp* timeStamp)
+{
+    return ((timeStamp->ppsTime1us == ((Timestamp1us)timeStamp->timeStampPps * PPSPERIOD1US)) &&
+            (timeStamp->time1us >= timeStamp->ppsTime1us) &&
+            ((timeStamp->time1us - timeStamp->ppsTime1us) <= PPSPERIOD1US)) ? 1U : 0U;
+}
+
+static void AdvanceTick(void)
+{
+    uint32_t counter1us;
+
+    currentTick++;
+    counter1us = (currentTick * TICKLENGTH1US) % TIMERPERIOD1US;
+
+    if(counter1us == 0U)
+    {
+        //Like the hardware, the counter wraps and flags the update before the interrupt runs.
+        TIM2->SR |= TIM_SR_UIF;
+        TIM2->CNT = 0U;
+        HandleTimerOverflow();
+        TIM2->SR &= ~TIM_SR_UIF;
+    }
+    else
+    {
+        TIM2->CNT = counter1us;
+    }
+
+    if((currentTick % TICKSPERPPS) == 0U)
+    {
+        TIM2->CCR2 = counter1us;
+        TIM2->SR |= TIM_SR_CC2IF;
+        HandlePpsPulse();
+    }
+}
+
+static void* InterruptWriter(void* argument)
+{
+    (void)argument;
+
+    while(currentTick < STRESSTICKCOUNT)
+    {
+        AdvanceTick();
+    }
+
+    __atomic_store_n(&writerDone, 1U, __ATOMIC_RELEASE);
+    return (void*)0;
+}
+
+//An edge captured 2us before the counter wraps, with the handler running after the overflow.
+static void TestCaptureAcrossOverflow(void)
+{
+    SensorTimestamp event;
+    uint32_t edgeTick;
+
+    //Stay clear of the sensor debounce time and stop in the last tick of a timer period.
+    do
+    {
+        AdvanceTick();
+    } while((currentTick < (STRESSTICKCOUNT + (MIN_SENSOR_INTERRUPT_WAIT / TICKLENGTH1US))) ||
+            ((((currentTick + 1U) * TICKLENGTH1US) % TIMERPERIOD1US) != 0U));
+
+    edgeTick = currentTick;
+    TIM2->CCR4 = TIMERPERIOD1US - 2U;
+    TIM2->SR |= TIM_SR_CC4IF;
+    AdvanceTick();
+    TIM2->CNT = 1U;
+    HandleStopSensorTrigger();
+
+    CHECK_EQUAL(1U, SensorEventQueuePop(SensorInputStop, &event));
+    CHECK_EQUAL(((Timestamp1us)edgeTick * TICKLENGTH1US) + (TICKLENGTH1US - 2U), event.time1us);
+    CHECK_EQUAL(((Timestamp1us)edgeTick * TICKLENGTH1US) + (TICKLENGTH1US - 2U), GetPpsTimestamp1us(&event));
+}
+
+//The microsecond time passes 2^32 after 72 minutes, the millisecond time after 50 days.
+static void TestPastThirtyTwoBits(void)
+{
+    const uint32_t overflows = 100000U;
+    Timestamp1us before = GetSystemTime1us();
+    Timestamp1us after;
+    uint32_t index;
+
+    for(index = 0U; index < overflows; index++)
+    {
+        HandleTimerOverflow();
+    }
+
+    after = GetSystemTime1us();
+    CHECK_EQUAL((Timestamp1us)overflows * TIMERPERIOD1US, after - before);
+    CHECK(after > 0xFFFFFFFFU);
+    CHECK_EQUAL((uint32_t)(after / 1000U), GetSystemTimeStampMs());
+    CHECK_EQUAL((uint32_t)(after / 100U), GetSystemTimeStamp100us());
+}
+
+int main(void)
+{
+    pthread_t writer;
+    SensorTimestamp snapshot;
+    SensorTimestamp event;
+    Timestamp1us previous1us = 0U;
+    uint32_t snapshots = 0U;
+    uint32_t torn = 0U;
+    uint32_t backwards = 0U;
+    uint32_t events = 0U;
+    uint32_t tornEvents = 0U;
+
+    pthread_create(&writer, (const pthread_attr_t*)0, InterruptWriter, (void*)0);
+
+    while(__atomic_load_n(&writerDone, __ATOMIC_ACQUIRE) == 0U)
+    {
+        GetSystemTimeSnapshot(&snapshot);
+        snapshots++;
+
+        if(IsConsistent(&snapshot) == 0U)
+        {
+            torn++;
+        }
+        if(snapshot.time1us < previous1us)
+        {
+            backwards++;
+        }
+        previous1us = snapshot.time1us;
+
+        //The handler debounces, so most calls are dropped without queueing.
+        HandleStopSensorTrigger();
+        while(SensorEventQueuePop(SensorInputStop, &event) == 1U)
+        {
+            events++;
+            if(IsConsistent(&event) == 0U)
+            {
+                tornEvents++;
+            }
+        }
+    }
+
+    pthread_join(writer, (void**)0);
+
+    GetSystemTimeSnapshot(&snapshot);
+    CHECK_EQUAL((Timestamp1us)STRESSTICKCOUNT * TICKLENGTH1US, snapshot.time1us);
+    CHECK_EQUAL(STRESSTICKCOUNT / TICKSPERPPS, snapshot.timeStampPps);
+    CHECK_EQUAL(snapshot.time1us, snapshot.ppsTime1us);
+    CHECK(snapshots > 0U);
+    CHECK_EQUAL(0U, torn);
+    CHECK_EQUAL(0U, backwards);
+    CHECK(events > 0U);
+    CHECK_EQUAL(0U, tornEvents);
+
+    TestCaptureAcrossOverflow();
+    TestPastThirtyTwoBits();
+
+    printf("%u snapshots, %u sensor events\n", snapshots, events);
+
+    return TEST_RESULT();
+}
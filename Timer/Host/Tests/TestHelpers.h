@@ -0,0 +1,41 @@
+/*
+ * TestHelpers.h
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Minimal assertion helpers for the host tests. A test executable returns
+ *  a non-zero exit code when any check failed.
+ */
+
+#ifndef HOST_TESTS_TESTHELPERS_H_
+#define HOST_TESTS_TESTHELPERS_H_
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while(0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do \
+    { \
+        unsigned long long expectedValue = (unsigned long long)(expected); \
+        unsigned long long actualValue = (unsigned long long)(actual); \
+        if(expectedValue != actualValue) \
+        { \
+            printf("%s:%d: expected %llu, got %llu (%s)\n", __FILE__, __LINE__, expectedValue, actualValue, #actual); \
+            testFailures++; \
+        } \
+    } while(0)
+
+#define TEST_RESULT() ((testFailures == 0) ? 0 : 1)
+
+#endif /* HOST_TESTS_TESTHELPERS_H_ */
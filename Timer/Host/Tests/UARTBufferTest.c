@@ -0,0 +1,296 @@
+/*
+ * UARTBufferTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *
+ *  Feeds bytes into the simulated USART1 and checks that the DMA reception
+ *  publishes them at the end of a burst (idle line), at the half and full
+ *  transfer points of the ring, and that the data survives wrapping. A
+ *  reader that falls a ring behind is told about the overrun. Then
+ *  checks that DMA transmission runs without main loop help, picks up data
+ *  queued while a transfer is busy, that a frame is only complete once its
+ *  last byte has left the USART, and that the transmit ring takes whole
+ *  frames across its end or refuses them without side effects.
+ */
+
+#include <stdint.h>
+
+#include "TestHelpers.h"
+#include "SimEngine.h"
+#include "UARTBuffer.h"
+
+#define STREAMLENGTH 1000U
+//Reading 60 bytes every 60 steps is slower than the 69 bytes that arrive at 115200 baud.
+//The reader falls behind by less than the ring size, so reads start anywhere and straddle its end.
+#define READCHUNK 60U
+#define READINTERVAL 60U
+
+#define SENTBYTESLENGTH UART_BUFFER_SIZE
+#define RINGFRAMELENGTH 50U
+#define RINGFRAMECOUNT ((UART_BUFFER_SIZE - 1U) / RINGFRAMELENGTH)
+
+static uint8_t sentBytes[SENTBYTESLENGTH];
+static uint32_t sentCount = 0U;
+
+static void CollectTxByte(uint8_t uart, uint8_t byte)
+{
+    if((uart == 0U) && (sentCount < SENTBYTESLENGTH))
+    {
+        sentBytes[sentCount] = byte;
+    }
+    sentCount++;
+}
+
+static void StepUntilReceived(uint64_t bytes)
+{
+    SimCounters counters;
+    do
+    {
+        SimStep(0U);
+        SimGetCounters(&counters);
+    } while(counters.rxBytes[0] < bytes);
+}
+
+//A short burst only becomes visible once the line has been idle for a frame.
+static void TestIdleLine(UARTBuffer* buffer)
+{
+    const uint8_t burst[10] = {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U, 10U};
+    uint8_t received[10] = {0};
+    uint8_t index;
+    uint8_t step;
+
+    CHECK_EQUAL(1U, SimUartInject(0U, burst, sizeof(burst)));
+    StepUntilReceived(sizeof(burst));
+    CHECK_EQUAL(0U, UARTBufferHasNewData(buffer));
+
+    for(step = 0U; step < 2U; step++)
+    {
+        SimStep(0U);
+    }
+    CHECK_EQUAL(sizeof(burst), UARTBufferHasNewData(buffer));
+
+    UARTBufferGetData(buffer, received, sizeof(received));
+    for(index = 0U; index < sizeof(burst); index++)
+    {
+        CHECK_EQUAL(burst[index], received[index]);
+    }
+    CHECK_EQUAL(0U, UARTBufferHasNewData(buffer));
+}
+
+//A continuous stream has no idle time, so it is published at the half and full transfer points.
+static void TestContinuousStream(UARTBuffer* buffer)
+{
+    static uint8_t stream[STREAMLENGTH];
+    uint8_t received[READCHUNK];
+    uint32_t index;
+    uint32_t readBytes = 0U;
+    uint32_t mismatches = 0U;
+    uint32_t step = 0U;
+    SimCounters counters;
+
+    for(index = 0U; index < STREAMLENGTH; index++)
+    {
+        stream[index] = (uint8_t)((index * 7U) + 3U);
+    }
+    CHECK_EQUAL(1U, SimUartInject(0U, stream, STREAMLENGTH));
+
+    while(readBytes < STREAMLENGTH)
+    {
+        uint16_t available;
+        SimStep(0U);
+        step++;
+        if((step % READINTERVAL) != 0U)
+        {
+            continue;
+        }
+        available = UARTBufferHasNewData(buffer);
+        if(available > READCHUNK)
+        {
+            available = READCHUNK;
+        }
+        UARTBufferGetData(buffer, received, available);
+        for(index = 0U; index < available; index++)
+        {
+            if(received[index] != stream[readBytes + index])
+            {
+                mismatches++;
+            }
+        }
+        readBytes += available;
+    }
+
+    CHECK_EQUAL(0U, mismatches);
+    SimGetCounters(&counters);
+    CHECK_EQUAL(0U, counters.rxOverruns[0]);
+    //Half and full transfer interrupts every 128 bytes plus one idle interrupt per burst.
+    CHECK_EQUAL(((10U + STREAMLENGTH) / (UART_BUFFER_SIZE / 2U)) + 2U, counters.rxInterrupts[0]);
+}
+
+//Nothing is read while a ring full arrives. The overrun shows before the DMA controller gets to the
+//unread bytes and is gone once the ring has been cleared.
+static void TestRxOverrun(UARTBuffer* buffer)
+{
+    static uint8_t stream[UART_BUFFER_SIZE];
+    SimCounters counters;
+    uint32_t index;
+
+    for(index = 0U; index < UART_BUFFER_SIZE; index++)
+    {
+        stream[index] = (uint8_t)index;
+    }
+    SimGetCounters(&counters);
+    CHECK_EQUAL(0U, UARTBufferRxOverrun(buffer));
+    CHECK_EQUAL(1U, SimUartInject(0U, stream, UART_BUFFER_SIZE));
+    StepUntilReceived(counters.rxBytes[0] + UART_BUFFER_SIZE - UART_RX_GUARD);
+    CHECK_EQUAL(0U, UARTBufferRxOverrun(buffer));
+    StepUntilReceived(counters.rxBytes[0] + UART_BUFFER_SIZE - UART_RX_GUARD + 1U);
+    CHECK_EQUAL(1U, UARTBufferRxOverrun(buffer));
+    StepUntilReceived(counters.rxBytes[0] + UART_BUFFER_SIZE);
+    SimStep(0U);
+    SimStep(0U);
+    CHECK_EQUAL(1U, UARTBufferRxOverrun(buffer));
+
+    UARTBufferClear(buffer);
+    CHECK_EQUAL(0U, UARTBufferRxOverrun(buffer));
+    CHECK_EQUAL(0U, UARTBufferHasNewData(buffer));
+}
+
+static void TestTransmission(UARTBuffer* buffer)
+{
+    uint8_t frame[136];
+    uint8_t index;
+    uint32_t step = 0U;
+    SimCounters counters;
+
+    for(index = 0U; index < sizeof(frame); index++)
+    {
+        frame[index] = (uint8_t)(index ^ 0x5AU);
+    }
+
+    SimSetTxCallback(CollectTxByte);
+    UARTBufferSendData(buffer, frame, 100U);
+    CHECK_EQUAL(0U, UARTBufferTxBufferEmpty(buffer));
+
+    //Queue the rest while the first transfer is running, no main loop passes in between.
+    SimStep(0U);
+    UARTBufferSendData(buffer, &frame[100], sizeof(frame) - 100U);
+
+    while((UARTBufferTxBufferEmpty(buffer) == 0U) && (step < 1000U))
+    {
+        SimStep(0U);
+        step++;
+    }
+    //Let the last bytes leave the data and shift registers.
+    for(index = 0U; index < 3U; index++)
+    {
+        SimStep(0U);
+    }
+
+    CHECK_EQUAL(1U, UARTBufferTxBufferEmpty(buffer));
+    CHECK_EQUAL(sizeof(frame), sentCount);
+    for(index = 0U; index < sizeof(frame); index++)
+    {
+        CHECK_EQUAL(frame[index], sentBytes[index]);
+    }
+    SimGetCounters(&counters);
+    CHECK_EQUAL(2U, counters.txInterrupts[0]);
+    //The model moves at most one byte per 100us step, so 136 bytes take at least 136 steps.
+    CHECK(step < (sizeof(frame) + 5U));
+}
+
+static void StepUntilSent(UARTBuffer* buffer)
+{
+    uint32_t step = 0U;
+    while((UARTBufferTxBufferEmpty(buffer) == 0U) && (step < 10000U))
+    {
+        SimStep(0U);
+        step++;
+    }
+    for(step = 0U; step < 3U; step++)
+    {
+        SimStep(0U);
+    }
+}
+
+//TC is still set from the last transfer. The frame only counts as sent once its last byte is out,
+//a baud rate switch right then would garble it.
+static void TestTxComplete(UARTBuffer* buffer)
+{
+    uint8_t frame[20] = {0};
+    uint32_t step = 0U;
+
+    sentCount = 0U;
+    CHECK_EQUAL(1U, UARTBufferTxComplete(buffer));
+    UARTBufferSendData(buffer, frame, sizeof(frame));
+    while((UARTBufferTxComplete(buffer) == 0U) && (step < 1000U))
+    {
+        CHECK(sentCount < sizeof(frame));
+        SimStep(0U);
+        step++;
+    }
+    CHECK_EQUAL(sizeof(frame), sentCount);
+}
+
+//Starts where TestTransmission left the write position, so the queued frames wrap around the ring end.
+static void TestTxRing(UARTBuffer* buffer)
+{
+    uint8_t frame[RINGFRAMELENGTH];
+    uint8_t frameCount = 0U;
+    uint16_t index;
+    uint16_t freeSpace;
+    uint32_t mismatches = 0U;
+
+    sentCount = 0U;
+    CHECK_EQUAL(UART_BUFFER_SIZE - 1U, UARTBufferGetTxFreeSpace(buffer));
+
+    do
+    {
+        for(index = 0U; index < RINGFRAMELENGTH; index++)
+        {
+            frame[index] = (uint8_t)((frameCount * RINGFRAMELENGTH) + index);
+        }
+        freeSpace = UARTBufferGetTxFreeSpace(buffer);
+        if(UARTBufferSendData(buffer, frame, RINGFRAMELENGTH) == 1U)
+        {
+            CHECK_EQUAL(freeSpace - RINGFRAMELENGTH, UARTBufferGetTxFreeSpace(buffer));
+            frameCount++;
+        }
+        else
+        {
+            //A frame that does not fit is not queued at all.
+            CHECK_EQUAL(freeSpace, UARTBufferGetTxFreeSpace(buffer));
+            break;
+        }
+    } while(frameCount <= RINGFRAMECOUNT);
+
+    CHECK_EQUAL(RINGFRAMECOUNT, frameCount);
+
+    StepUntilSent(buffer);
+    CHECK_EQUAL(frameCount * RINGFRAMELENGTH, sentCount);
+    for(index = 0U; index < (frameCount * RINGFRAMELENGTH); index++)
+    {
+        if(sentBytes[index] != (uint8_t)index)
+        {
+            mismatches++;
+        }
+    }
+    CHECK_EQUAL(0U, mismatches);
+    CHECK_EQUAL(UART_BUFFER_SIZE - 1U, UARTBufferGetTxFreeSpace(buffer));
+}
+
+int main(void)
+{
+    UARTBuffer* buffer;
+
+    SimInit(SIM_DEFAULT_BAUDRATE);
+    buffer = UARTBufferGetUART(0U);
+
+    TestIdleLine(buffer);
+    TestContinuousStream(buffer);
+    TestRxOverrun(buffer);
+    TestTransmission(buffer);
+    TestTxComplete(buffer);
+    TestTxRing(buffer);
+
+    return TEST_RESULT();
+}